@@ -111,6 +111,21 @@ static inline uint64_t Atomic_IncrementUInt64 (volatile atomic_uint64_t *atomic)
 {
 	return InterlockedIncrement64 ((volatile LONG64 *)&atomic->value) - 1;
 }
+
+static inline uint64_t Atomic_AddUInt64 (volatile atomic_uint64_t *atomic, uint64_t value)
+{
+	return InterlockedExchangeAdd64 ((volatile LONG64 *)&atomic->value, value);
+}
+
+static inline uint64_t Atomic_SubUInt64 (volatile atomic_uint64_t *atomic, uint64_t value)
+{
+	return InterlockedExchangeAdd64 ((volatile LONG64 *)&atomic->value, -(LONG64)value);
+}
+
+static inline void Atomic_ThreadFence (void)
+{
+	MemoryBarrier ();
+}
 #else
 typedef _Atomic uint8_t atomic_uint8_t;
 
@@ -172,6 +187,21 @@ static inline uint64_t Atomic_IncrementUInt64 (atomic_uint64_t *atomic)
 {
 	return atomic_fetch_add (atomic, 1);
 }
+
+static inline uint64_t Atomic_AddUInt64 (atomic_uint64_t *atomic, uint64_t value)
+{
+	return atomic_fetch_add (atomic, value);
+}
+
+static inline uint64_t Atomic_SubUInt64 (atomic_uint64_t *atomic, uint64_t value)
+{
+	return atomic_fetch_sub (atomic, value);
+}
+
+static inline void Atomic_ThreadFence (void)
+{
+	atomic_thread_fence (memory_order_seq_cst);
+}
 #endif
 
 #endif
@@ -23,6 +23,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 static void CL_FinishTimeDemo (void);
 
+static uint64_t td_startallocs; // Mem_GetAllocCount at td_starttime
+
 /*
 ==============================================================================
 
@@ -101,7 +103,10 @@ static int CL_GetDemoMessage (void)
 			// if this is the second frame, grab the real td_starttime
 			// so the bogus time on the first frame doesn't count
 			if (host_framecount == cls.td_startframe + 1)
+			{
 				cls.td_starttime = realtime;
+				td_startallocs = Mem_GetAllocCount ();
+			}
 		}
 		else if (/* cl.time > 0 && */ cl.time <= cl.mtime[0])
 		{
@@ -616,6 +621,7 @@ static void CL_FinishTimeDemo (void)
 	if (!time)
 		time = 1;
 	Con_Printf ("%i frames %5.1f seconds %5.1f fps\n", frames, time, frames / time);
+	Mem_PrintBenchmarkStats (td_startallocs, frames);
 }
 
 /*
@@ -91,12 +91,15 @@ void CL_ClearTrailStates (void)
 void CL_FreeState (void)
 {
 	int i;
+
+	Host_WaitForCSQCPhysics ();
 	for (i = 0; i < MAX_CL_STATS; i++)
 		Mem_Free (cl.statss[i]);
 	PR_ClearProgs (&cl.qcvm);
 	for (i = 0; i < cl.max_edicts; ++i)
 		SDL_DestroyMutex (cl.entities[i].lightcache.mutex);
 	Mem_Free (cl.entities);
+	Mem_Free (cl.activeentities);
 	for (i = 0; i < cl.num_statics; ++i)
 		SDL_DestroyMutex (cl.static_entities[i]->lightcache.mutex);
 	for (i = 0; i < cl.num_statics; i += 64)
@@ -135,7 +138,8 @@ void CL_ClearState (void)
 
 	// johnfitz -- cl_entities is now dynamically allocated
 	cl.max_edicts = CLAMP (MIN_EDICTS, (int)max_edicts.value, MAX_EDICTS);
-	cl.entities = (entity_t *)Mem_Alloc (cl.max_edicts * sizeof (entity_t));
+	cl.entities = (entity_t *)Mem_AllocTagged (cl.max_edicts * sizeof (entity_t), MEMTAG_EDICT);
+	cl.activeentities = (int *)Mem_AllocTagged (cl.max_edicts * sizeof (int), MEMTAG_EDICT);
 	// johnfitz
 	for (int i = 0; i < cl.max_edicts; ++i)
 		cl.entities[i].lightcache.mutex = SDL_CreateMutex ();
@@ -650,6 +654,41 @@ static void RT_OffsetFromCamera (vec3_t out_position, float offset_right, float
 	}
 }
 
+/*
+===============
+CL_EntityUpdated
+
+Called by the parser once an entity's state from a server update is final
+===============
+*/
+void CL_EntityUpdated (int num, entity_t *ent)
+{
+	ent->atrest = VectorCompare (ent->msg_origins[0], ent->msg_origins[1]) && VectorCompare (ent->msg_angles[0], ent->msg_angles[1]);
+
+	if (num > 0 && !ent->activeslot && ent->model)
+	{
+		cl.activeentities[cl.numactiveentities++] = num;
+		ent->activeslot = cl.numactiveentities;
+	}
+}
+
+/*
+===============
+CL_RemoveActiveEntity
+===============
+*/
+static void CL_RemoveActiveEntity (int slot)
+{
+	const int last = cl.activeentities[--cl.numactiveentities];
+
+	cl.entities[cl.activeentities[slot]].activeslot = 0;
+	if (slot < cl.numactiveentities)
+	{
+		cl.activeentities[slot] = last;
+		cl.entities[last].activeslot = slot + 1;
+	}
+}
+
 /*
 ===============
 CL_RelinkEntities
@@ -658,7 +697,7 @@ CL_RelinkEntities
 void CL_RelinkEntities (void)
 {
 	entity_t *ent;
-	int       i, j;
+	int       i, j, k;
 	float     frac, d;
 	float     bobjrotate;
 	vec3_t    oldorg;
@@ -678,7 +717,7 @@ void CL_RelinkEntities (void)
 	if (cl_numvisedicts + 64 > cl_maxvisedicts)
 	{
 		cl_maxvisedicts = cl_maxvisedicts + 64;
-		cl_visedicts = Mem_Realloc (cl_visedicts, sizeof (*cl_visedicts) * cl_maxvisedicts);
+		cl_visedicts = Mem_ReallocTagged (cl_visedicts, sizeof (*cl_visedicts) * cl_maxvisedicts, MEMTAG_EDICT);
 	}
 	cl_numvisedicts = 0;
 
@@ -704,10 +743,12 @@ void CL_RelinkEntities (void)
 
 	bobjrotate = anglemod (100 * cl.time);
 
-	// start on the entity after the world
-	ent = (cl.entities != NULL) ? (cl.entities + 1) : NULL;
-	for (i = 1; i < cl.num_entities; i++, ent++)
+	// only the slots the parser gave a model, empty ones drop out of the list until they get one again
+	for (k = 0; k < cl.numactiveentities; k++)
 	{
+		i = cl.activeentities[k];
+		ent = &cl.entities[i];
+
 		if (!ent->model)
 		{ // empty slot, ish.
 
@@ -715,6 +756,7 @@ void CL_RelinkEntities (void)
 			// ent can't be static, so this is a no-op.
 			// if (ent->forcelink)
 			//	R_RemoveEfrags (ent);	// just became empty
+			CL_RemoveActiveEntity (k--);
 			continue;
 		}
 		ent->eflags = ent->netstate.eflags;
@@ -725,12 +767,18 @@ void CL_RelinkEntities (void)
 			ent->model = NULL;
 			ent->lerpflags |= LERP_RESETMOVE | LERP_RESETANIM; // johnfitz -- next time this entity slot is reused, the lerp will need to be reset
 			InvalidateTraceLineCache ();
+			CL_RemoveActiveEntity (k--);
 			continue;
 		}
 
 		VectorCopy (ent->origin, oldorg);
 
-		if (CL_LerpEntity (ent, ent->origin, ent->angles, frac))
+		if (ent->atrest)
+		{ // nothing moved between the last two updates, whatever frac is
+			VectorCopy (ent->msg_origins[0], ent->origin);
+			VectorCopy (ent->msg_angles[0], ent->angles);
+		}
+		else if (CL_LerpEntity (ent, ent->origin, ent->angles, frac))
 			ent->lerpflags |= LERP_RESETMOVE;
 
 		if (ent->netstate.tagentity)
@@ -0,0 +1,340 @@
+/*
+ * cl_null.c -- client, renderer, sound and input stubs for the dedicated server build
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+The server, QC VM, world, network and filesystem code reference client and
+renderer symbols, almost always behind a cls.state != ca_dedicated or
+!isDedicated check. This file satisfies those references so that the
+vkquake-dedicated target (built with SERVERONLY) links without SDL video,
+audio, Vulkan or RTGL1. Anything that is reachable on a dedicated server
+behaves the way the full binary does under -dedicated.
+*/
+
+#include "quakedef.h"
+
+#ifndef SERVERONLY
+#error "cl_null.c is only part of the dedicated server build"
+#endif
+
+client_static_t cls;
+client_state_t  cl;
+cvar_t          cl_name = {"_cl_name", "player", CVAR_ARCHIVE};
+cvar_t          cl_color = {"_cl_color", "0", CVAR_ARCHIVE};
+cvar_t          cl_startdemos = {"cl_startdemos", "1", CVAR_ARCHIVE};
+kbutton_t       in_mlook;
+
+viddef_t        vid;
+modestate_t     modestate = MS_UNINIT;
+vulkanglobals_t vulkan_globals;
+vec3_t          vup, vpn, vright, r_origin;
+int             glwidth, glheight;
+int             clearnotify;
+qboolean        scr_disabled_for_loading;
+qboolean        in_update_screen;
+float           scr_centertime_off;
+cvar_t          scr_sbarscale = {"scr_sbarscale", "1", CVAR_ARCHIVE};
+gltexture_t    *char_texture;
+qpic_t         *pic_ovr, *pic_ins;
+unsigned int    d_8to24table[256];
+int             fragsort[MAX_SCOREBOARD];
+int             scoreboardlines;
+
+char           key_lines[CMDLINES][MAXCMDLINE];
+int            key_linepos;
+int            key_insert;
+double         key_blinktime;
+int            edit_line;
+int            history_line;
+keydest_t      key_dest;
+qboolean       keydown[MAX_KEYS];
+qboolean       chat_team;
+enum m_state_e m_state;
+enum m_state_e m_return_state;
+qboolean       m_return_onerror;
+char           m_return_reason[32];
+
+// same defaults as the real definitions, and like on a -dedicated server they are never registered
+cvar_t r_nolerp_list = {
+	"r_nolerp_list",
+	"progs/flame.mdl,progs/flame2.mdl,progs/braztall.mdl,progs/brazshrt.mdl,progs/longtrch.mdl,progs/flame_pyre.mdl,progs/v_saw.mdl,progs/"
+	"v_xfist.mdl,progs/h2stuff/newfire.mdl",
+	CVAR_NONE};
+cvar_t rt_enable_pvs = {"rt_enable_pvs", "0", CVAR_ARCHIVE};
+cvar_t rt_brush_metal = {"rt_brush_metal", "0.0", CVAR_ARCHIVE};
+cvar_t rt_brush_rough = {"rt_brush_rough", "1.0", CVAR_ARCHIVE};
+cvar_t rt_model_metal = {"rt_model_metal", "0.0", CVAR_ARCHIVE};
+cvar_t rt_model_rough = {"rt_model_rough", "1.0", CVAR_ARCHIVE};
+
+// registered by PScript_InitParticles and read by the server QC extensions
+cvar_t r_fteparticles = {"r_fteparticles", "1", CVAR_ARCHIVE};
+cvar_t r_particledesc = {"r_particledesc", "classic"};
+int    r_trace_line_cache_counter;
+
+/*
+==============================================================================
+
+CLIENT
+
+==============================================================================
+*/
+
+void CL_Init (void) {}
+void CL_FreeState (void) {}
+void CL_Disconnect (void) {}
+
+void CL_Disconnect_f (void)
+{
+	if (sv.active)
+		Host_ShutdownServer (false);
+}
+
+void CL_EstablishConnection (const char *host) {}
+void CL_NextDemo (void) {}
+void CL_StopPlayback (void) {}
+void CL_AccumulateCmd (void) {}
+void CL_SendCmd (void) {}
+
+int CL_ReadFromServer (void)
+{
+	return 0;
+}
+
+void CL_DecayLights (void) {}
+void CL_RunParticles (void) {}
+
+dlight_t *CL_AllocDlight (int key)
+{
+	static dlight_t dummy;
+	memset (&dummy, 0, sizeof (dummy));
+	return &dummy;
+}
+
+void CL_UpdateBeam (struct qmodel_s *m, const char *trailname, const char *impactname, int ent, float *start, float *end) {}
+void Chase_Init (void) {}
+void V_Init (void) {}
+
+float V_CalcRoll (vec3_t angles, vec3_t velocity)
+{
+	return 0; // cl_rollangle is never registered on a dedicated server, so it is always 0
+}
+
+void Sbar_Init (void) {}
+void M_Init (void) {}
+void M_NewGame (void) {}
+void M_Menu_Main_f (void) {}
+void M_Menu_Quit_f (void) {}
+
+/*
+==============================================================================
+
+INPUT
+
+==============================================================================
+*/
+
+void IN_Init (void) {}
+void IN_Shutdown (void) {}
+void IN_Commands (void) {}
+void IN_SendKeyEvents (void) {}
+void IN_UpdateInputMode (void) {}
+void IN_Activate (void) {}
+void IN_Deactivate (qboolean free_cursor) {}
+void Key_Init (void) {}
+void Key_UpdateForDest (void) {}
+void Key_WriteBindings (FILE *f) {}
+void Key_BeginInputGrab (void) {}
+void Key_EndInputGrab (void) {}
+
+void Key_GetGrabbedInput (int *lastkey, int *lastchar)
+{
+	if (lastkey)
+		*lastkey = 0;
+	if (lastchar)
+		*lastchar = 0;
+}
+
+const char *Key_GetChatBuffer (void)
+{
+	return "";
+}
+
+int Key_GetChatMsgLen (void)
+{
+	return 0;
+}
+
+void History_Shutdown (void) {}
+
+/*
+==============================================================================
+
+SOUND
+
+==============================================================================
+*/
+
+void S_Init (void) {}
+void S_Shutdown (void) {}
+void S_ClearAll (void) {}
+void S_Update (vec3_t origin, vec3_t forward, vec3_t right, vec3_t up) {}
+void S_LocalSound (const char *name) {}
+void S_StartSound (int entnum, int entchannel, sfx_t *sfx, vec3_t origin, float fvol, float attenuation) {}
+
+sfx_t *S_PrecacheSound (const char *sample)
+{
+	return NULL;
+}
+
+void S_PrintCacheStats (void) {}
+
+qboolean BGM_Init (void)
+{
+	return false;
+}
+
+void BGM_Shutdown (void) {}
+void BGM_Update (void) {}
+
+/*
+==============================================================================
+
+VIDEO AND RENDERER
+
+==============================================================================
+*/
+
+void VID_Init (void) {}
+void VID_Shutdown (void) {}
+void VID_Lock (void) {}
+
+qboolean VID_HasMouseOrInputFocus (void)
+{
+	return false;
+}
+
+qboolean VID_IsMinimized (void)
+{
+	return false;
+}
+
+void PL_ErrorDialog (const char *text) {}
+
+void SCR_Init (void) {}
+void SCR_UpdateScreen (qboolean use_tasks) {}
+void SCR_BeginLoadingPlaque (void) {}
+void SCR_EndLoadingPlaque (void) {}
+
+void W_LoadWadFile (void) {}
+void Draw_Init (void) {}
+void Draw_NewGame (void) {}
+void GL_SetCanvas (cb_context_t *cbx, canvastype newcanvas) {}
+void Draw_Character (cb_context_t *cbx, int x, int y, int num) {}
+void Draw_String (cb_context_t *cbx, int x, int y, const char *str) {}
+void Draw_Pic (cb_context_t *cbx, int x, int y, qpic_t *pic, float alpha, qboolean alpha_blend) {}
+void Draw_SubPic (cb_context_t *cbx, float x, float y, float w, float h, qpic_t *pic, float s1, float t1, float s2, float t2, float *rgb, float alpha) {}
+void Draw_ConsoleBackground (cb_context_t *cbx) {}
+
+qpic_t *Draw_PicFromWad2 (const char *name, unsigned int texflags)
+{
+	return NULL;
+}
+
+qpic_t *Draw_TryCachePic (const char *path, unsigned int texflags)
+{
+	return NULL;
+}
+
+void TexMgr_Init (void) {}
+void TexMgr_NewGame (void) {}
+void TexMgr_FreeTexturesForOwner (qmodel_t *owner) {}
+void TexMgr_RT_SpecialStart (float default_rough, float default_metallic) {}
+void TexMgr_RT_SpecialEnd (void) {}
+
+gltexture_t *TexMgr_LoadImage (
+	const char *rtname, qmodel_t *owner, const char *name, int width, int height, enum srcformat format, byte *data, const char *source_file,
+	src_offset_t source_offset, unsigned flags)
+{
+	return NULL;
+}
+
+byte *Image_LoadImage (const char *name, int *width, int *height)
+{
+	return NULL;
+}
+
+void Sky_ClearAll (void) {}
+void Sky_LoadTexture (qmodel_t *mod, texture_t *mt, int tex_index) {}
+void Sky_LoadTextureQ64 (qmodel_t *mod, texture_t *mt, int tex_index) {}
+
+// the server only needs the bounds computed by Mod_LoadAliasModel, not the meshes
+void GL_MakeAliasModelDisplayLists (qmodel_t *m, aliashdr_t *hdr) {}
+void GLMesh_DeleteVertexBuffers (void) {}
+void R_FreeChainCaches (texture_t *t) {}
+
+void R_Init (void) {}
+void R_NewGame (void) {}
+void R_RunParticleEffect (vec3_t org, vec3_t dir, int color, int count) {}
+void R_ParticleExplosion (vec3_t org) {}
+void R_BlobExplosion (vec3_t org) {}
+
+int R_LightPoint (vec3_t p, lightcache_t *cache, vec3_t *lightcolor)
+{
+	VectorCopy (vec3_origin, *lightcolor);
+	return 0;
+}
+
+void PScript_InitParticles (void)
+{
+	Cvar_RegisterVariable (&r_fteparticles);
+	Cvar_RegisterVariable (&r_particledesc);
+}
+
+void PScript_UpdateModelEffects (qmodel_t *mod) {}
+
+int PScript_FindParticleType (const char *fullname)
+{
+	return -1;
+}
+
+// these return non-zero when the effect could not be run
+int PScript_RunParticleEffectTypeString (vec3_t org, vec3_t dir, float count, const char *name)
+{
+	return 1;
+}
+
+int PScript_RunParticleEffectState (vec3_t org, vec3_t dir, float count, int typenum, struct trailstate_s **tsk)
+{
+	return 1;
+}
+
+int PScript_ParticleTrail (vec3_t startpos, vec3_t end, int type, float timeinterval, int dlkey, vec3_t axis[3], struct trailstate_s **tsk)
+{
+	return 1;
+}
+
+// CSQC 2D drawing goes straight to RTGL1
+RgResult rgUploadRasterizedGeometry (RgInstance rgInstance, const RgRasterizedGeometryUploadInfo *pUploadInfo, const float *pViewProjection, const RgViewport *pViewport)
+{
+	return RG_SUCCESS;
+}
+
+const char *rgGetResultDescription (RgResult result)
+{
+	return "";
+}
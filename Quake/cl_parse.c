@@ -551,6 +551,8 @@ static void CL_EntitiesDeltaed (void)
 			VectorCopy (ent->msg_angles[0], ent->angles);
 			ent->forcelink = true;
 		}
+
+		CL_EntityUpdated (newnum, ent);
 	}
 }
 
@@ -1010,9 +1012,15 @@ static void CL_ParseServerInfo (void)
 	// copy the naked name of the map file to the cl structure -- O.S
 	COM_StripExtension (COM_SkipPath (model_precache[1]), cl.mapname, sizeof (cl.mapname));
 
+	if (nummodels > 1)
+	{
+		const char *names[MAX_MODELS];
+		for (i = 1; i < nummodels; i++)
+			names[i - 1] = model_precache[i];
+		Mod_ForNames (names, &cl.model_precache[1], nummodels - 1, false);
+	}
 	for (i = 1; i < nummodels; i++)
 	{
-		cl.model_precache[i] = Mod_ForName (model_precache[i], false);
 		if (cl.model_precache[i] == NULL)
 		{
 			Host_Error ("Model %s not found", model_precache[i]);
@@ -1277,6 +1285,8 @@ static void CL_ParseUpdate (int bits)
 		VectorCopy (ent->msg_angles[0], ent->angles);
 		ent->forcelink = true;
 	}
+
+	CL_EntityUpdated (num, ent);
 }
 
 /*
@@ -1468,8 +1478,8 @@ static void CL_ParseStatic (int version) // johnfitz -- added a parameter
 	if (i >= cl.max_static_entities)
 	{
 		int        ec = 64;
-		entity_t **newstatics = Mem_Realloc (cl.static_entities, sizeof (*newstatics) * (cl.max_static_entities + ec));
-		entity_t  *newents = Mem_Alloc (sizeof (*newents) * ec);
+		entity_t **newstatics = Mem_ReallocTagged (cl.static_entities, sizeof (*newstatics) * (cl.max_static_entities + ec), MEMTAG_EDICT);
+		entity_t  *newents = Mem_AllocTagged (sizeof (*newents) * ec, MEMTAG_EDICT);
 		if (!newstatics || !newents)
 			Host_Error ("Too many static entities");
 		for (int j = 0; j < ec; ++j)
@@ -2114,6 +2124,7 @@ void CL_ParseServerMessage (void)
 				Host_Error ("Received svcfte_cgamepacket but extension not active");
 			if (cl.qcvm.extfuncs.CSQC_Parse_Event)
 			{
+				Host_WaitForCSQCPhysics ();
 				PR_SwitchQCVM (&cl.qcvm);
 				PR_ExecuteProgram (cl.qcvm.extfuncs.CSQC_Parse_Event);
 				PR_SwitchQCVM (NULL);
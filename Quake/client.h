@@ -231,6 +231,8 @@ typedef struct
 	entity_t *entities; // spike -- moved into here
 	int       max_edicts;
 	int       num_entities;
+	int      *activeentities; // indices of the entities with a model, the only ones CL_RelinkEntities visits
+	int       numactiveentities;
 
 	entity_t **static_entities; // spike -- was static
 	int        max_static_entities;
@@ -331,6 +333,7 @@ dlight_t *CL_AllocDlight (int key);
 void      CL_DecayLights (void);
 
 void CL_RelinkEntities (void);
+void CL_EntityUpdated (int num, entity_t *ent);
 
 void CL_Init (void);
 
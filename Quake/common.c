@@ -1493,6 +1493,14 @@ typedef struct
 
 #define MAX_FILES_IN_PACK 2048
 
+// shared by the pack and the views into it, so views outlive a game change
+struct pakmapping_s
+{
+	const byte     *base;
+	size_t          size;
+	atomic_uint32_t refcount;
+};
+
 char             com_gamenames[1024]; // eg: "hipnotic;quoth;warp" ... no id1
 char             com_gamedir[MAX_OSPATH];
 char             com_basedir[MAX_OSPATH];
@@ -1595,9 +1603,11 @@ Finds the file in the search path.
 Sets com_filesize and one of handle or file
 If neither of file or handle is set, this
 can be used for detecting a file's presence.
+If view is set and the file is in a mapped pak,
+the view is filled in instead of the handle.
 ===========
 */
-static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigned int *path_id)
+static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigned int *path_id, fileview_t *view)
 {
 	searchpath_t *search;
 	char          netpath[MAX_OSPATH];
@@ -1626,6 +1636,14 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 				file_from_pak = 1;
 				if (path_id)
 					*path_id = search->path_id;
+				if (view && pak->mapping && (size_t)pak->files[i].filepos + com_filesize <= pak->mapping->size)
+				{
+					view->data = pak->mapping->base + pak->files[i].filepos;
+					view->size = com_filesize;
+					view->mapping = pak->mapping;
+					Atomic_IncrementUInt32 (&pak->mapping->refcount);
+					return com_filesize;
+				}
 				if (handle)
 				{
 					*handle = pak->handle;
@@ -1703,7 +1721,7 @@ Returns whether the file is found in the quake filesystem.
 */
 qboolean COM_FileExists (const char *filename, unsigned int *path_id)
 {
-	int ret = COM_FindFile (filename, NULL, NULL, path_id);
+	int ret = COM_FindFile (filename, NULL, NULL, path_id, NULL);
 	return (ret == -1) ? false : true;
 }
 
@@ -1718,7 +1736,7 @@ it may actually be inside a pak file
 */
 int COM_OpenFile (const char *filename, int *handle, unsigned int *path_id)
 {
-	return COM_FindFile (filename, handle, NULL, path_id);
+	return COM_FindFile (filename, handle, NULL, path_id, NULL);
 }
 
 /*
@@ -1731,7 +1749,7 @@ into the file.
 */
 int COM_FOpenFile (const char *filename, FILE **file, unsigned int *path_id)
 {
-	return COM_FindFile (filename, NULL, file, path_id);
+	return COM_FindFile (filename, NULL, file, path_id, NULL);
 }
 
 /*
@@ -1752,6 +1770,125 @@ void COM_CloseFile (int h)
 	Sys_FileClose (h);
 }
 
+/*
+============
+COM_ReleasePakMapping
+============
+*/
+static void COM_ReleasePakMapping (pakmapping_t *mapping)
+{
+	if (mapping && Atomic_DecrementUInt32 (&mapping->refcount) == 1)
+	{
+		Sys_FileUnmap (mapping->base, mapping->size);
+		Mem_Free (mapping);
+	}
+}
+
+/*
+============
+COM_MapFile
+
+Files in a mapped pak are returned without a copy, others are read into a buffer.
+The fallback reads through a private FILE rather than the shared pak handle, so
+this can be called from worker tasks.
+============
+*/
+qboolean COM_MapFile (const char *path, unsigned int *path_id, fileview_t *view)
+{
+	FILE *f = NULL;
+	int   len;
+	byte *buf;
+
+	memset (view, 0, sizeof (*view));
+
+	len = COM_FindFile (path, NULL, &f, path_id, view);
+	if (view->mapping)
+		return true;
+	if (!f)
+		return false;
+
+	buf = (byte *)Mem_Alloc (len + 1);
+	if (!buf)
+		Sys_Error ("COM_MapFile: not enough space for %s", path);
+
+	if (fread (buf, 1, len, f) != (size_t)len)
+		Con_Printf ("COM_MapFile: short read on %s\n", path);
+	fclose (f);
+
+	view->data = buf;
+	view->size = len;
+	return true;
+}
+
+/*
+============
+COM_FileStamp
+
+Safe to call from worker tasks, a loose file is opened through a private FILE
+============
+*/
+qboolean COM_FileStamp (const char *filename, filestamp_t *stamp)
+{
+	searchpath_t *search;
+	char          netpath[MAX_OSPATH];
+	pack_t       *pak;
+	int           i, findtime;
+	FILE         *f;
+
+	memset (stamp, 0, sizeof (*stamp));
+
+	for (search = com_searchpaths; search; search = search->next)
+	{
+		if (search->pack)
+		{
+			pak = search->pack;
+			for (i = 0; i < pak->numfiles; i++)
+			{
+				if (strcmp (pak->files[i].name, filename) != 0)
+					continue;
+				stamp->path_id = search->path_id;
+				stamp->size = pak->files[i].filelen;
+				stamp->stamp = pak->files[i].filepos;
+				return true;
+			}
+		}
+		else
+		{
+			if (!registered.value && (strchr (filename, '/') || strchr (filename, '\\')))
+				continue;
+
+			q_snprintf (netpath, sizeof (netpath), "%s/%s", search->filename, filename);
+			findtime = Sys_FileTime (netpath);
+			if (findtime == -1)
+				continue;
+
+			f = fopen (netpath, "rb");
+			stamp->path_id = search->path_id;
+			stamp->size = f ? COM_filelength (f) : -1;
+			stamp->stamp = findtime;
+			if (f)
+				fclose (f);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+============
+COM_UnmapFile
+============
+*/
+void COM_UnmapFile (fileview_t *view)
+{
+	if (view->mapping)
+		COM_ReleasePakMapping (view->mapping);
+	else
+		Mem_Free ((void *)view->data);
+	memset (view, 0, sizeof (*view));
+}
+
 /*
 ============
 COM_LoadFile
@@ -1762,30 +1899,22 @@ Allways appends a 0 byte.
 */
 byte *COM_LoadFile (const char *path, unsigned int *path_id)
 {
-	int   h;
-	byte *buf;
-	char  base[32];
-	int   len;
-
-	buf = NULL; // quiet compiler warning
+	fileview_t view;
+	byte      *buf;
 
-	// look for it in the filesystem or pack files
-	len = COM_OpenFile (path, &h, path_id);
-	if (h == -1)
+	if (!COM_MapFile (path, path_id, &view))
 		return NULL;
 
-	// extract the filename base name for hunk tag
-	COM_FileBase (path, base, sizeof (base));
-
-	buf = (byte *)Mem_Alloc (len + 1);
+	// buffers read by COM_MapFile are already terminated
+	if (!view.mapping)
+		return (byte *)view.data;
 
+	buf = (byte *)Mem_Alloc (view.size + 1);
 	if (!buf)
 		Sys_Error ("COM_LoadFile: not enough space for %s", path);
 
-	((byte *)buf)[len] = 0;
-
-	Sys_FileRead (h, buf, len);
-	COM_CloseFile (h);
+	memcpy (buf, view.data, view.size);
+	COM_UnmapFile (&view);
 
 	return buf;
 }
@@ -1923,6 +2052,16 @@ static pack_t *COM_LoadPackFile (const char *packfile)
 	pack->numfiles = numpackfiles;
 	pack->files = newfiles;
 
+	size_t      mapped_size;
+	const void *mapped = Sys_FileMap (packhandle, &mapped_size);
+	if (mapped)
+	{
+		pack->mapping = (pakmapping_t *)Mem_Alloc (sizeof (pakmapping_t));
+		pack->mapping->base = (const byte *)mapped;
+		pack->mapping->size = mapped_size;
+		Atomic_StoreUInt32 (&pack->mapping->refcount, 1);
+	}
+
 	// Sys_Printf ("Added packfile %s (%i files)\n", packfile, numpackfiles);
 	return pack;
 }
@@ -2083,6 +2222,7 @@ void COM_ResetGameDirectories (const char *newdirs)
 		if (com_searchpaths->pack)
 		{
 			Sys_FileClose (com_searchpaths->pack->handle);
+			COM_ReleasePakMapping (com_searchpaths->pack->mapping);
 			Mem_Free (com_searchpaths->pack->files);
 			Mem_Free (com_searchpaths->pack);
 		}
@@ -250,12 +250,15 @@ typedef struct
 	int  filepos, filelen;
 } packfile_t;
 
+typedef struct pakmapping_s pakmapping_t;
+
 typedef struct pack_s
 {
-	char        filename[MAX_OSPATH];
-	int         handle;
-	int         numfiles;
-	packfile_t *files;
+	char          filename[MAX_OSPATH];
+	int           handle;
+	int           numfiles;
+	packfile_t   *files;
+	pakmapping_t *mapping; // NULL if the pak couldn't be mapped
 } pack_t;
 
 typedef struct searchpath_s
@@ -289,6 +292,30 @@ void     COM_CloseFile (int h);
 
 byte *COM_LoadFile (const char *path, unsigned int *path_id);
 
+// Read-only view of a file. Files in a mapped pak point into the mapping and are not
+// copied, other files are loaded into a buffer. The view stays valid until COM_UnmapFile,
+// even if the pak is closed by a game change in the meantime. Not '\0'-terminated.
+typedef struct
+{
+	const byte   *data;
+	int           size;
+	pakmapping_t *mapping; // NULL if data is a copy owned by the view
+} fileview_t;
+
+qboolean COM_MapFile (const char *path, unsigned int *path_id, fileview_t *view);
+void     COM_UnmapFile (fileview_t *view);
+
+// Identifies the version of a file found in the search paths, so that data loaded from it
+// can be kept across map changes and still be reloaded when the file is replaced.
+typedef struct
+{
+	unsigned int path_id;
+	int          size;
+	int          stamp; // offset in the pak, or modification time of a loose file
+} filestamp_t;
+
+qboolean COM_FileStamp (const char *filename, filestamp_t *stamp);
+
 // Opens the given path directly, ignoring search paths.
 // Returns NULL on failure, or else a '\0'-terminated malloc'ed buffer.
 // Loads in "t" mode so CRLF to LF translation is performed on Windows.
@@ -475,6 +475,244 @@ void Con_DebugLog (const char *msg)
 		return; // Nonsense to supress warning
 }
 
+/*
+==============================================================================
+
+LOG SINK
+
+Con_Printf hands its text to a lock-free multi-producer ring and a background
+thread writes it to stdout and the -condebug log in batches, collapsing runs of
+identical lines. The pieces of a message take consecutive slots so messages from
+different threads never interleave. A full ring makes producers wait rather than
+drop text. -synclog keeps the old synchronous behaviour.
+
+==============================================================================
+*/
+
+#define LOG_SLOT_SIZE  256
+#define LOG_RING_SIZE  2048 // must be a power of two
+#define LOG_LINE_SIZE  1024
+#define LOG_BATCH_SIZE 65536
+#define LOG_IDLE_MSEC  500 // repeat counts and unterminated lines are written after this long without new text
+
+typedef struct
+{
+	atomic_uint64_t sequence; // the ticket allowed to write the slot, that ticket + 1 once it holds text
+	int             length;
+	char            text[LOG_SLOT_SIZE];
+} logslot_t;
+
+static logslot_t      *log_ring;
+static atomic_uint64_t log_head;
+static atomic_uint32_t log_running;
+static SDL_sem        *log_sem;
+static SDL_Thread     *log_thread;
+
+// consumer state, only touched with log_drain_mutex held
+static SDL_mutex *log_drain_mutex;
+static uint64_t   log_tail;
+static char       log_line[LOG_LINE_SIZE];
+static int        log_line_length;
+static char       log_last_line[LOG_LINE_SIZE];
+static int        log_last_line_length;
+static int        log_repeats;
+static char       log_batch[LOG_BATCH_SIZE + 1];
+static int        log_batch_length;
+
+/*
+================
+Log_WriteBatch
+================
+*/
+static void Log_WriteBatch (void)
+{
+	char chunk[1000];
+
+	if (!log_batch_length)
+		return;
+
+	// Sys_Printf formats into a fixed size buffer on some platforms
+	for (int i = 0; i < log_batch_length; i += sizeof (chunk) - 1)
+	{
+		const int length = q_min (log_batch_length - i, (int)sizeof (chunk) - 1);
+		memcpy (chunk, log_batch + i, length);
+		chunk[length] = 0;
+		Sys_Printf ("%s", chunk);
+	}
+
+	if (con_debuglog)
+	{
+		log_batch[log_batch_length] = 0;
+		Con_DebugLog (log_batch);
+	}
+	log_batch_length = 0;
+}
+
+/*
+================
+Log_Append
+================
+*/
+static void Log_Append (const char *text, int length)
+{
+	if (log_batch_length + length > LOG_BATCH_SIZE)
+		Log_WriteBatch ();
+	memcpy (log_batch + log_batch_length, text, length);
+	log_batch_length += length;
+}
+
+/*
+================
+Log_WriteRepeats
+================
+*/
+static void Log_WriteRepeats (void)
+{
+	char msg[64];
+
+	if (!log_repeats)
+		return;
+	q_snprintf (msg, sizeof (msg), "(last message repeated %d times)\n", log_repeats);
+	Log_Append (msg, strlen (msg));
+	log_repeats = 0;
+}
+
+/*
+================
+Log_WriteLine
+
+Writes the line collected so far, complete lines equal to the previous one are only counted
+================
+*/
+static void Log_WriteLine (qboolean complete)
+{
+	if (complete && log_line_length == log_last_line_length && !memcmp (log_line, log_last_line, log_line_length))
+		++log_repeats;
+	else
+	{
+		Log_WriteRepeats ();
+		Log_Append (log_line, log_line_length);
+		memcpy (log_last_line, log_line, log_line_length);
+		log_last_line_length = complete ? log_line_length : 0;
+	}
+	log_line_length = 0;
+}
+
+/*
+================
+Log_Drain
+
+Consumes all the text that has been fully written to the ring
+================
+*/
+static void Log_Drain (void)
+{
+	for (;;)
+	{
+		logslot_t *slot = &log_ring[log_tail & (LOG_RING_SIZE - 1)];
+		if (Atomic_LoadUInt64 (&slot->sequence) != log_tail + 1)
+			break;
+
+		for (int i = 0; i < slot->length; ++i)
+		{
+			log_line[log_line_length++] = slot->text[i];
+			if (slot->text[i] == '\n')
+				Log_WriteLine (true);
+			else if (log_line_length == LOG_LINE_SIZE)
+				Log_WriteLine (false);
+		}
+
+		Atomic_StoreUInt64 (&slot->sequence, log_tail + LOG_RING_SIZE);
+		++log_tail;
+	}
+}
+
+/*
+================
+Log_Thread
+================
+*/
+static int Log_Thread (void *unused)
+{
+	while (Atomic_LoadUInt32 (&log_running))
+	{
+		const qboolean idle = SDL_SemWaitTimeout (log_sem, LOG_IDLE_MSEC) == SDL_MUTEX_TIMEDOUT;
+
+		SDL_LockMutex (log_drain_mutex);
+		Log_Drain ();
+		if (idle)
+		{
+			Log_WriteRepeats ();
+			if (log_line_length)
+				Log_WriteLine (false);
+		}
+		Log_WriteBatch ();
+		SDL_UnlockMutex (log_drain_mutex);
+	}
+	return 0;
+}
+
+/*
+================
+Log_Print
+================
+*/
+static void Log_Print (const char *msg)
+{
+	const int length = strlen (msg);
+	uint64_t  ticket;
+	int       count;
+
+	if (!Atomic_LoadUInt32 (&log_running))
+	{
+		Sys_Printf ("%s", msg);
+		if (con_debuglog)
+			Con_DebugLog (msg);
+		return;
+	}
+
+	if (!length)
+		return;
+
+	count = (length + LOG_SLOT_SIZE - 1) / LOG_SLOT_SIZE;
+	ticket = Atomic_AddUInt64 (&log_head, count);
+	for (int i = 0; i < count; ++i, ++ticket)
+	{
+		logslot_t *slot = &log_ring[ticket & (LOG_RING_SIZE - 1)];
+
+		// the ring is full until the consumer has freed this slot
+		while (Atomic_LoadUInt64 (&slot->sequence) != ticket)
+			SDL_Delay (1);
+
+		slot->length = q_min (length - i * LOG_SLOT_SIZE, LOG_SLOT_SIZE);
+		memcpy (slot->text, msg + i * LOG_SLOT_SIZE, slot->length);
+		Atomic_StoreUInt64 (&slot->sequence, ticket + 1);
+	}
+	SDL_SemPost (log_sem);
+}
+
+/*
+================
+LOG_Flush
+
+Writes out everything queued so far, called before Sys_Error exits
+================
+*/
+void LOG_Flush (void)
+{
+	if (!log_ring)
+		return;
+
+	SDL_LockMutex (log_drain_mutex);
+	Log_Drain ();
+	Log_WriteRepeats ();
+	if (log_line_length)
+		Log_WriteLine (false);
+	Log_WriteBatch ();
+	SDL_UnlockMutex (log_drain_mutex);
+	fflush (stdout);
+}
+
 /*
 ================
 Con_Printf
@@ -495,12 +733,8 @@ void Con_Printf (const char *fmt, ...)
 
 	if (con_redirect_flush)
 		q_strlcat (con_redirect_buffer, msg, sizeof (con_redirect_buffer));
-	// also echo to debugging console
-	Sys_Printf ("%s", msg);
-
-	// log all messages to file
-	if (con_debuglog)
-		Con_DebugLog (msg);
+	// also echo to debugging console and log all messages to file
+	Log_Print (msg);
 
 	if (!con_initialized)
 		return;
@@ -1275,30 +1509,52 @@ void LOG_Init (quakeparms_t *parms)
 	time_t inittime;
 	char   session[24];
 
-	if (!COM_CheckParm ("-condebug"))
-		return;
+	if (COM_CheckParm ("-condebug"))
+	{
+		inittime = time (NULL);
+		strftime (session, sizeof (session), "%m/%d/%Y %H:%M:%S", localtime (&inittime));
+		q_snprintf (logfilename, sizeof (logfilename), "%s/qconsole.log", parms->basedir);
 
-	inittime = time (NULL);
-	strftime (session, sizeof (session), "%m/%d/%Y %H:%M:%S", localtime (&inittime));
-	q_snprintf (logfilename, sizeof (logfilename), "%s/qconsole.log", parms->basedir);
+		//	unlink (logfilename);
 
-	//	unlink (logfilename);
+		log_fd = open (logfilename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+		if (log_fd == -1)
+			fprintf (stderr, "Error: Unable to create log file %s\n", logfilename);
+		else
+		{
+			con_debuglog = true;
+			Con_DebugLog (va ("LOG started on: %s \n", session));
+		}
+	}
 
-	log_fd = open (logfilename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
-	if (log_fd == -1)
-	{
-		fprintf (stderr, "Error: Unable to create log file %s\n", logfilename);
+	if (COM_CheckParm ("-synclog"))
 		return;
-	}
 
-	con_debuglog = true;
-	Con_DebugLog (va ("LOG started on: %s \n", session));
+	log_ring = (logslot_t *)Mem_Alloc (LOG_RING_SIZE * sizeof (logslot_t));
+	for (int i = 0; i < LOG_RING_SIZE; ++i)
+		Atomic_StoreUInt64 (&log_ring[i].sequence, i);
+	log_sem = SDL_CreateSemaphore (0);
+	log_drain_mutex = SDL_CreateMutex ();
+	Atomic_StoreUInt32 (&log_running, 1);
+	log_thread = SDL_CreateThread (Log_Thread, "Log_Thread", NULL);
+	if (!log_thread)
+		Atomic_StoreUInt32 (&log_running, 0);
 }
 
 void LOG_Close (void)
 {
+	if (log_thread)
+	{
+		Atomic_StoreUInt32 (&log_running, 0);
+		SDL_SemPost (log_sem);
+		SDL_WaitThread (log_thread, NULL);
+		log_thread = NULL;
+		LOG_Flush ();
+	}
+
 	if (log_fd == -1)
 		return;
+	con_debuglog = false;
 	close (log_fd);
 	log_fd = -1;
 }
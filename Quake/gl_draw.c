@@ -211,33 +211,39 @@ qpic_t *Draw_PicFromWad2 (const char *name, unsigned int texflags)
 	}
 	if (info->type != TYP_QPIC)
 		Sys_Error ("Draw_PicFromWad: lump \"%s\" is not a qpic", name);
-	if (info->size < (int)(sizeof (int) * 2) || sizeof (int) * 2 + p->width * p->height > (size_t)info->size)
+	if (info->size < (int)(sizeof (int) * 2))
 		Sys_Error ("Draw_PicFromWad: pic \"%s\" truncated", name);
-	if (p->width < 0 || p->height < 0)
-		Sys_Error ("Draw_PicFromWad: bad size (%dx%d) for pic \"%s\"", p->width, p->height, name);
+
+	// the wad is read-only, so the header isn't swapped in place
+	const int width = LittleLong (p->width);
+	const int height = LittleLong (p->height);
+	if (sizeof (int) * 2 + width * height > (size_t)info->size)
+		Sys_Error ("Draw_PicFromWad: pic \"%s\" truncated", name);
+	if (width < 0 || height < 0)
+		Sys_Error ("Draw_PicFromWad: bad size (%dx%d) for pic \"%s\"", width, height, name);
 
 	// load little ones into the scrap
-	if (p->width < 64 && p->height < 64)
+	if (width < 64 && height < 64)
 	{
 		int   x = 0, y = 0;
 		int   j, k;
 		int   texnum;
 		byte *data = p->data;
 
-		texnum = Scrap_AllocBlock (p->width, p->height, &x, &y);
+		texnum = Scrap_AllocBlock (width, height, &x, &y);
 		scrap_dirty = true;
 		k = 0;
-		for (i = 0; i < p->height; i++)
+		for (i = 0; i < height; i++)
 		{
-			for (j = 0; j < p->width; j++, k++)
+			for (j = 0; j < width; j++, k++)
 				scrap_texels[texnum][(y + i) * BLOCK_WIDTH + x + j] = data[k];
 		}
 		gl.gltexture = scrap_textures[texnum]; // johnfitz -- changed to an array
 		// johnfitz -- no longer go from 0.01 to 0.99
 		gl.sl = x / (float)BLOCK_WIDTH;
-		gl.sh = (x + p->width) / (float)BLOCK_WIDTH;
+		gl.sh = (x + width) / (float)BLOCK_WIDTH;
 		gl.tl = y / (float)BLOCK_WIDTH;
-		gl.th = (y + p->height) / (float)BLOCK_WIDTH;
+		gl.th = (y + height) / (float)BLOCK_WIDTH;
 	}
 	else
 	{
@@ -249,7 +255,7 @@ qpic_t *Draw_PicFromWad2 (const char *name, unsigned int texflags)
 
 		offset = (src_offset_t)p - (src_offset_t)wad_base + sizeof (int) * 2; // johnfitz
 
-		gl.gltexture = TexMgr_LoadImage (rtname, NULL, texturename, p->width, p->height, SRC_INDEXED, p->data, WADFILENAME, offset, texflags); // johnfitz -- TexMgr
+		gl.gltexture = TexMgr_LoadImage (rtname, NULL, texturename, width, height, SRC_INDEXED, p->data, WADFILENAME, offset, texflags); // johnfitz -- TexMgr
 		gl.sl = 0;
 		gl.sh = 1;
 		gl.tl = 0;
@@ -258,7 +264,8 @@ qpic_t *Draw_PicFromWad2 (const char *name, unsigned int texflags)
 
 	menu_numcachepics++;
 	strcpy (pic->name, name);
-	pic->pic = *p;
+	pic->pic.width = width;
+	pic->pic.height = height;
 	memcpy (pic->pic.data, &gl, sizeof (glpic_t));
 
 	return &pic->pic;
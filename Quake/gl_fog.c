@@ -239,6 +239,18 @@ void Fog_GetColor (float *c)
 		c[i] = (float)(Q_rint (c[i] * 255)) / 255.0f;
 }
 
+/*
+=============
+Fog_IsFading
+
+true while a "fog" command with a fade time is still blending towards its target
+=============
+*/
+qboolean Fog_IsFading (void)
+{
+	return fade_done > cl.time;
+}
+
 /*
 =============
 Fog_GetDensity
@@ -67,7 +67,7 @@ const uint32_t *RT_GetFanIndices (int vertexcount)
 		}
 
 		fan_indices_count = GetNextStep (count, FANINDEX_ALLOC_STEP);
-		fan_indices = Mem_Alloc (sizeof (uint32_t) * fan_indices_count);
+		fan_indices = Mem_AllocTagged (sizeof (uint32_t) * fan_indices_count, MEMTAG_RT);
 
 		assert (fan_indices_count % 3 == 0);
 
@@ -104,7 +104,7 @@ void *RT_AllocScratchMemory (size_t bytecount)
 		}
 
 		scratch_bytes_count = GetNextStep64 (scratch_bytes_count + bytecount, SCRATCH_ALLOC_STEP);
-		scratch_bytes = Mem_Alloc (scratch_bytes_count);
+		scratch_bytes = Mem_AllocTagged (scratch_bytes_count, MEMTAG_RT);
 	}
 
 	return scratch_bytes;
@@ -33,26 +33,27 @@ ALIAS MODEL DISPLAY LIST GENERATION
 =================================================================
 */
 
-qmodel_t   *aliasmodel;
-aliashdr_t *paliashdr;
+// per thread, alias models can be meshed by the model loading tasks
+static THREAD_LOCAL qmodel_t   *aliasmodel;
+static THREAD_LOCAL aliashdr_t *paliashdr;
 
-int used[8192]; // qboolean
+static THREAD_LOCAL int used[8192]; // qboolean
 
 // the command list holds counts and s/t values that are valid for
 // every frame
-int commands[8192];
-int numcommands;
+static THREAD_LOCAL int commands[8192];
+static THREAD_LOCAL int numcommands;
 
 // all frames will have their vertexes rearranged and expanded
 // so they are in the order expected by the command list
-int vertexorder[8192];
-int numorder;
+static THREAD_LOCAL int vertexorder[8192];
+static THREAD_LOCAL int numorder;
 
-int allverts, alltris;
+static THREAD_LOCAL int allverts, alltris;
 
-int stripverts[128];
-int striptris[128];
-int stripcount;
+static THREAD_LOCAL int stripverts[128];
+static THREAD_LOCAL int striptris[128];
+static THREAD_LOCAL int stripcount;
 
 /*
 ================
@@ -433,9 +434,6 @@ void GL_MakeAliasModelDisplayLists_VBO (void)
 	GLMesh_LoadVertexBuffer (aliasmodel, pheader);
 }
 
-#define NUMVERTEXNORMALS 162
-extern float r_avertexnormals[NUMVERTEXNORMALS][3];
-
 /*
 ================
 GLMesh_DeleteVertexBuffer
@@ -443,11 +441,8 @@ GLMesh_DeleteVertexBuffer
 */
 static void GLMesh_DeleteVertexBuffer (qmodel_t *m)
 {
-	if (m->rtvertices != NULL)
-	{
-	    Mem_Free (m->rtvertices);
-	    m->rtvertices = NULL;
-	}
+	SAFE_FREE (m->rtposes);
+	SAFE_FREE (m->rttexcoords);
 
 	if (m->rtindices != NULL)
 	{
@@ -503,38 +498,23 @@ static void GLMesh_LoadVertexBuffer (qmodel_t *m, const aliashdr_t *hdr)
 		}
 	}
 
-	// create the vertex buffer (empty)
+	// texCoord is same in all poses
+	m->rttexcoords = Mem_Alloc (hdr->numverts_vbo * 2 * sizeof (float));
+	for (int v = 0; v < hdr->numverts_vbo; v++)
 	{
-		size_t sz = hdr->numposes * (hdr->numverts_vbo * sizeof (RgVertex));
-
-		m->rtvertices = Mem_Alloc (sz);
-		memset (m->rtvertices, 0, sz);
+		m->rttexcoords[v * 2 + 0] = ((float)desc[v].st[0] + 0.5f) / (float)hdr->skinwidth;
+		m->rttexcoords[v * 2 + 1] = ((float)desc[v].st[1] + 0.5f) / (float)hdr->skinheight;
 	}
 
-	// fill in the vertices at the start of the buffer
+	// keep the poses quantized, only reordered to vbo vertex order so that GetPoseVertices can decode them linearly
+	m->rtposes = Mem_Alloc ((size_t)hdr->numposes * hdr->numverts_vbo * sizeof (trivertx_t));
 	for (size_t f = 0; f < (size_t)hdr->numposes; f++) // ericw -- what RMQEngine called nummeshframes is called numposes in QuakeSpasm
 	{
-		RgVertex *dstpose = m->rtvertices + (hdr->numverts_vbo * f);
+		trivertx_t       *dstpose = m->rtposes + (hdr->numverts_vbo * f);
 		const trivertx_t *srctv = trivertexes + (hdr->numverts * f);
 
 		for (int v = 0; v < hdr->numverts_vbo; v++)
-		{
-			trivertx_t trivert = srctv[desc[v].vertindex];
-
-			dstpose[v].position[0] = trivert.v[0];
-			dstpose[v].position[1] = trivert.v[1];
-			dstpose[v].position[2] = trivert.v[2];
-			
-			dstpose[v].normal[0] = r_avertexnormals[trivert.lightnormalindex][0];
-			dstpose[v].normal[1] = r_avertexnormals[trivert.lightnormalindex][1];
-			dstpose[v].normal[2] = r_avertexnormals[trivert.lightnormalindex][2];
-
-			// texCoord is same in all poses
-			dstpose[v].texCoord[0] = ((float)desc[v].st[0] + 0.5f) / (float)hdr->skinwidth;
-			dstpose[v].texCoord[1] = ((float)desc[v].st[1] + 0.5f) / (float)hdr->skinheight;
-
-			dstpose[v].packedColor = RT_PACKED_COLOR_WHITE;
-		}
+			dstpose[v] = srctv[desc[v].vertindex];
 	}
 }
 
@@ -33,6 +33,7 @@ static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash);
 
 cvar_t external_ents = {"external_ents", "1", CVAR_ARCHIVE};
 cvar_t external_vis = {"external_vis", "1", CVAR_ARCHIVE};
+cvar_t mod_cachesize = {"mod_cachesize", "256", CVAR_ARCHIVE}; // MB of alias and sprite model files kept across map changes
 
 static byte *mod_novis;
 static int   mod_novis_capacity;
@@ -44,6 +45,13 @@ static int   mod_decompressed_capacity;
 qmodel_t mod_known[MAX_MOD_KNOWN];
 int      mod_numknown;
 
+// alias and sprite models survive Mod_ClearAll, least recently used first out once over mod_cachesize
+static int mod_cacheseq = 1;
+static int mod_cachehits, mod_cachemisses, mod_cachestale, mod_cacheevicted;
+
+// every server instance releases its own models, a model is freed once no instance uses it
+static THREAD_LOCAL uint64_t mod_owner = 1;
+
 texture_t *r_notexture_mip;  // johnfitz -- moved here from r_main.c
 texture_t *r_notexture_mip2; // johnfitz -- used for non-lightmapped surfs with a missing texture
 
@@ -100,6 +108,7 @@ void Mod_Init (void)
 {
 	Cvar_RegisterVariable (&external_vis);
 	Cvar_RegisterVariable (&external_ents);
+	Cvar_RegisterVariable (&mod_cachesize);
 
 	// johnfitz -- create notexture miptex
 	r_notexture_mip = (texture_t *)Mem_Alloc (sizeof (texture_t));
@@ -295,11 +304,16 @@ static void Mod_FreeModelMemory (qmodel_t *mod)
 			Mod_FreeSpriteMemory ((msprite_t *)mod->extradata);
 		// Last two ones are dummy textures
 		for (int i = 0; i < mod->numtextures - 2; ++i)
+		{
+			if (mod->textures[i])
+				R_FreeChainCaches (mod->textures[i]);
 			SAFE_FREE (mod->textures[i]);
+		}
 		for (int i = 0; i < mod->numsurfaces; ++i)
 			SAFE_FREE (mod->surfaces[i].polys);
 		SAFE_FREE (mod->hulls[0].clipnodes);
 		SAFE_FREE (mod->submodels);
+		SAFE_FREE (mod->inlinemodels);
 		mod->numsubmodels = 0;
 		SAFE_FREE (mod->planes);
 		mod->numplanes = 0;
@@ -330,14 +344,145 @@ static void Mod_FreeModelMemory (qmodel_t *mod)
 		SAFE_FREE (mod->lightdata);
 		SAFE_FREE (mod->entities);
 		SAFE_FREE (mod->extradata);
+		SAFE_FREE (mod->rtposes);
+		SAFE_FREE (mod->rttexcoords);
+		SAFE_FREE (mod->rtindices);
 	}
 	if (!isDedicated)
 		TexMgr_FreeTexturesForOwner (mod);
 }
 
+/*
+===================
+Mod_IsCached
+
+Models that are kept across map changes. Brush models are rebuilt for every map,
+their lightmaps and surface polys are owned by the map that precached them.
+===================
+*/
+static qboolean Mod_IsCached (qmodel_t *mod)
+{
+	return !mod->needload && (mod->type == mod_alias || mod->type == mod_sprite);
+}
+
+/*
+===================
+Mod_EvictModel
+===================
+*/
+static void Mod_EvictModel (qmodel_t *mod)
+{
+	Mod_FreeModelMemory (mod);
+	mod->needload = true;
+}
+
+static int Mod_CompareCacheSeq (const void *a, const void *b)
+{
+	return (*(qmodel_t *const *)b)->cacheseq - (*(qmodel_t *const *)a)->cacheseq;
+}
+
+/*
+===================
+Mod_TrimCache
+
+Keeps the most recently used models that fit into mod_cachesize
+===================
+*/
+static void Mod_TrimCache (void)
+{
+	qmodel_t **cached;
+	int        i, numcached = 0;
+	int64_t    budget = (int64_t)(q_max (mod_cachesize.value, 0.f) * 1024.f * 1024.f);
+
+	cached = (qmodel_t **)Mem_Alloc (mod_numknown * sizeof (qmodel_t *));
+	for (i = 0; i < mod_numknown; i++)
+		if (Mod_IsCached (&mod_known[i]) && !mod_known[i].owners)
+			cached[numcached++] = &mod_known[i];
+
+	qsort (cached, numcached, sizeof (qmodel_t *), Mod_CompareCacheSeq);
+
+	for (i = 0; i < numcached; i++)
+	{
+		budget -= q_max (cached[i]->filestamp.size, 0);
+		if (budget < 0)
+		{
+			Mod_EvictModel (cached[i]);
+			mod_cacheevicted++;
+		}
+	}
+
+	Mem_Free (cached);
+}
+
+/*
+===================
+Mod_CheckCache
+
+Called on the main thread the first time a model is requested for a map. A model kept
+from an earlier map is reused as long as its file hasn't changed.
+===================
+*/
+static void Mod_CheckCache (qmodel_t *mod)
+{
+	filestamp_t stamp;
+
+	if (mod->name[0] == '*' || mod->cacheseq == mod_cacheseq)
+		return;
+	mod->cacheseq = mod_cacheseq;
+
+	if (!mod->needload)
+	{
+		// another server instance still uses it, the new file is picked up once it's released
+		if ((mod->owners & ~mod_owner) || (COM_FileStamp (mod->name, &stamp) && !memcmp (&stamp, &mod->filestamp, sizeof (stamp))))
+		{
+			mod_cachehits++;
+			return;
+		}
+		Mod_EvictModel (mod);
+		mod_cachestale++;
+	}
+	mod_cachemisses++;
+}
+
+/*
+===================
+Mod_PrintCacheStats
+===================
+*/
+void Mod_PrintCacheStats (void)
+{
+	int     i, numcached = 0;
+	int64_t bytes = 0;
+
+	for (i = 0; i < mod_numknown; i++)
+	{
+		if (Mod_IsCached (&mod_known[i]))
+		{
+			numcached++;
+			bytes += q_max (mod_known[i].filestamp.size, 0);
+		}
+	}
+
+	Con_Printf (
+		"models: %d hits, %d misses (%d stale), %d evicted, %d cached in %.1f / %.0f MB\n", mod_cachehits, mod_cachemisses, mod_cachestale,
+		mod_cacheevicted, numcached, bytes / (1024.0 * 1024.0), mod_cachesize.value);
+}
+
+/*
+===================
+Mod_SetOwner
+===================
+*/
+void Mod_SetOwner (int owner)
+{
+	mod_owner = 1ull << owner;
+}
+
 /*
 ===================
 Mod_ClearAll
+
+Releases the models of the current owner, the ones that no other owner uses are freed
 ===================
 */
 void Mod_ClearAll (void)
@@ -347,13 +492,21 @@ void Mod_ClearAll (void)
 
 	for (i = 0, mod = mod_known; i < mod_numknown; i++, mod++)
 	{
-		if (mod->type != mod_alias)
+		mod->owners &= ~mod_owner;
+		if (mod->owners)
+			continue;
+		if (!Mod_IsCached (mod))
 		{
 			mod->needload = true;
 			Mod_FreeModelMemory (mod); // johnfitz
 		}
 	}
 
+	// the stats cover the loading of the next map
+	mod_cachehits = mod_cachemisses = mod_cachestale = mod_cacheevicted = 0;
+	Mod_TrimCache ();
+	mod_cacheseq++;
+
 	InvalidateTraceLineCache ();
 }
 
@@ -412,6 +565,7 @@ qmodel_t *Mod_FindName (const char *name)
 		mod_numknown++;
 		InvalidateTraceLineCache ();
 	}
+	mod->owners |= mod_owner;
 
 	return mod;
 }
@@ -429,45 +583,19 @@ void Mod_TouchModel (const char *name)
 
 /*
 ==================
-Mod_LoadModel
+Mod_LoadFromBuffer
 
-Loads a model into the cache
+Calls the apropriate loader for a file that Mod_LoadModel has mapped
 ==================
 */
-static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash)
+static void Mod_LoadFromBuffer (qmodel_t *mod, byte *buf)
 {
-	byte *buf;
-	int   mod_type;
-
-	if (!mod->needload)
-	{
-		return mod;
-	}
-
-	InvalidateTraceLineCache ();
-
-	//
-	// load the file
-	//
-	buf = COM_LoadFile (mod->name, &mod->path_id);
-	if (!buf)
-	{
-		if (crash)
-			Host_Error ("Mod_LoadModel: %s not found", mod->name); // johnfitz -- was "Mod_NumForName"
-		return NULL;
-	}
-
-	//
-	// allocate a new model
-	//
+	int  mod_type;
 	char loadname[256];
-	COM_FileBase (mod->name, loadname, sizeof (loadname));
 
-	//
-	// fill it in
-	//
+	COM_FileBase (mod->name, loadname, sizeof (loadname));
+	COM_FileStamp (mod->name, &mod->filestamp);
 
-	// call the apropriate loader
 	mod->needload = false;
 
 	mod_type = (buf[0] | (buf[1] << 8) | (buf[2] << 16) | (buf[3] << 24));
@@ -485,8 +613,45 @@ static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash)
 		Mod_LoadBrushModel (mod, loadname, buf);
 		break;
 	}
+}
+
+/*
+==================
+Mod_LoadModel
+
+Loads a model into the cache
+==================
+*/
+static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash)
+{
+	fileview_t     view;
+	const memtag_t prev_tag = Mem_SetTag (MEMTAG_MODEL);
+
+	Mod_CheckCache (mod);
+	if (!mod->needload)
+	{
+		Mem_SetTag (prev_tag);
+		return mod;
+	}
 
-	Mem_Free (buf);
+	InvalidateTraceLineCache ();
+
+	//
+	// load the file
+	//
+	// the loaders only read the file, so it can stay in the pak mapping
+	if (!COM_MapFile (mod->name, &mod->path_id, &view))
+	{
+		if (crash)
+			Host_Error ("Mod_LoadModel: %s not found", mod->name); // johnfitz -- was "Mod_NumForName"
+		Mem_SetTag (prev_tag);
+		return NULL;
+	}
+
+	Mod_LoadFromBuffer (mod, (byte *)view.data);
+
+	COM_UnmapFile (&view);
+	Mem_SetTag (prev_tag);
 	return mod;
 }
 
@@ -506,6 +671,120 @@ qmodel_t *Mod_ForName (const char *name, qboolean crash)
 	return Mod_LoadModel (mod, crash);
 }
 
+typedef struct mod_loadentry_s
+{
+	qmodel_t *mod;
+	qboolean  ontask;
+	double    start, end;
+} mod_loadentry_t;
+
+/*
+==================
+Mod_LoadModelTask
+
+Alias and sprite models only use Sys_Error and their own state, anything else
+(or a missing file) is left with needload set for the serial pass of Mod_ForNames
+==================
+*/
+static void Mod_LoadModelTask (int i, mod_loadentry_t **pentries)
+{
+	mod_loadentry_t *entry = &(*pentries)[i];
+	fileview_t       view;
+	int              mod_type;
+
+	if (!entry->ontask)
+		return;
+
+	entry->start = Sys_DoubleTime ();
+	if (COM_MapFile (entry->mod->name, &entry->mod->path_id, &view))
+	{
+		const byte *buf = (const byte *)view.data;
+		mod_type = (view.size >= 4) ? (buf[0] | (buf[1] << 8) | (buf[2] << 16) | (buf[3] << 24)) : 0;
+		if (mod_type == IDPOLYHEADER || mod_type == IDSPRITEHEADER)
+		{
+			const memtag_t prev_tag = Mem_SetTag (MEMTAG_MODEL);
+			Mod_LoadFromBuffer (entry->mod, (byte *)view.data);
+			Mem_SetTag (prev_tag);
+		}
+		COM_UnmapFile (&view);
+	}
+	entry->end = Sys_DoubleTime ();
+}
+
+/*
+==================
+Mod_ForNames
+
+Loads a precache list. Alias and sprite models are loaded by tasks while the
+brush models are loaded on the main thread, then every name is resolved in
+list order. models[i] is NULL for a missing model unless crash is set.
+==================
+*/
+void Mod_ForNames (const char **names, qmodel_t **models, int count, qboolean crash)
+{
+	mod_loadentry_t *entries;
+	byte            *queued;
+	int              i, numentries = 0, numtasks = 0;
+	const double     starttime = Sys_DoubleTime ();
+
+	entries = (mod_loadentry_t *)Mem_Alloc (count * sizeof (mod_loadentry_t));
+	queued = (byte *)Mem_Alloc (MAX_MOD_KNOWN);
+
+	for (i = 0; i < count; i++)
+	{
+		qmodel_t *mod = models[i] = Mod_FindName (names[i]);
+		Mod_CheckCache (mod);
+		if (!mod->needload || queued[mod - mod_known])
+			continue;
+		queued[mod - mod_known] = true;
+		entries[numentries].mod = mod;
+		entries[numentries].ontask = q_strcasecmp (COM_FileGetExtension (mod->name), "bsp") != 0;
+		numtasks += entries[numentries].ontask;
+		numentries++;
+	}
+
+	task_handle_t task = INVALID_TASK_HANDLE;
+	if (numtasks > 0)
+		task = Task_AllocateAssignIndexedFuncAndSubmit ("Mod_LoadModelTask", (task_indexed_func_t)Mod_LoadModelTask, numentries, &entries, sizeof (entries));
+
+	for (i = 0; i < numentries; i++)
+	{
+		if (entries[i].ontask)
+			continue;
+		entries[i].start = Sys_DoubleTime ();
+		Mod_LoadModel (entries[i].mod, false);
+		entries[i].end = Sys_DoubleTime ();
+	}
+
+	if (numtasks > 0)
+		Task_Join (task, SDL_MUTEX_MAXWAIT);
+
+#ifdef PSET_SCRIPT
+	for (i = 0; i < numentries; i++)
+		if (entries[i].ontask && !entries[i].mod->needload)
+			PScript_UpdateModelEffects (entries[i].mod);
+#endif
+
+	// register in precache order, this also loads whatever the tasks left behind and reports missing models
+	for (i = 0; i < count; i++)
+		models[i] = Mod_LoadModel (models[i], crash);
+
+	InvalidateTraceLineCache ();
+
+	if (numentries > 0)
+	{
+		Con_DPrintf ("model load timeline, %d models (%d on tasks):\n", numentries, numtasks);
+		for (i = 0; i < numentries; i++)
+			Con_DPrintf (
+				"%8.2f %8.2f ms %s %s\n", (entries[i].start - starttime) * 1000.0, (entries[i].end - starttime) * 1000.0, entries[i].ontask ? "task" : "main",
+				entries[i].mod->name);
+		Con_DPrintf ("model loading took %.2f ms\n", (Sys_DoubleTime () - starttime) * 1000.0);
+	}
+
+	Mem_Free (queued);
+	Mem_Free (entries);
+}
+
 /*
 ===============================================================================
 
@@ -782,7 +1061,8 @@ static void Mod_LoadTextures (qmodel_t *mod, byte *mod_base, lump_t *l)
 		};
 		if (!Tasks_IsWorker () && (nummiptex > 1))
 		{
-			task_handle_t task = Task_AllocateAssignIndexedFuncAndSubmit ((task_indexed_func_t)Mod_LoadTextureTask, nummiptex, &args, sizeof (args));
+			task_handle_t task =
+				Task_AllocateAssignIndexedFuncAndSubmit ("Mod_LoadTextureTask", (task_indexed_func_t)Mod_LoadTextureTask, nummiptex, &args, sizeof (args));
 			Task_Join (task, SDL_MUTEX_MAXWAIT);
 		}
 		else
@@ -1316,70 +1596,87 @@ static void Mod_PolyForUnlitSurface (qmodel_t *mod, msurface_t *fa)
 	}
 }
 
+typedef struct load_faces_task_args_s
+{
+	qmodel_t *mod;
+	byte     *in;
+	qboolean  bsp2;
+} load_faces_task_args_t;
+
 /*
 =================
-Mod_LoadFaces
+Mod_AllocFaces
+
+Validates the lump and allocates the surfaces, returns the number of faces
 =================
 */
-static void Mod_LoadFaces (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bsp2)
+static int Mod_AllocFaces (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bsp2)
 {
-	byte       *ins;
-	byte       *inl;
-	msurface_t *out;
-	int         i, count, surfnum, lofs;
-	int         planenum, side, texinfon;
+	int count;
 
 	if (bsp2)
 	{
-		ins = NULL;
-		inl = mod_base + l->fileofs;
 		if (l->filelen % sizeof (dlface_t))
 			Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 		count = l->filelen / sizeof (dlface_t);
 	}
 	else
 	{
-		ins = mod_base + l->fileofs;
-		inl = NULL;
 		if (l->filelen % sizeof (dsface_t))
 			Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 		count = l->filelen / sizeof (dsface_t);
 	}
-	out = (msurface_t *)Mem_Alloc (count * sizeof (*out));
 
 	// johnfitz -- warn mappers about exceeding old limits
 	if (count > 32767 && !bsp2)
 		Con_DWarning ("%i faces exceeds standard limit of 32767.\n", count);
 	// johnfitz
 
-	mod->surfaces = out;
+	mod->surfaces = (msurface_t *)Mem_Alloc (count * sizeof (msurface_t));
 	mod->numsurfaces = count;
+	return count;
+}
 
-	for (surfnum = 0; surfnum < count; surfnum++, out++)
+/*
+=================
+Mod_LoadFacesTask
+
+Faces only read vertexes, edges, surfedges, planes, texinfo and lighting, so ranges of them load in parallel
+=================
+*/
+static void Mod_LoadFacesTask (int begin, int end, load_faces_task_args_t *args)
+{
+	qmodel_t   *mod = args->mod;
+	const int   facesize = args->bsp2 ? sizeof (dlface_t) : sizeof (dsface_t);
+	byte       *in = args->in + (size_t)begin * facesize;
+	msurface_t *out = mod->surfaces + begin;
+	int         i, surfnum, lofs;
+	int         planenum, side, texinfon;
+	memtag_t    prev_tag = Mem_SetTag (MEMTAG_MODEL); // the polys of unlit surfaces
+
+	for (surfnum = begin; surfnum < end; surfnum++, out++, in += facesize)
 	{
-		if (bsp2)
+		if (args->bsp2)
 		{
-			out->firstedge = ReadLongUnaligned (inl + offsetof (dlface_t, firstedge));
-			out->numedges = ReadLongUnaligned (inl + offsetof (dlface_t, numedges));
-			planenum = ReadLongUnaligned (inl + offsetof (dlface_t, planenum));
-			side = ReadLongUnaligned (inl + offsetof (dlface_t, side));
-			texinfon = ReadLongUnaligned (inl + offsetof (dlface_t, texinfo));
+			out->firstedge = ReadLongUnaligned (in + offsetof (dlface_t, firstedge));
+			out->numedges = ReadLongUnaligned (in + offsetof (dlface_t, numedges));
+			planenum = ReadLongUnaligned (in + offsetof (dlface_t, planenum));
+			side = ReadLongUnaligned (in + offsetof (dlface_t, side));
+			texinfon = ReadLongUnaligned (in + offsetof (dlface_t, texinfo));
 			for (i = 0; i < MAXLIGHTMAPS; i++)
-				out->styles[i] = *(inl + offsetof (dlface_t, styles[i]));
-			lofs = ReadLongUnaligned (inl + offsetof (dlface_t, lightofs));
-			inl += sizeof (dlface_t);
+				out->styles[i] = *(in + offsetof (dlface_t, styles[i]));
+			lofs = ReadLongUnaligned (in + offsetof (dlface_t, lightofs));
 		}
 		else
 		{
-			out->firstedge = ReadLongUnaligned (ins + offsetof (dsface_t, firstedge));
-			out->numedges = ReadShortUnaligned (ins + offsetof (dsface_t, numedges));
-			planenum = ReadShortUnaligned (ins + offsetof (dsface_t, planenum));
-			side = ReadShortUnaligned (ins + offsetof (dsface_t, side));
-			texinfon = ReadShortUnaligned (ins + offsetof (dsface_t, texinfo));
+			out->firstedge = ReadLongUnaligned (in + offsetof (dsface_t, firstedge));
+			out->numedges = ReadShortUnaligned (in + offsetof (dsface_t, numedges));
+			planenum = ReadShortUnaligned (in + offsetof (dsface_t, planenum));
+			side = ReadShortUnaligned (in + offsetof (dsface_t, side));
+			texinfon = ReadShortUnaligned (in + offsetof (dsface_t, texinfo));
 			for (i = 0; i < MAXLIGHTMAPS; i++)
-				out->styles[i] = *(ins + offsetof (dsface_t, styles[i]));
-			lofs = ReadLongUnaligned (ins + offsetof (dsface_t, lightofs));
-			ins += sizeof (dsface_t);
+				out->styles[i] = *(in + offsetof (dsface_t, styles[i]));
+			lofs = ReadLongUnaligned (in + offsetof (dsface_t, lightofs));
 		}
 
 		out->flags = 0;
@@ -1446,6 +1743,7 @@ static void Mod_LoadFaces (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bs
 		}
 		// johnfitz
 	}
+	Mem_SetTag (prev_tag);
 }
 
 /*
@@ -1882,9 +2180,11 @@ static void Mod_CheckWaterVis (qmodel_t *mod)
 /*
 =================
 Mod_LoadClipnodes
+
+Returns false for a planenum that is out of bounds, it's loaded by a task that can't Host_Error
 =================
 */
-static void Mod_LoadClipnodes (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bsp2)
+static qboolean Mod_LoadClipnodes (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bsp2)
 {
 	byte *ins;
 	byte *inl;
@@ -1953,7 +2253,7 @@ static void Mod_LoadClipnodes (qmodel_t *mod, byte *mod_base, lump_t *l, qboolea
 
 			// johnfitz -- bounds check
 			if (out->planenum < 0 || out->planenum >= mod->numplanes)
-				Host_Error ("Mod_LoadClipnodes: planenum out of bounds");
+				return false;
 			// johnfitz
 
 			out->children[0] = ReadLongUnaligned (inl + offsetof (dlclipnode_t, children[0]));
@@ -1969,7 +2269,7 @@ static void Mod_LoadClipnodes (qmodel_t *mod, byte *mod_base, lump_t *l, qboolea
 
 			// johnfitz -- bounds check
 			if (out->planenum < 0 || out->planenum >= mod->numplanes)
-				Host_Error ("Mod_LoadClipnodes: planenum out of bounds");
+				return false;
 			// johnfitz
 
 			// johnfitz -- support clipnodes > 32k
@@ -1983,6 +2283,7 @@ static void Mod_LoadClipnodes (qmodel_t *mod, byte *mod_base, lump_t *l, qboolea
 			// johnfitz
 		}
 	}
+	return true;
 }
 
 /*
@@ -2375,6 +2676,7 @@ static void Mod_SetupSubmodels (qmodel_t *mod)
 	int       i, j;
 	float     radius;
 	dmodel_t *bm;
+	qmodel_t *world = mod;
 
 	// johnfitz -- okay, so that i stop getting confused every time i look at this loop, here's how it works:
 	// we're looping through the submodels starting at 0.  Submodel 0 is the main model, so we don't have to
@@ -2430,14 +2732,95 @@ static void Mod_SetupSubmodels (qmodel_t *mod)
 			// Need to NULL this otherwise we double delete in PScript_ClearSurfaceParticles
 			submodel->skytrimem = NULL;
 #endif
+			submodel->inlinemodels = NULL;
 			mod = submodel;
 		}
 	}
+
+	// the *n entries above are replaced by the next map that gets loaded, the server keeps using these
+	if (world->numsubmodels > 1)
+	{
+		world->inlinemodels = (qmodel_t *)Mem_Alloc ((world->numsubmodels - 1) * sizeof (qmodel_t));
+		for (i = 1; i < world->numsubmodels; i++)
+			world->inlinemodels[i - 1] = *Mod_FindName (va ("*%i", i));
+	}
+}
+
+static const char *lump_names[HEADER_LUMPS] = {
+	"entities", "planes", "textures", "vertexes", "visibility", "nodes", "texinfo", "faces",
+	"lighting", "clipnodes", "leafs", "marksurfaces", "edges", "surfedges", "models"};
+
+typedef struct load_lump_task_args_s
+{
+	qmodel_t *mod;
+	byte     *mod_base;
+	lump_t    l;
+	int       lump;
+	int       bsp2;
+	double   *lump_ms;
+	qboolean *lump_failed; // the main thread raises the Host_Error after the join
+} load_lump_task_args_t;
+
+/*
+=================
+Mod_LoadLumpTask
+
+Loads lumps that only depend on their own data (and the planes), see Mod_LoadBrushModel
+=================
+*/
+static void Mod_LoadLumpTask (load_lump_task_args_t *args)
+{
+	const double   start = Sys_DoubleTime ();
+	const memtag_t prev_tag = Mem_SetTag (MEMTAG_MODEL);
+	switch (args->lump)
+	{
+	case LUMP_VERTEXES:
+		Mod_LoadVertexes (args->mod, args->mod_base, &args->l);
+		break;
+	case LUMP_EDGES:
+		Mod_LoadEdges (args->mod, args->mod_base, &args->l, args->bsp2);
+		break;
+	case LUMP_SURFEDGES:
+		Mod_LoadSurfedges (args->mod, args->mod_base, &args->l);
+		break;
+	case LUMP_PLANES:
+		Mod_LoadPlanes (args->mod, args->mod_base, &args->l);
+		break;
+	case LUMP_CLIPNODES:
+		args->lump_failed[args->lump] = !Mod_LoadClipnodes (args->mod, args->mod_base, &args->l, args->bsp2);
+		break;
+	case LUMP_MODELS:
+		Mod_LoadSubmodels (args->mod, args->mod_base, &args->l);
+		break;
+	default:
+		Sys_Error ("Mod_LoadLumpTask: lump %i can't be loaded by a task", args->lump);
+	}
+	Mem_SetTag (prev_tag);
+	args->lump_ms[args->lump] = (Sys_DoubleTime () - start) * 1000.0;
+}
+
+/*
+=================
+Mod_AllocateLumpTask
+=================
+*/
+static task_handle_t Mod_AllocateLumpTask (qmodel_t *mod, byte *mod_base, dheader_t *header, int lump, int bsp2, double *lump_ms, qboolean *lump_failed)
+{
+	load_lump_task_args_t args = {mod, mod_base, header->lumps[lump], lump, bsp2, lump_ms, lump_failed};
+	return Task_AllocateAndAssignFunc ("Mod_LoadLumpTask", (task_func_t)Mod_LoadLumpTask, &args, sizeof (args));
 }
 
 /*
 =================
 Mod_LoadBrushModel
+
+Vertexes, edges, surfedges, planes, clipnodes and submodels are loaded by tasks while this
+thread loads the textures, lighting and texinfo, which read files or upload textures. The
+faces wait for the geometry lumps and are then loaded in ranges. The lumps after them can
+Host_Error and are loaded serially. -loadstats prints the time per lump.
+
+On a task (a late precache by a server instance, see SV_RunInstances) everything is loaded
+serially: a Task_Join could run the physics of another instance on this thread.
 =================
 */
 static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffer)
@@ -2445,10 +2828,24 @@ static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffe
 	int        i;
 	int        bsp2;
 	dheader_t *header;
+	dheader_t  swapped_header;
+	double     lump_ms[HEADER_LUMPS];
+	qboolean   lump_failed[HEADER_LUMPS];
+	double     start;
+
+	static const int task_lumps[] = {LUMP_VERTEXES, LUMP_EDGES, LUMP_SURFEDGES, LUMP_PLANES, LUMP_CLIPNODES, LUMP_MODELS};
+	task_handle_t    lump_tasks[countof (task_lumps)];
+	const qboolean   serial = Tasks_IsWorker ();
+
+	const double load_start = Sys_DoubleTime ();
+	memset (lump_ms, 0, sizeof (lump_ms));
+	memset (lump_failed, 0, sizeof (lump_failed));
 
 	mod->type = mod_brush;
 
-	header = (dheader_t *)buffer;
+	// the file is read-only, swap a copy of the header
+	memcpy (&swapped_header, buffer, sizeof (swapped_header));
+	header = &swapped_header;
 
 	mod->bspversion = LittleLong (header->version);
 
@@ -2472,23 +2869,73 @@ static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffe
 	}
 
 	// swap all the lumps
-	byte *mod_base = (byte *)header;
+	byte *mod_base = (byte *)buffer;
 
 	for (i = 0; i < (int)sizeof (dheader_t) / 4; i++)
 		((int *)header)[i] = LittleLong (((int *)header)[i]);
 
 	// load into heap
 
-	Mod_LoadVertexes (mod, mod_base, &header->lumps[LUMP_VERTEXES]);
-	Mod_LoadEdges (mod, mod_base, &header->lumps[LUMP_EDGES], bsp2);
-	Mod_LoadSurfedges (mod, mod_base, &header->lumps[LUMP_SURFEDGES]);
+	// in dependency order for the serial case, the clipnodes need the planes
+	for (i = 0; i < (int)countof (task_lumps); i++)
+	{
+		if (serial)
+		{
+			load_lump_task_args_t args = {mod, mod_base, header->lumps[task_lumps[i]], task_lumps[i], bsp2, lump_ms, lump_failed};
+			Mod_LoadLumpTask (&args);
+		}
+		else
+			lump_tasks[i] = Mod_AllocateLumpTask (mod, mod_base, header, task_lumps[i], bsp2, lump_ms, lump_failed);
+	}
+	if (!serial)
+	{
+		Task_AddDependency (lump_tasks[3], lump_tasks[4]); // planes, clipnodes
+		Tasks_Submit (countof (lump_tasks), lump_tasks);
+	}
+
+	start = Sys_DoubleTime ();
 	Mod_LoadTextures (mod, mod_base, &header->lumps[LUMP_TEXTURES]);
+	lump_ms[LUMP_TEXTURES] = (Sys_DoubleTime () - start) * 1000.0;
+
+	start = Sys_DoubleTime ();
 	Mod_LoadLighting (mod, mod_base, &header->lumps[LUMP_LIGHTING]);
-	Mod_LoadPlanes (mod, mod_base, &header->lumps[LUMP_PLANES]);
+	lump_ms[LUMP_LIGHTING] = (Sys_DoubleTime () - start) * 1000.0;
+
+	start = Sys_DoubleTime ();
 	Mod_LoadTexinfo (mod, mod_base, &header->lumps[LUMP_TEXINFO]);
-	Mod_LoadFaces (mod, mod_base, &header->lumps[LUMP_FACES], bsp2);
+	lump_ms[LUMP_TEXINFO] = (Sys_DoubleTime () - start) * 1000.0;
+
+	// includes the time spent waiting for the geometry lumps that are still loading
+	start = Sys_DoubleTime ();
+	const int numfaces = Mod_AllocFaces (mod, mod_base, &header->lumps[LUMP_FACES], bsp2);
+	if (numfaces > 0)
+	{
+		load_faces_task_args_t faces_args = {mod, mod_base + header->lumps[LUMP_FACES].fileofs, bsp2};
+		if (serial)
+			Mod_LoadFacesTask (0, numfaces, &faces_args);
+		else
+		{
+			task_handle_t faces_task =
+				Task_AllocateAndAssignRangedFunc ("Mod_LoadFacesTask", (task_ranged_func_t)Mod_LoadFacesTask, numfaces, 0, &faces_args, sizeof (faces_args));
+			for (i = 0; i < 4; i++) // vertexes, edges, surfedges and planes
+				Task_AddDependency (lump_tasks[i], faces_task);
+			Task_Submit (faces_task);
+			Task_Join (faces_task, SDL_MUTEX_MAXWAIT);
+		}
+	}
+	lump_ms[LUMP_FACES] = (Sys_DoubleTime () - start) * 1000.0;
+
+	// the remaining lumps can Host_Error, which must not leave tasks writing into the model
+	for (i = 0; !serial && i < (int)countof (lump_tasks); i++)
+		Task_Join (lump_tasks[i], SDL_MUTEX_MAXWAIT);
+	if (lump_failed[LUMP_CLIPNODES])
+		Host_Error ("Mod_LoadClipnodes: planenum out of bounds");
+
+	start = Sys_DoubleTime ();
 	Mod_LoadMarksurfaces (mod, mod_base, &header->lumps[LUMP_MARKSURFACES], bsp2);
+	lump_ms[LUMP_MARKSURFACES] = (Sys_DoubleTime () - start) * 1000.0;
 
+	start = Sys_DoubleTime ();
 	if (mod->bspversion == BSPVERSION && external_vis.value && sv.modelname[0] && !q_strcasecmp (loadname, sv.name))
 	{
 		FILE *fvis;
@@ -2507,6 +2954,7 @@ static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffe
 			fclose (fvis);
 			if (mod->visdata && mod->leafs && mod->numleafs)
 			{
+				lump_ms[LUMP_VISIBILITY] = (Sys_DoubleTime () - start) * 1000.0;
 				goto visdone;
 			}
 			Con_DPrintf ("External VIS data failed, using standard vis.\n");
@@ -2514,12 +2962,19 @@ static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffe
 	}
 
 	Mod_LoadVisibility (mod, mod_base, &header->lumps[LUMP_VISIBILITY]);
+	lump_ms[LUMP_VISIBILITY] = (Sys_DoubleTime () - start) * 1000.0;
+
+	start = Sys_DoubleTime ();
 	Mod_LoadLeafs (mod, mod_base, &header->lumps[LUMP_LEAFS], bsp2);
+	lump_ms[LUMP_LEAFS] = (Sys_DoubleTime () - start) * 1000.0;
 visdone:
+	start = Sys_DoubleTime ();
 	Mod_LoadNodes (mod, mod_base, &header->lumps[LUMP_NODES], bsp2);
-	Mod_LoadClipnodes (mod, mod_base, &header->lumps[LUMP_CLIPNODES], bsp2);
+	lump_ms[LUMP_NODES] = (Sys_DoubleTime () - start) * 1000.0;
+
+	start = Sys_DoubleTime ();
 	Mod_LoadEntities (mod, mod_base, &header->lumps[LUMP_ENTITIES]);
-	Mod_LoadSubmodels (mod, mod_base, &header->lumps[LUMP_MODELS]);
+	lump_ms[LUMP_ENTITIES] = (Sys_DoubleTime () - start) * 1000.0;
 
 	Mod_MakeHull0 (mod);
 
@@ -2527,6 +2982,13 @@ visdone:
 
 	Mod_CheckWaterVis (mod);
 	Mod_SetupSubmodels (mod);
+
+	if (COM_CheckParm ("-loadstats"))
+	{
+		Con_Printf ("%s loaded in %.2f ms\n", mod->name, (Sys_DoubleTime () - load_start) * 1000.0);
+		for (i = 0; i < HEADER_LUMPS; i++)
+			Con_Printf ("  %-12s %8.2f ms\n", lump_names[i], lump_ms[i]);
+	}
 }
 
 /*
@@ -2537,15 +2999,16 @@ ALIAS MODELS
 ==============================================================================
 */
 
-aliashdr_t *pheader;
+// working state of the alias loader, per thread so that models can be loaded by tasks
+THREAD_LOCAL aliashdr_t *pheader;
 
-stvert_t    stverts[MAXALIASVERTS];
-mtriangle_t triangles[MAXALIASTRIS];
+THREAD_LOCAL stvert_t    stverts[MAXALIASVERTS];
+THREAD_LOCAL mtriangle_t triangles[MAXALIASTRIS];
 
 // a pose is a single set of vertexes.  a frame may be
 // an animating sequence of poses
-trivertx_t *poseverts[MAXALIASFRAMES];
-int         posenum;
+THREAD_LOCAL trivertx_t *poseverts[MAXALIASFRAMES];
+THREAD_LOCAL int         posenum;
 
 byte **player_8bit_texels_tbl;
 byte  *player_8bit_texels;
@@ -2725,9 +3188,10 @@ Mod_LoadSkinTask
 */
 typedef struct load_skin_task_args_s
 {
-	qmodel_t *mod;
-	byte     *mod_base;
-	byte    **ppskintypes;
+	qmodel_t   *mod;
+	aliashdr_t *hdr;
+	byte       *mod_base;
+	byte      **ppskintypes;
 } load_skin_task_args_t;
 
 static void Mod_LoadSkinTask (int i, load_skin_task_args_t *args)
@@ -2744,9 +3208,10 @@ static void Mod_LoadSkinTask (int i, load_skin_task_args_t *args)
 	src_offset_t offset;                   // johnfitz
 	unsigned int texflags = TEXPREF_PAD;
 	qmodel_t    *mod = args->mod;
+	aliashdr_t  *hdr = args->hdr;
 	byte        *mod_base = args->mod_base;
 
-	size = pheader->skinwidth * pheader->skinheight;
+	size = hdr->skinwidth * hdr->skinheight;
 
 	if (mod->flags & MF_HOLEY)
 		texflags |= TEXPREF_ALPHA;
@@ -2755,44 +3220,44 @@ static void Mod_LoadSkinTask (int i, load_skin_task_args_t *args)
 
 	if (ReadLongUnaligned (pskintype + offsetof (daliasskintype_t, type)) == ALIAS_SKIN_SINGLE)
 	{
+		// the file is read-only, flood fill the 8 bit texels saved for the player model to remap
 		skin = pskintype + sizeof (daliasskintype_t);
-		Mod_FloodFillSkin (skin, pheader->skinwidth, pheader->skinheight);
-
-		// save 8 bit texels for the player model to remap
+		offset = (src_offset_t)(skin) - (src_offset_t)mod_base;
 		texels = (byte *)Mem_Alloc (size);
-		pheader->texels[i] = texels;
+		hdr->texels[i] = texels;
 		memcpy (texels, skin, size);
+		Mod_FloodFillSkin (texels, hdr->skinwidth, hdr->skinheight);
+		skin = texels;
 
 		// johnfitz -- rewritten
 		q_snprintf (name, sizeof (name), "%s:frame%i", mod->name, i);
 		q_snprintf (rtname, sizeof (rtname), "%s/%i", namenoext, i);
 
-		offset = (src_offset_t)(skin) - (src_offset_t)mod_base;
 		if (Mod_CheckFullbrights (skin, size))
 		{
 			TexMgr_RT_SpecialStart (CVAR_TO_FLOAT (rt_model_rough), CVAR_TO_FLOAT (rt_model_metal));
 
-			pheader->gltextures[i][0] = TexMgr_LoadImage (
+			hdr->gltextures[i][0] = TexMgr_LoadImage (
 				rtname,
-				mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset, texflags | TEXPREF_MIPMAP | TEXPREF_NOBRIGHT);
+				mod, name, hdr->skinwidth, hdr->skinheight, SRC_INDEXED, skin, mod->name, offset, texflags | TEXPREF_MIPMAP | TEXPREF_NOBRIGHT);
 			q_snprintf (fbr_mask_name, sizeof (fbr_mask_name), "%s:frame%i_glow", mod->name, i);
-			pheader->fbtextures[i][0] = TexMgr_LoadImage (
+			hdr->fbtextures[i][0] = TexMgr_LoadImage (
 				NULL,
-				mod, fbr_mask_name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset,
+				mod, fbr_mask_name, hdr->skinwidth, hdr->skinheight, SRC_INDEXED, skin, mod->name, offset,
 				TEXPREF_RT_IS_EMISSIVE | texflags | TEXPREF_MIPMAP | TEXPREF_FULLBRIGHT);
 
 			TexMgr_RT_SpecialEnd ();
 		}
 		else
 		{
-			pheader->gltextures[i][0] = TexMgr_LoadImage (
+			hdr->gltextures[i][0] = TexMgr_LoadImage (
 				rtname, 
-				mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset, texflags | TEXPREF_MIPMAP);
-			pheader->fbtextures[i][0] = NULL;
+				mod, name, hdr->skinwidth, hdr->skinheight, SRC_INDEXED, skin, mod->name, offset, texflags | TEXPREF_MIPMAP);
+			hdr->fbtextures[i][0] = NULL;
 		}
 
-		pheader->gltextures[i][3] = pheader->gltextures[i][2] = pheader->gltextures[i][1] = pheader->gltextures[i][0];
-		pheader->fbtextures[i][3] = pheader->fbtextures[i][2] = pheader->fbtextures[i][1] = pheader->fbtextures[i][0];
+		hdr->gltextures[i][3] = hdr->gltextures[i][2] = hdr->gltextures[i][1] = hdr->gltextures[i][0];
+		hdr->fbtextures[i][3] = hdr->fbtextures[i][2] = hdr->fbtextures[i][1] = hdr->fbtextures[i][0];
 		// johnfitz
 	}
 	else
@@ -2805,48 +3270,49 @@ static void Mod_LoadSkinTask (int i, load_skin_task_args_t *args)
 
 		for (j = 0; j < groupskins; j++)
 		{
-			Mod_FloodFillSkin (skin, pheader->skinwidth, pheader->skinheight);
+			// the file is read-only, only the first skin's texels are kept for the player model
+			offset = (src_offset_t)(skin) - (src_offset_t)mod_base; // johnfitz
+			texels = (byte *)Mem_Alloc (size);
 			if (j == 0)
-			{
-				texels = (byte *)Mem_Alloc (size);
-				pheader->texels[i] = texels;
-				memcpy (texels, skin, size);
-			}
+				hdr->texels[i] = texels;
+			memcpy (texels, skin, size);
+			Mod_FloodFillSkin (texels, hdr->skinwidth, hdr->skinheight);
 
 			// johnfitz -- rewritten
 			q_snprintf (name, sizeof (name), "%s:frame%i_%i", mod->name, i, j);
 			q_snprintf (rtname, sizeof (rtname), "%s/%i_%i", namenoext, i, j);
 
-			offset = (src_offset_t)(skin) - (src_offset_t)mod_base; // johnfitz
-			if (Mod_CheckFullbrights (skin, size))
+			if (Mod_CheckFullbrights (texels, size))
 			{
 				TexMgr_RT_SpecialStart (CVAR_TO_FLOAT (rt_model_rough), CVAR_TO_FLOAT (rt_model_metal));
 
-				pheader->gltextures[i][j & 3] = TexMgr_LoadImage (
+				hdr->gltextures[i][j & 3] = TexMgr_LoadImage (
 					rtname,
-					mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset, texflags | TEXPREF_MIPMAP | TEXPREF_NOBRIGHT);
+					mod, name, hdr->skinwidth, hdr->skinheight, SRC_INDEXED, texels, mod->name, offset, texflags | TEXPREF_MIPMAP | TEXPREF_NOBRIGHT);
 				q_snprintf (fbr_mask_name, sizeof (fbr_mask_name), "%s:frame%i_%i_glow", mod->name, i, j);
-				pheader->fbtextures[i][j & 3] = TexMgr_LoadImage (
+				hdr->fbtextures[i][j & 3] = TexMgr_LoadImage (
 					NULL,
-					mod, fbr_mask_name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset,
+					mod, fbr_mask_name, hdr->skinwidth, hdr->skinheight, SRC_INDEXED, texels, mod->name, offset,
 					TEXPREF_RT_IS_EMISSIVE | texflags | TEXPREF_MIPMAP | TEXPREF_FULLBRIGHT);
 
 				TexMgr_RT_SpecialEnd ();
 			}
 			else
 			{
-				pheader->gltextures[i][j & 3] = TexMgr_LoadImage (
+				hdr->gltextures[i][j & 3] = TexMgr_LoadImage (
 					rtname,
-					mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset, texflags | TEXPREF_MIPMAP);
-				pheader->fbtextures[i][j & 3] = NULL;
+					mod, name, hdr->skinwidth, hdr->skinheight, SRC_INDEXED, texels, mod->name, offset, texflags | TEXPREF_MIPMAP);
+				hdr->fbtextures[i][j & 3] = NULL;
 			}
 			// johnfitz
 
+			if (j > 0)
+				Mem_Free (texels);
 			skin += size;
 		}
 		k = j;
 		for (/**/; j < 4; j++)
-			pheader->gltextures[i][j & 3] = pheader->gltextures[i][j - k];
+			hdr->gltextures[i][j & 3] = hdr->gltextures[i][j - k];
 	}
 }
 
@@ -2883,12 +3349,13 @@ void *Mod_LoadAllSkins (qmodel_t *mod, byte *mod_base, int numskins, byte *pskin
 
 	load_skin_task_args_t args = {
 		.mod = mod,
+		.hdr = pheader,
 		.mod_base = mod_base,
 		.ppskintypes = ppskintypes,
 	};
 	if (!Tasks_IsWorker () && (numskins > 1))
 	{
-		task_handle_t task = Task_AllocateAssignIndexedFuncAndSubmit ((task_indexed_func_t)Mod_LoadSkinTask, numskins, &args, sizeof (args));
+		task_handle_t task = Task_AllocateAssignIndexedFuncAndSubmit ("Mod_LoadSkinTask", (task_indexed_func_t)Mod_LoadSkinTask, numskins, &args, sizeof (args));
 		Task_Join (task, SDL_MUTEX_MAXWAIT);
 	}
 	else
@@ -3014,7 +3481,9 @@ void Mod_SetExtraFlags (qmodel_t *mod)
 	}
 
 #ifdef PSET_SCRIPT
-	PScript_UpdateModelEffects (mod);
+	// may load particle configs, Mod_ForNames updates models loaded by tasks once they are joined
+	if (!Tasks_IsWorker ())
+		PScript_UpdateModelEffects (mod);
 #endif
 }
 
@@ -3346,11 +3815,27 @@ void Mod_Print (void)
 {
 	int       i;
 	qmodel_t *mod;
+	size_t    pose_bytes = 0, expanded_bytes = 0;
 
 	Con_SafePrintf ("Cached models:\n"); // johnfitz -- safeprint instead of print
 	for (i = 0, mod = mod_known; i < mod_numknown; i++, mod++)
 	{
-		Con_SafePrintf ("%8p : %s\n", mod->extradata, mod->name); // johnfitz -- safeprint instead of print
+		if (mod->type == mod_alias && mod->rtposes)
+		{
+			// alias poses stay quantized, report what they would take as full vertices
+			const aliashdr_t *hdr = (const aliashdr_t *)Mod_Extradata (mod);
+			const size_t      compact = ((size_t)hdr->numposes * sizeof (trivertx_t) + 2 * sizeof (float)) * hdr->numverts_vbo;
+			const size_t      expanded = (size_t)hdr->numposes * hdr->numverts_vbo * sizeof (RgVertex);
+			Con_SafePrintf (
+				"%8p : %s (%i poses, %i verts, %i KB, %i KB expanded)\n", mod->extradata, mod->name, hdr->numposes, hdr->numverts_vbo,
+				(int)(compact / 1024), (int)(expanded / 1024));
+			pose_bytes += compact;
+			expanded_bytes += expanded;
+		}
+		else
+			Con_SafePrintf ("%8p : %s\n", mod->extradata, mod->name); // johnfitz -- safeprint instead of print
 	}
 	Con_Printf ("%i models\n", mod_numknown); // johnfitz -- print the total too
+	if (pose_bytes > 0)
+		Con_Printf ("alias poses: %i KB (%i KB expanded)\n", (int)(pose_bytes / 1024), (int)(expanded_bytes / 1024));
 }
@@ -94,20 +94,21 @@ typedef enum
 
 typedef struct texture_s
 {
-	char                name[16];
-	unsigned            width, height;
-	unsigned            shift;                    // Q64
-	struct gltexture_s *gltexture;                // johnfitz -- pointer to gltexture
-	struct gltexture_s *fullbright;               // johnfitz -- fullbright mask texture; RT -- not used
-	struct gltexture_s *warpimage;                // johnfitz -- for water animation
-	atomic_uint32_t     update_warp;              // johnfitz -- update warp this frame
-	struct msurface_s  *texturechains[chain_num]; // for texture chains
-	uint32_t            chain_size[chain_num];    // for texture chains
-	int                 anim_total;               // total tenths in sequence ( 0 = no)
-	int                 anim_min, anim_max;       // time for this frame min <=time< max
-	struct texture_s   *anim_next;                // in the animation sequence
-	struct texture_s   *alternate_anims;          // bmodels in frmae 1 use these
-	unsigned            offsets[MIPLEVELS];       // four mip maps stored
+	char                 name[16];
+	unsigned             width, height;
+	unsigned             shift;                    // Q64
+	struct gltexture_s  *gltexture;                // johnfitz -- pointer to gltexture
+	struct gltexture_s  *fullbright;               // johnfitz -- fullbright mask texture; RT -- not used
+	struct gltexture_s  *warpimage;                // johnfitz -- for water animation
+	atomic_uint32_t      update_warp;              // johnfitz -- update warp this frame
+	struct msurface_s   *texturechains[chain_num]; // for texture chains
+	uint32_t             chain_size[chain_num];    // for texture chains
+	struct chaincache_s *chaincache[chain_num];    // RT -- batches assembled from the texture chains
+	int                  anim_total;               // total tenths in sequence ( 0 = no)
+	int                  anim_min, anim_max;       // time for this frame min <=time< max
+	struct texture_s    *anim_next;                // in the animation sequence
+	struct texture_s    *alternate_anims;          // bmodels in frmae 1 use these
+	unsigned             offsets[MIPLEVELS];       // four mip maps stored
 } texture_t;
 
 #define SURF_PLANEBACK      2
@@ -169,6 +170,10 @@ typedef struct msurface_s
 
 	int vbo_firstvert; // index of this surface's first vert in the VBO
 
+	// RT: teleport surfaces only, filled by RT_ParseTeleports
+	vec3_t rtcenter; // model space center of the bounds
+	int    rtportal; // 1 + nearest portal when the model is not moved, 0 if not associated
+
 	// lighting info
 	int          dlightframe;
 	unsigned int dlightbits[(MAX_DLIGHTS + 31) >> 5];
@@ -374,10 +379,10 @@ typedef struct
 #define MAXALIASVERTS  2000 // johnfitz -- was 1024
 #define MAXALIASFRAMES 256
 #define MAXALIASTRIS   4096 // ericw -- was 2048
-extern aliashdr_t *pheader;
-extern stvert_t    stverts[MAXALIASVERTS];
-extern mtriangle_t triangles[MAXALIASTRIS];
-extern trivertx_t *poseverts[MAXALIASFRAMES];
+extern THREAD_LOCAL aliashdr_t *pheader;
+extern THREAD_LOCAL stvert_t    stverts[MAXALIASVERTS];
+extern THREAD_LOCAL mtriangle_t triangles[MAXALIASTRIS];
+extern THREAD_LOCAL trivertx_t *poseverts[MAXALIASFRAMES];
 
 //===================================================================
 
@@ -417,9 +422,12 @@ struct glheapnode_s;
 typedef struct qmodel_s
 {
 	char         name[MAX_QPATH];
-	unsigned int path_id;  // path id of the game directory
-	                       // that this model came from
-	qboolean     needload; // bmodels and sprites don't cache normally
+	unsigned int path_id;   // path id of the game directory
+	                        // that this model came from
+	qboolean     needload;  // bmodels and sprites don't cache normally
+	filestamp_t  filestamp; // file the model was loaded from, checked before it's reused on another map
+	int          cacheseq;  // map sequence the model was last requested on, for the LRU eviction
+	uint64_t     owners;    // bit per server instance that requested the model since its last Mod_ClearAll
 
 	modtype_t  type;
 	int        numframes;
@@ -453,8 +461,9 @@ typedef struct qmodel_s
 	//
 	int firstmodelsurface, nummodelsurfaces;
 
-	int       numsubmodels;
-	dmodel_t *submodels;
+	int              numsubmodels;
+	dmodel_t        *submodels;
+	struct qmodel_s *inlinemodels; // [numsubmodels - 1] private copies of *1, *2, ... that stay valid while this world is loaded
 
 	int       numplanes;
 	mplane_t *planes;
@@ -495,6 +504,10 @@ typedef struct qmodel_s
 	int         numtextures;
 	texture_t **textures;
 
+	int                  numbrushbatches; // opaque surfaces prebuilt per texture and lightmap, see GL_BuildBModelVertexBuffer
+	struct brushbatch_s *brushbatches;
+	int                  brushbatchgen; // valid while equal to rt_brushbatchgen
+
 	byte *visdata;
 	byte *lightdata;
 	char *entities;
@@ -507,8 +520,9 @@ typedef struct qmodel_s
 	//
 	// alias model
 	//
-	uint32_t *rtindices;	// hdr->numindexes
-	RgVertex *rtvertices;	// hdr->numposes * hdr->numverts_vbo
+	uint32_t   *rtindices;   // hdr->numindexes
+	trivertx_t *rtposes;     // hdr->numposes * hdr->numverts_vbo, in vbo vertex order, expanded when drawn
+	float      *rttexcoords; // hdr->numverts_vbo * 2, same in all poses
 
 	//
 	// additional model data
@@ -521,8 +535,11 @@ typedef struct qmodel_s
 
 void      Mod_Init (void);
 void      Mod_ClearAll (void);
+void      Mod_SetOwner (int owner); // server instance that models are requested for, see Mod_ClearAll
 void      Mod_ResetAll (void); // for gamedir changes (Host_Game_f)
 qmodel_t *Mod_ForName (const char *name, qboolean crash);
+void      Mod_ForNames (const char **names, qmodel_t **models, int count, qboolean crash);
+void      Mod_PrintCacheStats (void);
 void	 *Mod_Extradata (qmodel_t *mod); // handles caching
 void      Mod_TouchModel (const char *name);
 
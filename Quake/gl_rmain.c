@@ -37,6 +37,8 @@ qboolean    rt_lavaeffects = false;
 // johnfitz -- rendering statistics
 atomic_uint32_t rs_brushpolys, rs_aliaspolys, rs_skypolys, rs_particles, rs_fogpolys;
 atomic_uint32_t rs_dynamiclightmaps, rs_brushpasses, rs_aliaspasses, rs_skypasses;
+atomic_uint32_t rs_aliasposelookups, rs_aliasposehits;
+atomic_uint32_t rs_brushbatchreuses, rs_brushbatchrebuilds;
 
 //
 // view origin
@@ -108,6 +110,13 @@ cvar_t r_gpulightmapupdate = {"r_gpulightmapupdate", "0", CVAR_NONE};
 
 cvar_t r_tasks = {"r_tasks", "0", CVAR_NONE};
 
+static int r_cullframe; // bumped by R_CullVisEdicts, never reset so that entity_t::cullframe can't match a stale pass
+#ifdef USE_SSE2
+static soa_aabb_t *r_visedictboxes;
+static int         r_numvisedictboxes;
+#endif
+
+extern cvar_t rt_enable_pvs;
 extern cvar_t rt_dlight_intensity;
 extern cvar_t rt_dlight_radius;
 extern cvar_t rt_flashlight;
@@ -142,13 +151,11 @@ qboolean R_CullBox (vec3_t emins, vec3_t emaxs)
 }
 /*
 ===============
-R_CullModelForEntity -- johnfitz -- uses correct bounds based on rotation
+R_EntityBounds -- johnfitz -- uses correct bounds based on rotation
 ===============
 */
-qboolean R_CullModelForEntity (entity_t *e)
+static void R_EntityBounds (entity_t *e, vec3_t mins, vec3_t maxs)
 {
-	vec3_t mins, maxs;
-
 	if (e->angles[0] || e->angles[2]) // pitch or roll
 	{
 		VectorAdd (e->origin, e->model->rmins, mins);
@@ -164,10 +171,125 @@ qboolean R_CullModelForEntity (entity_t *e)
 		VectorAdd (e->origin, e->model->mins, mins);
 		VectorAdd (e->origin, e->model->maxs, maxs);
 	}
+}
+
+/*
+===============
+R_CullModelForEntity
+
+Entities in cl_visedicts were already tested by R_CullVisEdicts this frame
+===============
+*/
+qboolean R_CullModelForEntity (entity_t *e)
+{
+	vec3_t mins, maxs;
 
+	if (e->cullframe == r_cullframe)
+		return e->culled;
+
+	R_EntityBounds (e, mins, maxs);
 	return R_CullBox (mins, maxs);
 }
 
+#ifdef USE_SSE2
+/*
+===============
+R_CullBoxBlockSIMD
+
+Returns the lanes of a block of 8 SoA boxes that are at least partially inside the frustum
+===============
+*/
+static inline uint32_t R_CullBoxBlockSIMD (soa_aabb_t *box)
+{
+	uint32_t visible = 0xff;
+
+	for (int i = 0; i < 4 && visible; ++i)
+	{
+		const mplane_t *p = frustum + i;
+
+		// test the corner furthest along the normal, see R_CullBox
+		const int ofsx = (p->normal[0] < 0.0f) ? 0 : 8;
+		const int ofsy = (p->normal[1] < 0.0f) ? 16 : 24;
+		const int ofsz = (p->normal[2] < 0.0f) ? 32 : 40;
+
+		const __m128 px = _mm_set1_ps (p->normal[0]);
+		const __m128 py = _mm_set1_ps (p->normal[1]);
+		const __m128 pz = _mm_set1_ps (p->normal[2]);
+		const __m128 pd = _mm_set1_ps (p->dist);
+
+		__m128 v0 = _mm_mul_ps (_mm_loadu_ps ((*box) + ofsx), px);
+		__m128 v1 = _mm_mul_ps (_mm_loadu_ps ((*box) + ofsx + 4), px);
+		v0 = _mm_add_ps (v0, _mm_mul_ps (_mm_loadu_ps ((*box) + ofsy), py));
+		v1 = _mm_add_ps (v1, _mm_mul_ps (_mm_loadu_ps ((*box) + ofsy + 4), py));
+		v0 = _mm_add_ps (v0, _mm_mul_ps (_mm_loadu_ps ((*box) + ofsz), pz));
+		v1 = _mm_add_ps (v1, _mm_mul_ps (_mm_loadu_ps ((*box) + ofsz + 4), pz));
+
+		visible &= (uint32_t)(_mm_movemask_ps (_mm_cmple_ps (pd, v0)) | (_mm_movemask_ps (_mm_cmple_ps (pd, v1)) << 4));
+	}
+
+	return visible;
+}
+#endif // def USE_SSE2
+
+/*
+===============
+R_CullVisEdicts
+
+Frustum culls the bounds of all entities in cl_visedicts in one pass, 8 at a time
+with SIMD. The draw functions pick the result up through R_CullModelForEntity.
+===============
+*/
+static void R_CullVisEdicts (void *unused)
+{
+	int    i;
+	vec3_t mins, maxs;
+
+	// entities not tested in this pass, e.g. the view model, fall back to R_CullBox
+	++r_cullframe;
+
+	if (!CVAR_TO_BOOL (rt_enable_pvs) || !r_drawentities.value)
+		return;
+
+#ifdef USE_SSE2
+	if (use_simd)
+	{
+		const int numblocks = (cl_numvisedicts + 7) / 8;
+		if (numblocks > r_numvisedictboxes)
+		{
+			r_numvisedictboxes = q_max (numblocks, r_numvisedictboxes * 2);
+			r_visedictboxes = Mem_Realloc (r_visedictboxes, r_numvisedictboxes * sizeof (soa_aabb_t));
+		}
+
+		for (i = 0; i < cl_numvisedicts; ++i)
+		{
+			R_EntityBounds (cl_visedicts[i], mins, maxs);
+			SoA_FillBoxLane (r_visedictboxes, i, mins, maxs);
+		}
+
+		for (int block = 0; block < numblocks; ++block)
+		{
+			const uint32_t visible = R_CullBoxBlockSIMD (&r_visedictboxes[block]);
+			const int      numlanes = q_min (8, cl_numvisedicts - block * 8);
+			for (int lane = 0; lane < numlanes; ++lane)
+			{
+				entity_t *e = cl_visedicts[block * 8 + lane];
+				e->culled = !(visible & (1u << lane));
+				e->cullframe = r_cullframe;
+			}
+		}
+		return;
+	}
+#endif // def USE_SSE2
+
+	for (i = 0; i < cl_numvisedicts; ++i)
+	{
+		entity_t *e = cl_visedicts[i];
+		R_EntityBounds (e, mins, maxs);
+		e->culled = R_CullBox (mins, maxs);
+		e->cullframe = r_cullframe;
+	}
+}
+
 /*
 ===============
 R_RotateForEntity -- johnfitz -- modified to take origin and angles instead of pointer to entity
@@ -707,10 +829,9 @@ draw bounding boxes -- the server-side boxes, not the renderer cullboxes
 */
 void R_ShowBoundingBoxes (cb_context_t *cbx)
 {
-	extern edict_t *sv_player;
-	vec3_t          mins, maxs;
-	edict_t        *ed;
-	int             i;
+	vec3_t   mins, maxs;
+	edict_t *ed;
+	int      i;
 
 	if (!r_showbboxes.value || cl.maxclients > 1 || !r_drawentities.value || !sv.active)
 		return;
@@ -720,8 +841,8 @@ void R_ShowBoundingBoxes (cb_context_t *cbx)
 	PR_SwitchQCVM (&sv.qcvm);
 	for (i = 0, ed = NEXT_EDICT (qcvm->edicts); i < qcvm->num_edicts; i++, ed = NEXT_EDICT (ed))
 	{
-		if (ed == sv_player)
-			continue; // don't draw player's own bbox
+		if (ed == svs.clients[0].edict)
+			continue; // don't draw player's own bbox (sv_player is per thread, this runs on a task)
 
 		if (ed->v.mins[0] == ed->v.maxs[0] && ed->v.mins[1] == ed->v.maxs[1] && ed->v.mins[2] == ed->v.maxs[2])
 		{
@@ -826,6 +947,8 @@ void R_DrawWorldTask (int index, void *unused)
 	R_SetupContext (cbx);
 	Fog_EnableGFog (cbx);
 	R_DrawWorld (cbx, index);
+	if (index == 0)
+		Sky_UploadStaticWorld (cbx);
 
 	r = rgSubmitStaticGeometries (vulkan_globals.instance);
 	RG_CHECK (r);
@@ -934,11 +1057,15 @@ void R_RenderView (qboolean use_tasks, task_handle_t begin_rendering_task, task_
 		Atomic_StoreUInt32 (&rs_aliaspasses, 0u);
 		Atomic_StoreUInt32 (&rs_skypasses, 0u);
 		Atomic_StoreUInt32 (&rs_brushpasses, 0u);
+		Atomic_StoreUInt32 (&rs_aliasposelookups, 0u);
+		Atomic_StoreUInt32 (&rs_aliasposehits, 0u);
+		Atomic_StoreUInt32 (&rs_brushbatchreuses, 0u);
+		Atomic_StoreUInt32 (&rs_brushbatchrebuilds, 0u);
 	}
 
 	if (use_tasks)
 	{
-		task_handle_t before_mark = Task_AllocateAndAssignFunc (R_SetupViewBeforeMark, NULL, 0);
+		task_handle_t before_mark = Task_AllocateAndAssignFunc ("R_SetupViewBeforeMark", R_SetupViewBeforeMark, NULL, 0);
 		Task_AddDependency (setup_frame_task, before_mark);
 
 		task_handle_t store_efrags = INVALID_TASK_HANDLE;
@@ -946,44 +1073,47 @@ void R_RenderView (qboolean use_tasks, task_handle_t begin_rendering_task, task_
 		task_handle_t chain_surfaces = INVALID_TASK_HANDLE;
 		R_MarkSurfaces (use_tasks, before_mark, &store_efrags, &cull_surfaces, &chain_surfaces);
 
-		task_handle_t draw_world_task = Task_AllocateAndAssignIndexedFunc (R_DrawWorldTask, NUM_WORLD_CBX, NULL, 0);
+		task_handle_t draw_world_task = Task_AllocateAndAssignIndexedFunc ("R_DrawWorldTask", R_DrawWorldTask, NUM_WORLD_CBX, NULL, 0);
 		Task_AddDependency (chain_surfaces, draw_world_task);
 		Task_AddDependency (begin_rendering_task, draw_world_task);
 		Task_AddDependency (draw_world_task, draw_done_task);
 
-		task_handle_t draw_sky_and_water_task = Task_AllocateAndAssignFunc (R_DrawSkyAndWaterTask, NULL, 0);
-		Task_AddDependency (store_efrags, draw_sky_and_water_task);
+		task_handle_t cull_entities_task = Task_AllocateAndAssignFunc ("R_CullVisEdicts", R_CullVisEdicts, NULL, 0);
+		Task_AddDependency (store_efrags, cull_entities_task);
+
+		task_handle_t draw_sky_and_water_task = Task_AllocateAndAssignFunc ("R_DrawSkyAndWaterTask", R_DrawSkyAndWaterTask, NULL, 0);
+		Task_AddDependency (cull_entities_task, draw_sky_and_water_task);
 		Task_AddDependency (chain_surfaces, draw_sky_and_water_task);
 		Task_AddDependency (begin_rendering_task, draw_sky_and_water_task);
 		Task_AddDependency (draw_sky_and_water_task, draw_done_task);
 
-		task_handle_t draw_view_model_task = Task_AllocateAndAssignFunc (R_DrawViewModelTask, NULL, 0);
-		Task_AddDependency (before_mark, draw_view_model_task);
+		task_handle_t draw_view_model_task = Task_AllocateAndAssignFunc ("R_DrawViewModelTask", R_DrawViewModelTask, NULL, 0);
+		Task_AddDependency (cull_entities_task, draw_view_model_task); // R_ShowTris culls the entities too
 		Task_AddDependency (begin_rendering_task, draw_view_model_task);
 		Task_AddDependency (draw_view_model_task, draw_done_task);
 
-		task_handle_t draw_entities_task = Task_AllocateAndAssignIndexedFunc (R_DrawEntitiesTask, NUM_ENTITIES_CBX, NULL, 0);
-		Task_AddDependency (store_efrags, draw_entities_task);
+		task_handle_t draw_entities_task = Task_AllocateAndAssignIndexedFunc ("R_DrawEntitiesTask", R_DrawEntitiesTask, NUM_ENTITIES_CBX, NULL, 0);
+		Task_AddDependency (cull_entities_task, draw_entities_task);
 		Task_AddDependency (begin_rendering_task, draw_entities_task);
 		Task_AddDependency (draw_entities_task, draw_done_task);
 
-		task_handle_t draw_alpha_entities_task = Task_AllocateAndAssignFunc (R_DrawAlphaEntitiesTask, NULL, 0);
-		Task_AddDependency (store_efrags, draw_alpha_entities_task);
+		task_handle_t draw_alpha_entities_task = Task_AllocateAndAssignFunc ("R_DrawAlphaEntitiesTask", R_DrawAlphaEntitiesTask, NULL, 0);
+		Task_AddDependency (cull_entities_task, draw_alpha_entities_task);
 		Task_AddDependency (begin_rendering_task, draw_alpha_entities_task);
 		Task_AddDependency (draw_alpha_entities_task, draw_done_task);
 
-		task_handle_t draw_particles_task = Task_AllocateAndAssignFunc (R_DrawParticlesTask, NULL, 0);
+		task_handle_t draw_particles_task = Task_AllocateAndAssignFunc ("R_DrawParticlesTask", R_DrawParticlesTask, NULL, 0);
 		Task_AddDependency (before_mark, draw_particles_task);
 		Task_AddDependency (begin_rendering_task, draw_particles_task);
 		Task_AddDependency (draw_particles_task, draw_done_task);
 
-		task_handle_t update_lightmaps_task = Task_AllocateAndAssignFunc (R_UpdateLightmaps, NULL, 0);
+		task_handle_t update_lightmaps_task = Task_AllocateAndAssignFunc ("R_UpdateLightmaps", R_UpdateLightmaps, NULL, 0);
 		Task_AddDependency (cull_surfaces, update_lightmaps_task);
 		Task_AddDependency (begin_rendering_task, update_lightmaps_task);
 		Task_AddDependency (update_lightmaps_task, draw_done_task);
 
 		// RT: no need for draw_world_task, as it's done on R_NewMap
-		task_handle_t tasks[] = {before_mark,          store_efrags,		                         draw_world_task,     draw_sky_and_water_task,
+		task_handle_t tasks[] = {before_mark,          store_efrags,       cull_entities_task,       draw_world_task,     draw_sky_and_water_task,
 		                         draw_view_model_task, draw_entities_task, draw_alpha_entities_task, draw_particles_task, update_lightmaps_task};
 		Tasks_Submit ((sizeof (tasks) / sizeof (task_handle_t)), tasks);
 		if (store_efrags != cull_surfaces)
@@ -996,6 +1126,7 @@ void R_RenderView (qboolean use_tasks, task_handle_t begin_rendering_task, task_
 	{
 		R_SetupViewBeforeMark (NULL);
 		R_MarkSurfaces (use_tasks, INVALID_TASK_HANDLE, NULL, NULL, NULL); // johnfitz -- create texture chains from PVS
+		R_CullVisEdicts (NULL);
 		R_DrawWorldTask (0, NULL);
 		R_DrawSkyAndWaterTask (NULL);
 		for (int i = 0; i < NUM_ENTITIES_CBX; ++i)
@@ -1017,9 +1148,12 @@ void R_RenderView (qboolean use_tasks, task_handle_t begin_rendering_task, task_
 			(int)cl.entities[cl.viewentity].origin[2], (int)cl.viewangles[PITCH], (int)cl.viewangles[YAW], (int)cl.viewangles[ROLL]);
 	else if (r_speeds.value == 2)
 		Con_Printf (
-			"%6.3f ms  %4u/%4u wpoly %4u/%4u epoly %3u lmap %4u/%4u sky\n", (time2 - time1) * 1000.0, rs_brushpolys, rs_brushpasses, rs_aliaspolys,
-			rs_aliaspasses, rs_dynamiclightmaps, rs_skypolys, rs_skypasses);
+			"%6.3f ms  %4u/%4u wpoly %4u/%4u epoly %3u lmap %4u/%4u sky %4u/%4u pose %4u/%4u chain\n", (time2 - time1) * 1000.0, rs_brushpolys,
+			rs_brushpasses, rs_aliaspolys, rs_aliaspasses, rs_dynamiclightmaps, rs_skypolys, rs_skypasses, rs_aliasposehits, rs_aliasposelookups,
+			rs_brushbatchreuses, rs_brushbatchreuses + rs_brushbatchrebuilds);
 	else if (r_speeds.value)
-		Con_Printf ("%3i ms  %4i wpoly %4i epoly %3i lmap\n", (int)((time2 - time1) * 1000), rs_brushpolys, rs_aliaspolys, rs_dynamiclightmaps);
+		Con_Printf (
+			"%3i ms  %4i wpoly %4i epoly %3i lmap %3i%% pose\n", (int)((time2 - time1) * 1000), rs_brushpolys, rs_aliaspolys, rs_dynamiclightmaps,
+			rs_aliasposelookups ? (int)(100 * rs_aliasposehits / rs_aliasposelookups) : 0);
 	// johnfitz
 }
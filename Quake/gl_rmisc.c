@@ -46,7 +46,9 @@ extern cvar_t gl_zfix; // QuakeSpasm z-fighting fix
 extern cvar_t r_gpulightmapupdate;
 extern cvar_t r_tasks;
 extern cvar_t r_parallelmark;
+extern cvar_t r_parallelmarkgrain;
 extern cvar_t r_usesops;
+extern cvar_t r_aliasposecache;
 
 extern cvar_t rt_elight_normaliz;
 
@@ -185,6 +187,7 @@ R_Init
 void R_Init (void)
 {
 	Cmd_AddCommand ("timerefresh", R_TimeRefresh_f);
+	Cmd_AddCommand ("r_markbenchmark", R_MarkSurfacesBenchmark_f);
 	Cmd_AddCommand ("pointfile", R_ReadPointFile_f);
 
 	Cvar_RegisterVariable (&r_fullbright);
@@ -233,9 +236,12 @@ void R_Init (void)
 	Cvar_RegisterVariable (&r_gpulightmapupdate);
 	Cvar_RegisterVariable (&r_tasks);
 	Cvar_RegisterVariable (&r_parallelmark);
+	Cvar_RegisterVariable (&r_parallelmarkgrain);
 	Cvar_RegisterVariable (&r_usesops);
+	Cvar_RegisterVariable (&r_aliasposecache);
 
 	R_InitParticles ();
+	R_InitAliasPoseCache ();
 
 	Sky_Init (); // johnfitz
 	Fog_Init (); // johnfitz
@@ -403,6 +409,7 @@ void R_NewMap (void)
 
 	GL_BuildLightmaps ();
 	GL_BuildBModelVertexBuffer ();
+	RT_BuildWorldLights ();
 	// RT: submit world geometry once
 	{
 		Atomic_StoreUInt32 (&rt_require_static_submit, true);
@@ -411,6 +418,7 @@ void R_NewMap (void)
 	// ericw -- no longer load alias models into a VBO here, it's done in Mod_LoadAliasModel
 
 	r_framecount = 0;    // johnfitz -- paranoid?
+	R_ClearAliasPoseCache ();
 	r_visframecount = 0; // johnfitz -- paranoid?
 
 	Sky_NewMap ();        // johnfitz -- skybox in worldspawn
@@ -1116,10 +1116,10 @@ void SCR_UpdateScreen (qboolean use_tasks)
 			prev_end_rendering_task = INVALID_TASK_HANDLE;
 		}
 
-		task_handle_t draw_done_task = Task_AllocateAndAssignFunc (SCR_DrawDone, NULL, 0);
-		task_handle_t setup_frame_task = Task_AllocateAndAssignFunc (SCR_SetupFrame, NULL, 0);
+		task_handle_t draw_done_task = Task_AllocateAndAssignFunc ("SCR_DrawDone", SCR_DrawDone, NULL, 0);
+		task_handle_t setup_frame_task = Task_AllocateAndAssignFunc ("SCR_SetupFrame", SCR_SetupFrame, NULL, 0);
 		V_RenderView (use_tasks, begin_rendering_task, setup_frame_task, draw_done_task);
-		task_handle_t draw_gui_task = Task_AllocateAndAssignFunc (SCR_DrawGUI, NULL, 0);
+		task_handle_t draw_gui_task = Task_AllocateAndAssignFunc ("SCR_DrawGUI", SCR_DrawGUI, NULL, 0);
 		task_handle_t end_rendering_task = GL_EndRendering (use_tasks, true);
 
 		Task_AddDependency (begin_rendering_task, draw_gui_task);
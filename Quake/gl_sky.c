@@ -76,6 +76,13 @@ typedef struct
 } skylayervertex_t;
 
 extern cvar_t rt_enable_pvs;
+extern cvar_t rt_brush_metal;
+extern cvar_t rt_brush_rough;
+
+extern RgVertex       *rtallbrushvertices;
+extern atomic_uint32_t rt_require_static_submit;
+
+static float sky_static_color[3]; // sky color of the last static world submit
 
 typedef struct
 {
@@ -631,47 +638,142 @@ void Sky_ClipPoly (int nump, vec3_t vecs, int stage)
 
 #endif // RT_SKY_CULLING
 
+#if RT_SKY_CULLING
 /*
 ================
-Sky_ProcessPoly
+Sky_UpdateBounds
 ================
 */
-static void Sky_ProcessPoly (cb_context_t *cbx, glpoly_t *p, float color[3], uint64_t uniqueid)
+static void Sky_UpdateBounds (glpoly_t *p)
 {
-	const static RgTransform tr = RT_TRANSFORM_IDENTITY;
-
-	// draw it
-	DrawGLPoly (cbx, uniqueid, p, color, 1.0f, &tr, NULL, DRAW_GL_POLY_TYPE_SKY);
-	Atomic_IncrementUInt32 (&rs_brushpasses);
-
-#if RT_SKY_CULLING
 	int    i;
 	vec3_t verts[MAX_CLIP_VERTS];
 	float *poly_vert;
 
-	// update sky bounds
-	if (!CVAR_TO_BOOL(r_fastsky))
+	if (CVAR_TO_BOOL (r_fastsky))
+		return;
+
+	for (i = 0; i < p->numverts; i++)
 	{
-		for (i = 0; i < p->numverts; i++)
-		{
-			poly_vert = &p->verts[0][0] + (i * VERTEXSIZE);
-			VectorSubtract (poly_vert, r_origin, verts[i]);
-		}
-		Sky_ClipPoly (p->numverts, verts[0], 0);
+		poly_vert = &p->verts[0][0] + (i * VERTEXSIZE);
+		VectorSubtract (poly_vert, r_origin, verts[i]);
 	}
+	Sky_ClipPoly (p->numverts, verts[0], 0);
+}
 #endif // RT_SKY_CULLING
+
+/*
+================
+Sky_GetFlatColor
+
+color of the sky surfaces themselves: the fog color when there is fog, so that they blend into it
+================
+*/
+static void Sky_GetFlatColor (float color[3])
+{
+	float fog_color[4];
+
+	if (Fog_GetDensity () > 0)
+	{
+		Fog_GetColor (fog_color);
+		memcpy (color, fog_color, 3 * sizeof (float));
+	}
+	else
+		memcpy (color, skyflatcolor, 3 * sizeof (float));
 }
 
+typedef struct
+{
+	qmodel_t   *model;
+	int         entuniqueid;
+	qboolean    is_static;
+	RgTransform transform;
+	float       color[3];
+	msurface_t *first; // first surface of the pending batch, its id names the upload
+} skybatch_t;
+
 /*
 ================
-Sky_ProcessTextureChains -- handles sky polys in world model
+Sky_FlushBatch
+================
+*/
+static void Sky_FlushBatch (cb_context_t *cbx, skybatch_t *b)
+{
+	if (cbx->batch_indices_count > 0)
+	{
+		RgGeometryUploadInfo info = {
+			.uniqueID = RT_GetBrushSurfUniqueId (b->entuniqueid, b->model, b->first, 0),
+			.flags = RG_GEOMETRY_UPLOAD_GENERATE_NORMALS_BIT,
+			.geomType = b->is_static ? RG_GEOMETRY_TYPE_STATIC : RG_GEOMETRY_TYPE_DYNAMIC,
+			.passThroughType = RG_GEOMETRY_PASS_THROUGH_TYPE_OPAQUE,
+			.visibilityType = RG_GEOMETRY_VISIBILITY_TYPE_SKY,
+			.vertexCount = cbx->batch_verts_count,
+			.pVertices = cbx->batch_verts,
+			.indexCount = cbx->batch_indices_count,
+			.pIndices = cbx->batch_indices,
+			.layerColors = {{b->color[0], b->color[1], b->color[2], 1.0f}},
+			.layerBlendingTypes = {RG_GEOMETRY_MATERIAL_BLEND_TYPE_OPAQUE},
+			.geomMaterial = {RG_NO_MATERIAL},
+			.defaultRoughness = CVAR_TO_FLOAT (rt_brush_rough),
+			.defaultMetallicity = CVAR_TO_FLOAT (rt_brush_metal),
+			.defaultEmission = 0,
+			.transform = b->transform,
+		};
+
+		RgResult r = rgUploadGeometry (vulkan_globals.instance, &info);
+		RG_CHECK (r);
+
+		Atomic_IncrementUInt32 (&rs_brushpasses);
+	}
+
+	cbx->batch_verts_count = 0;
+	cbx->batch_indices_count = 0;
+	b->first = NULL;
+}
+
+/*
+================
+Sky_BatchSurface
+
+appends the model space vertices of s, as built by GL_BuildBModelVertexBuffer
+================
+*/
+static void Sky_BatchSurface (cb_context_t *cbx, skybatch_t *b, msurface_t *s)
+{
+	const int num_surf_verts = s->numedges;
+	const int num_surf_indices = R_NumTriangleIndicesForSurf (num_surf_verts);
+
+	if (cbx->batch_indices_count + num_surf_indices > MAX_BATCH_INDICES || cbx->batch_verts_count + num_surf_verts > MAX_BATCH_VERTS)
+		Sky_FlushBatch (cbx, b);
+
+	if (!b->first)
+		b->first = s;
+
+	R_TriangleIndicesForSurf (cbx->batch_verts_count, num_surf_verts, &cbx->batch_indices[cbx->batch_indices_count]);
+	memcpy (&cbx->batch_verts[cbx->batch_verts_count], rtallbrushvertices + s->vbo_firstvert, sizeof (RgVertex) * num_surf_verts);
+
+	cbx->batch_indices_count += num_surf_indices;
+	cbx->batch_verts_count += num_surf_verts;
+}
+
+/*
+================
+Sky_UploadStaticWorld
+
+Uploads the world's sky surfaces as static geometry, called from R_DrawWorldTask
+between rgBeginStaticGeometries and rgSubmitStaticGeometries. The world never
+moves, so these stay valid until the next static submit.
 ================
 */
-void Sky_ProcessTextureChains (cb_context_t *cbx, float color[3])
+void Sky_UploadStaticWorld (cb_context_t *cbx)
 {
 	int         i;
 	msurface_t *s;
 	texture_t  *t;
+	skybatch_t  b = {.model = cl.worldmodel, .entuniqueid = ENT_UNIQUEID_WORLD, .is_static = true, .transform = RT_TRANSFORM_IDENTITY};
+
+	Sky_GetFlatColor (b.color);
+	memcpy (sky_static_color, b.color, sizeof (sky_static_color));
 
 	if (!r_drawworld_cheatsafe)
 		return;
@@ -684,57 +786,62 @@ void Sky_ProcessTextureChains (cb_context_t *cbx, float color[3])
 			continue;
 
 		for (s = t->texturechains[chain_world]; s; s = s->texturechains[chain_world])
-		{
-			Sky_ProcessPoly (cbx, s->polys, color, RT_GetBrushSurfUniqueId (ENT_UNIQUEID_WORLD, cl.worldmodel, s, 0));
-		}
+			Sky_BatchSurface (cbx, &b, s);
 	}
+
+	Sky_FlushBatch (cbx, &b);
 }
 
 /*
 ================
-Sky_DrawSkySurface
+Sky_ProcessTextureChains -- handles sky polys in world model
+
+the world's sky is static geometry, uploaded by Sky_UploadStaticWorld; this only
+asks for a new static submit when the fog changed the sky color for good
 ================
 */
-static void Sky_DrawSkySurface (cb_context_t *cbx, float color[3], int entuniqueid, entity_t *e, qmodel_t *model, msurface_t *s, qboolean rotated, vec3_t forward, vec3_t right, vec3_t up)
+static void Sky_ProcessTextureChains (float color[3])
 {
-	// copy the polygon and translate manually, since Sky_ProcessPoly needs it to be in world space
-	glpoly_t *p;
-	TEMP_ALLOC (glpoly_t, p, s->polys->numverts);
-	p->numverts = s->polys->numverts;
-	for (int k = 0; k < p->numverts; k++)
+	if (!r_drawworld_cheatsafe)
+		return;
+
+	if (!Fog_IsFading () && memcmp (color, sky_static_color, sizeof (sky_static_color)))
+		Atomic_StoreUInt32 (&rt_require_static_submit, true);
+
+#if RT_SKY_CULLING
+	int         i;
+	msurface_t *s;
+	texture_t  *t;
+
+	for (i = 0; i < cl.worldmodel->numtextures; i++)
 	{
-		if (rotated)
-		{
-			p->verts[k][0] = e->origin[0] + s->polys->verts[k][0] * forward[0] - s->polys->verts[k][1] * right[0] + s->polys->verts[k][2] * up[0];
-			p->verts[k][1] = e->origin[1] + s->polys->verts[k][0] * forward[1] - s->polys->verts[k][1] * right[1] + s->polys->verts[k][2] * up[1];
-			p->verts[k][2] = e->origin[2] + s->polys->verts[k][0] * forward[2] - s->polys->verts[k][1] * right[2] + s->polys->verts[k][2] * up[2];
-		}
-		else
-		{
-			float *s_poly_vert = &s->polys->verts[0][0] + (k * VERTEXSIZE);
-			float *poly_vert = &p->verts[0][0] + (k * VERTEXSIZE);
-			VectorAdd (s_poly_vert, e->origin, poly_vert);
-		}
-	}
+		t = cl.worldmodel->textures[i];
 
-	Sky_ProcessPoly (cbx, p, color, RT_GetBrushSurfUniqueId (entuniqueid, model, s, 0));
-	TEMP_FREE (p);
+		if (!t || !t->texturechains[chain_world] || !(t->texturechains[chain_world]->flags & SURF_DRAWSKY))
+			continue;
+
+		for (s = t->texturechains[chain_world]; s; s = s->texturechains[chain_world])
+			Sky_UpdateBounds (s->polys);
+	}
+#endif // RT_SKY_CULLING
 }
 
 /*
 ================
 Sky_ProcessEntities -- handles sky polys on brush models
+
+all front facing sky surfaces of an entity go out as one dynamic upload
 ================
 */
-void Sky_ProcessEntities (cb_context_t *cbx, float color[3])
+static void Sky_ProcessEntities (cb_context_t *cbx, float color[3])
 {
 	entity_t   *e;
 	msurface_t *s;
 	int         i, j;
 	float       dot;
-	qboolean    rotated;
 	vec3_t      temp, forward, right, up;
 	vec3_t      modelorg;
+	skybatch_t  b;
 
 	if (!r_drawentities.value)
 		return;
@@ -758,15 +865,19 @@ void Sky_ProcessEntities (cb_context_t *cbx, float color[3])
 		VectorSubtract (r_refdef.vieworg, e->origin, modelorg);
 		if (e->angles[0] || e->angles[1] || e->angles[2])
 		{
-			rotated = true;
 			AngleVectors (e->angles, forward, right, up);
 			VectorCopy (modelorg, temp);
 			modelorg[0] = DotProduct (temp, forward);
 			modelorg[1] = -DotProduct (temp, right);
 			modelorg[2] = DotProduct (temp, up);
 		}
-		else
-			rotated = false;
+
+		b.model = e->model;
+		b.entuniqueid = i;
+		b.is_static = false;
+		b.transform = RT_GetBrushModelMatrix (e);
+		b.first = NULL;
+		memcpy (b.color, color, sizeof (b.color));
 
 		s = &e->model->surfaces[e->model->firstmodelsurface];
 
@@ -776,11 +887,11 @@ void Sky_ProcessEntities (cb_context_t *cbx, float color[3])
 			{
 				dot = DotProduct (modelorg, s->plane->normal) - s->plane->dist;
 				if (((s->flags & SURF_PLANEBACK) && (dot < -BACKFACE_EPSILON)) || (!(s->flags & SURF_PLANEBACK) && (dot > BACKFACE_EPSILON)))
-				{
-					Sky_DrawSkySurface (cbx, color, i, e, e->model, s, rotated, forward, right, up);
-				}
+					Sky_BatchSurface (cbx, &b, s);
 			}
 		}
+
+		Sky_FlushBatch (cbx, &b);
 	}
 }
 
@@ -975,7 +1086,7 @@ void Sky_DrawFaceQuad (cb_context_t *cbx, glpoly_t *p, float alpha)
 		if (batch->verts_count + indexcount >= batch->verts_allocated)
 		{
 			batch->verts_allocated += 1024;
-			batch->verts = Mem_Realloc (batch->verts, sizeof (RgVertex) * batch->verts_allocated);
+			batch->verts = Mem_ReallocTagged (batch->verts, sizeof (RgVertex) * batch->verts_allocated, MEMTAG_RT);
 		}
 
 
@@ -997,7 +1108,6 @@ void Sky_DrawFaceQuad (cb_context_t *cbx, glpoly_t *p, float alpha)
 		batch->verts_count += indexcount;
 	}
 
-	Atomic_IncrementUInt32 (&rs_skypolys);
 	Atomic_IncrementUInt32 (&rs_skypasses);
 }
 
@@ -1136,13 +1246,10 @@ void Sky_DrawSky (cb_context_t *cbx)
 	//
 	Fog_DisableGFog (cbx);
 
-	float color[4];
-	if (Fog_GetDensity () > 0)
-		Fog_GetColor (color);
-	else
-		memcpy (color, skyflatcolor, 3 * sizeof (float));
+	float color[3];
+	Sky_GetFlatColor (color);
 
-	Sky_ProcessTextureChains (cbx, color);
+	Sky_ProcessTextureChains (color);
 	Sky_ProcessEntities (cbx, color);
 
 	//
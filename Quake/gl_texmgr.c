@@ -1149,6 +1149,7 @@ gltexture_t *TexMgr_LoadImage (
 	}
 
 	// upload it
+	const memtag_t prev_tag = Mem_SetTag (MEMTAG_TEXTURE);
 	switch (glt->source_format)
 	{
 	case SRC_INDEXED:
@@ -1162,6 +1163,7 @@ gltexture_t *TexMgr_LoadImage (
 		TexMgr_LoadImage32 (glt, (unsigned *)data);
 		break;
 	}
+	Mem_SetTag (prev_tag);
 
 	RT_FillWithTextureCustomInfo (glt);
 
@@ -110,6 +110,7 @@ task_handle_t prev_end_rendering_task = INVALID_TASK_HANDLE;
 	\
 	CVAR_DEF_T (rt_plight_intensity, "3.0") \
 	CVAR_DEF_T (rt_plight_radius, "0.02") \
+	CVAR_DEF_T (rt_plight_budget, "256") \
 	\
 	CVAR_DEF_T (rt_wlight_intensity, "3.0") \
 	CVAR_DEF_T (rt_wlight_radius, "0.01") \
@@ -699,19 +700,20 @@ static void GL_InitInstance (void)
 	Cmd_AddCommand ("rt_pfnwlight_add", RT_CustomLights_AddCmd);
 	Cmd_AddCommand ("rt_pfnwlight_remove", RT_CustomLights_RemoveCmd);
 	Cmd_AddCommand ("rt_pfnportal", RT_PrintNearestPortal);
+	Cmd_AddCommand ("rt_pfnplights", RT_PrintWorldLights_f);
 	Cmd_AddCommand ("rt_water_color", RT_WaterColor);
 	Cmd_AddCommand ("rt_water_acidcolor", RT_AcidColor);
 	Cvar_SetValueQuick (&_rt_firsttime, 0);
 
 
-    vulkan_globals.primary_cb_context.batch_indices = Mem_Alloc (sizeof (uint32_t) * MAX_BATCH_INDICES);
-	vulkan_globals.primary_cb_context.batch_verts = Mem_Alloc (sizeof (RgVertex) * MAX_BATCH_VERTS);
+    vulkan_globals.primary_cb_context.batch_indices = Mem_AllocTagged (sizeof (uint32_t) * MAX_BATCH_INDICES, MEMTAG_RT);
+	vulkan_globals.primary_cb_context.batch_verts = Mem_AllocTagged (sizeof (RgVertex) * MAX_BATCH_VERTS, MEMTAG_RT);
 	vulkan_globals.primary_cb_context.batch_verts_count = 0;
 	vulkan_globals.primary_cb_context.batch_indices_count = 0;
 	for (int i = 0; i < CBX_NUM; i++)
 	{
-		vulkan_globals.secondary_cb_contexts[i].batch_indices = Mem_Alloc (sizeof (uint32_t) * MAX_BATCH_INDICES);
-		vulkan_globals.secondary_cb_contexts[i].batch_verts = Mem_Alloc (sizeof (RgVertex) * MAX_BATCH_VERTS);
+		vulkan_globals.secondary_cb_contexts[i].batch_indices = Mem_AllocTagged (sizeof (uint32_t) * MAX_BATCH_INDICES, MEMTAG_RT);
+		vulkan_globals.secondary_cb_contexts[i].batch_verts = Mem_AllocTagged (sizeof (RgVertex) * MAX_BATCH_VERTS, MEMTAG_RT);
 		vulkan_globals.secondary_cb_contexts[i].batch_verts_count = 0;
 		vulkan_globals.secondary_cb_contexts[i].batch_indices_count = 0;
 	}
@@ -783,7 +785,7 @@ qboolean GL_BeginRendering (qboolean use_tasks, task_handle_t *begin_rendering_t
 	*height = vid.height;
 
 	if (use_tasks)
-		*begin_rendering_task = Task_AllocateAndAssignFunc (GL_BeginRenderingTask, NULL, 0);
+		*begin_rendering_task = Task_AllocateAndAssignFunc ("GL_BeginRenderingTask", GL_BeginRenderingTask, NULL, 0);
 	else
 		GL_BeginRenderingTask (NULL);
 
@@ -1269,7 +1271,7 @@ task_handle_t GL_EndRendering (qboolean use_tasks, qboolean swapchain)
 	};
 	task_handle_t end_rendering_task = INVALID_TASK_HANDLE;
 	if (use_tasks)
-		end_rendering_task = Task_AllocateAndAssignFunc ((task_func_t)GL_EndRenderingTask, &parms, sizeof (parms));
+		end_rendering_task = Task_AllocateAndAssignFunc ("GL_EndRenderingTask", (task_func_t)GL_EndRenderingTask, &parms, sizeof (parms));
 	else
 		GL_EndRenderingTask (&parms);
 	return end_rendering_task;
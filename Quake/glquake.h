@@ -61,6 +61,7 @@ extern int glx, gly, glwidth, glheight;
 #define LIGHTMAP_BYTES 4
 
 void       R_TimeRefresh_f (void);
+void       R_MarkSurfacesBenchmark_f (void);
 void       R_ReadPointFile_f (void);
 texture_t *R_TextureAnimation (texture_t *base, int frame);
 
@@ -249,6 +250,8 @@ extern cvar_t gl_nocolors;
 // johnfitz -- rendering statistics
 extern atomic_uint32_t rs_brushpolys, rs_aliaspolys, rs_skypolys, rs_particles, rs_fogpolys;
 extern atomic_uint32_t rs_dynamiclightmaps, rs_brushpasses, rs_aliaspasses, rs_skypasses;
+extern atomic_uint32_t rs_aliasposelookups, rs_aliasposehits;
+extern atomic_uint32_t rs_brushbatchreuses, rs_brushbatchrebuilds;
 
 extern size_t total_device_vulkan_allocation_size;
 extern size_t total_host_vulkan_allocation_size;
@@ -319,14 +322,15 @@ extern float map_fallbackalpha; // spike -- because we might want r_wateralpha t
 extern task_handle_t prev_end_rendering_task;
 
 // johnfitz -- fog functions called from outside gl_fog.c
-void  Fog_ParseServerMessage (void);
-void  Fog_GetColor (float *c);
-float Fog_GetDensity (void);
-void  Fog_EnableGFog (cb_context_t *cbx);
-void  Fog_DisableGFog (cb_context_t *cbx);
-void  Fog_SetupFrame (cb_context_t *cbx);
-void  Fog_NewMap (void);
-void  Fog_Init (void);
+void     Fog_ParseServerMessage (void);
+void     Fog_GetColor (float *c);
+float    Fog_GetDensity (void);
+qboolean Fog_IsFading (void);
+void     Fog_EnableGFog (cb_context_t *cbx);
+void     Fog_DisableGFog (cb_context_t *cbx);
+void     Fog_SetupFrame (cb_context_t *cbx);
+void     Fog_NewMap (void);
+void     Fog_Init (void);
 
 void R_NewGame (void);
 
@@ -348,7 +352,11 @@ void R_TranslatePlayerSkin (int playernum);
 void R_TranslateNewPlayerSkin (int playernum); // johnfitz -- this handles cases when the actual texture changes
 
 void R_DrawWorld (cb_context_t *cbx, int index);
+int  R_NumTriangleIndicesForSurf (int vertcount);
+void R_TriangleIndicesForSurf (int basevert, int vertcount, uint32_t *dest);
 void R_DrawAliasModel (cb_context_t *cbx, entity_t *e, int entuniqueid);
+void R_InitAliasPoseCache (void);
+void R_ClearAliasPoseCache (void);
 void R_DrawBrushModel (cb_context_t *cbx, entity_t *e, int chain, int entuniqueid);
 void R_DrawSpriteModel (cb_context_t *cbx, entity_t *e, int entuniqueid);
 
@@ -357,7 +365,52 @@ void R_DrawTextureChains_Water (cb_context_t *cbx, qmodel_t *model, entity_t *en
 void GL_BuildLightmaps (void);
 void GL_DeleteBModelVertexBuffer (void);
 void GL_BuildBModelVertexBuffer (void);
+
+typedef struct brushbatch_s
+{
+	int         texnum; // into model->textures
+	int         lightmaptexturenum;
+	msurface_t *firstsurf; // names the upload, like the first surface of a chained batch
+	int         numverts;
+	int         numindices;
+	RgVertex   *verts; // model space
+	uint32_t   *indices;
+} brushbatch_t;
+
+extern int rt_brushbatchgen;
+
+// the batches assembled from one texture chain, kept in the texture and reused
+// by the next frame while the chain holds the same surfaces in the same state
+typedef struct chainbatch_s
+{
+	msurface_t *surf; // names the upload
+	int         lightmaptexturenum;
+	float       alpha;
+	int         firstvert, numverts;
+	int         firstindex, numindices; // relative to firstvert
+} chainbatch_t;
+
+typedef struct chaincache_s
+{
+	uint64_t      key; // hash of the surfaces, their batch state and rt_brushbatchgen
+	int           numbatches, maxbatches;
+	int           numverts, maxverts;
+	int           numindices, maxindices;
+	chainbatch_t *batches;
+	RgVertex     *verts;
+	uint32_t     *indices;
+} chaincache_t;
+
+void R_FreeChainCaches (texture_t *t);
+
+static inline qboolean R_HasBrushBatches (const qmodel_t *m)
+{
+	return m->brushbatchgen == rt_brushbatchgen;
+}
+void R_DrawBrushBatches (cb_context_t *cbx, entity_t *ent, const float alpha, int entuniqueid);
 void GL_PrepareSIMDData (void);
+void SoA_FillBoxLane (soa_aabb_t *boxes, int index, vec3_t mins, vec3_t maxs);
+void SoA_FillPlaneLane (soa_plane_t *planes, int index, mplane_t *src, qboolean flip);
 void GLMesh_LoadVertexBuffers (void);
 void GLMesh_DeleteVertexBuffers (void);
 
@@ -380,7 +433,9 @@ void RT_CustomLights_Parse (void);
 void RT_CustomLights_SaveCmd (void);
 void RT_CustomLights_AddCmd (void);
 void RT_CustomLights_RemoveCmd (void);
+void RT_BuildWorldLights (void);
 void RT_UploadAllWorldModelLights (void);
+void RT_PrintWorldLights_f (void);
 
 void RT_ParseTeleports (void);
 void RT_UploadAllTeleports (void);
@@ -395,6 +450,7 @@ void GL_MakeAliasModelDisplayLists (qmodel_t *m, aliashdr_t *hdr);
 void Sky_Init (void);
 void Sky_ClearAll (void);
 void Sky_DrawSky (cb_context_t *cbx);
+void Sky_UploadStaticWorld (cb_context_t *cbx);
 void Sky_NewMap (void);
 void Sky_LoadTexture (qmodel_t *mod, texture_t *mt, int tex_index);
 void Sky_LoadTextureQ64 (qmodel_t *mod, texture_t *mt, int tex_index);
@@ -55,6 +55,19 @@ client_t *host_client; // current client
 jmp_buf host_abortserver;
 jmp_buf screen_error;
 
+// set while a task runs qc, see Host_RunTask
+static THREAD_LOCAL jmp_buf *host_taskabort;
+static THREAD_LOCAL char    *host_taskerror;
+static THREAD_LOCAL size_t   host_taskerrorsize;
+
+static task_handle_t csqc_physics_task = INVALID_TASK_HANDLE;
+static qboolean      csqc_physics_failed;
+static char          csqc_physics_error[1024];
+static double        csqc_physics_time; // spent in SV_Physics, on whatever thread ran it
+static double        csqc_physics_wait; // main thread blocked in Host_WaitForCSQCPhysics
+
+static qboolean Host_JoinCSQCPhysics (void);
+
 byte  *host_colormap;
 float  host_netinterval = 1.0 / 72;
 cvar_t host_framerate = {"host_framerate", "0", CVAR_NONE}; // set for slow motion
@@ -63,6 +76,7 @@ cvar_t host_maxfps = {"host_maxfps", "200", CVAR_ARCHIVE};  // johnfitz
 cvar_t host_timescale = {"host_timescale", "0", CVAR_NONE}; // johnfitz
 cvar_t max_edicts = {"max_edicts", "8192", CVAR_NONE};      // johnfitz //ericw -- changed from 2048 to 8192, removed CVAR_ARCHIVE
 cvar_t cl_nocsqc = {"cl_nocsqc", "0", CVAR_NONE};           // spike -- blocks the loading of any csqc modules
+cvar_t cl_csqc_tasks = {"cl_csqc_tasks", "0", CVAR_ARCHIVE}; // run csqc physics on a task while the client parses the server messages
 
 cvar_t sys_ticrate = {"sys_ticrate", "0.025", CVAR_NONE}; // dedicated server
 cvar_t serverprofile = {"serverprofile", "0", CVAR_NONE};
@@ -127,6 +141,20 @@ static void Max_Fps_f (cvar_t *var)
 	}
 }
 
+/*
+================
+Host_AbortTask
+
+Unwinds a task to its Host_RunTask, with the message for the main thread
+================
+*/
+static FUNC_NORETURN void Host_AbortTask (const char *message, va_list argptr)
+{
+	q_vsnprintf (host_taskerror, host_taskerrorsize, message, argptr);
+	va_end (argptr);
+	longjmp (*host_taskabort, 1);
+}
+
 /*
 ================
 Host_EndGame
@@ -137,12 +165,19 @@ void Host_EndGame (const char *message, ...)
 	va_list argptr;
 	char    string[1024];
 
+	if (host_taskabort)
+	{ // see Host_Error
+		va_start (argptr, message);
+		Host_AbortTask (message, argptr);
+	}
+
 	va_start (argptr, message);
 	q_vsnprintf (string, sizeof (string), message, argptr);
 	va_end (argptr);
 	Con_DPrintf ("Host_EndGame: %s\n", string);
 
 	PR_SwitchQCVM (NULL);
+	Host_JoinCSQCPhysics ();
 
 	if (sv.active)
 		Host_ShutdownServer (false);
@@ -171,11 +206,18 @@ void Host_Error (const char *error, ...)
 	char            string[1024];
 	static qboolean inerror = false;
 
+	if (host_taskabort)
+	{ // can't shut anything down from a worker
+		va_start (argptr, error);
+		Host_AbortTask (error, argptr);
+	}
+
 	if (inerror)
 		Sys_Error ("Host_Error: recursively entered");
 	inerror = true;
 
 	PR_SwitchQCVM (NULL);
+	Host_JoinCSQCPhysics (); // this error wins over one the task may have hit
 
 	SCR_EndLoadingPlaque (); // reenable screen updates
 
@@ -193,8 +235,8 @@ void Host_Error (const char *error, ...)
 	if (sv.active)
 		Host_ShutdownServer (false);
 
-	if (cls.state == ca_dedicated)
-		Sys_Error ("Host_Error: %s\n", string); // dedicated servers exit
+	if (cls.state == ca_dedicated && SV_NumInstances () == 1)
+		Sys_Error ("Host_Error: %s\n", string); // dedicated servers exit, unless other server instances are still running
 
 	CL_Disconnect ();
 	cls.demonum = -1;
@@ -271,6 +313,8 @@ void Host_Callback_Notify (cvar_t *var)
 		SV_BroadcastPrintf ("\"%s\" changed to \"%s\"\n", var->name, var->string);
 }
 
+extern cvar_t mem_framewarn;
+
 /*
 =======================
 Host_InitLocal
@@ -279,6 +323,10 @@ Host_InitLocal
 void Host_InitLocal (void)
 {
 	Cmd_AddCommand ("version", Host_Version_f);
+	Cmd_AddCommand ("tasks_benchmark", Tasks_Benchmark_f);
+	Cmd_AddCommand ("tasks_trace", Tasks_Trace_f);
+	Cmd_AddCommand ("memstats", Mem_Stats_f);
+	Cvar_RegisterVariable (&mem_framewarn);
 
 	Host_InitCommands ();
 
@@ -290,6 +338,7 @@ void Host_InitLocal (void)
 	Cvar_RegisterVariable (&host_timescale); // johnfitz
 
 	Cvar_RegisterVariable (&cl_nocsqc);  // spike
+	Cvar_RegisterVariable (&cl_csqc_tasks);
 	Cvar_RegisterVariable (&max_edicts); // johnfitz
 	Cvar_SetCallback (&max_edicts, Max_Edicts_f);
 	Cvar_RegisterVariable (&devstats); // johnfitz
@@ -315,6 +364,7 @@ void Host_InitLocal (void)
 	Cvar_RegisterVariable (&horde);
 
 	Cvar_RegisterVariable (&pausable);
+	Cvar_RegisterVariable (&sv_savebinary);
 
 	Cvar_RegisterVariable (&temp1);
 
@@ -581,6 +631,7 @@ not reinitialize anything.
 */
 void Host_ClearMemory (void)
 {
+	Host_WaitForCSQCPhysics ();
 	if (cl.qcvm.extfuncs.CSQC_Shutdown)
 	{
 		PR_SwitchQCVM (&cl.qcvm);
@@ -729,6 +780,7 @@ void Host_ServerFrame (void)
 
 static void CL_LoadCSProgs (void)
 {
+	Host_WaitForCSQCPhysics ();
 	PR_ClearProgs (&cl.qcvm);
 	if (pr_checkextension.value && !cl_nocsqc.value)
 	{ // only try to use csqc if qc extensions are enabled.
@@ -747,7 +799,7 @@ static void CL_LoadCSProgs (void)
 		    (PR_LoadProgs ("progs.dat", false, PROGHEADER_CRC, pr_csqcbuiltins, pr_csqcnumbuiltins) && qcvm->extfuncs.CSQC_DrawHud))
 		{
 			qcvm->max_edicts = CLAMP (MIN_EDICTS, (int)max_edicts.value, MAX_EDICTS);
-			qcvm->edicts = (edict_t *)Mem_Alloc (qcvm->max_edicts * qcvm->edict_size);
+			qcvm->edicts = (edict_t *)Mem_AllocTagged (qcvm->max_edicts * qcvm->edict_size, MEMTAG_EDICT);
 			qcvm->num_edicts = qcvm->reserved_edicts = 1;
 			memset (qcvm->edicts, 0, qcvm->num_edicts * qcvm->edict_size);
 
@@ -797,6 +849,114 @@ static void CL_LoadCSProgs (void)
 	}
 }
 
+/*
+==================
+Host_CSQCPhysics
+==================
+*/
+static void Host_CSQCPhysics (void *unused)
+{
+	const double start = Sys_DoubleTime ();
+
+	PR_SwitchQCVM (&cl.qcvm);
+	pr_global_struct->frametime = host_frametime;
+	SV_Physics ();
+	PR_SwitchQCVM (NULL);
+
+	csqc_physics_time = Sys_DoubleTime () - start;
+}
+
+/*
+==================
+Host_RunTask
+
+Runs func on the calling task. A Host_Error or Host_EndGame in it can't shut anything
+down from there, it unwinds back here instead with its message in error, for the main
+thread to raise after the join. Returns false if that happened.
+==================
+*/
+qboolean Host_RunTask (void (*func) (void *), void *arg, char *error, size_t errorsize)
+{
+	jmp_buf           taskabort;
+	volatile qboolean ok = true;
+	const int         lockdepth = PR_BuiltinLockDepth (); // a helping join may run us under a lock of its own
+
+	if (setjmp (taskabort))
+	{
+		PR_SwitchQCVM (NULL);
+		PR_ReleaseBuiltins (lockdepth);
+		ok = false;
+	}
+	else
+	{
+		host_taskabort = &taskabort;
+		host_taskerror = error;
+		host_taskerrorsize = errorsize;
+		func (arg);
+	}
+	host_taskabort = NULL;
+	return ok;
+}
+
+/*
+==================
+Host_CSQCPhysicsTask
+
+Nothing else runs cl.qcvm until the join: every csqc entry point on the main thread
+calls Host_WaitForCSQCPhysics first, and traces use World_SnapshotNetwork's copy of
+the network entities, which CL_ReadFromServer is busy updating. The builtins that
+reach further (particles, sounds, localcmd, cvar_set...) wait for the builtin lock,
+which the main thread holds until the join. The task is worker only: a join the main
+thread does while parsing (model or sound loading) must not run it there, under the
+lock the main thread already holds.
+==================
+*/
+static void Host_CSQCPhysicsTask (void *unused)
+{
+	cl.qcvm.ontask = true;
+	cl.qcvm.tasklocked = NULL;
+	if (!Host_RunTask (Host_CSQCPhysics, NULL, csqc_physics_error, sizeof (csqc_physics_error)))
+		csqc_physics_failed = true;
+	cl.qcvm.ontask = false;
+}
+
+/*
+==================
+Host_JoinCSQCPhysics
+
+Returns true if the task hit a Host_Error, the caller decides whether to raise it
+==================
+*/
+static qboolean Host_JoinCSQCPhysics (void)
+{
+	qboolean failed;
+
+	if (csqc_physics_task == INVALID_TASK_HANDLE || host_taskabort)
+		return false; // nothing in flight, or called from a builtin of the task itself
+
+	PR_ReleaseBuiltins (0); // the task may be waiting for it
+	const double start = Sys_DoubleTime ();
+	Task_Join (csqc_physics_task, SDL_MUTEX_MAXWAIT);
+	csqc_physics_task = INVALID_TASK_HANDLE;
+	csqc_physics_wait = Sys_DoubleTime () - start;
+	World_ReleaseNetworkSnapshot ();
+
+	failed = csqc_physics_failed;
+	csqc_physics_failed = false;
+	return failed;
+}
+
+/*
+==================
+Host_WaitForCSQCPhysics
+==================
+*/
+void Host_WaitForCSQCPhysics (void)
+{
+	if (Host_JoinCSQCPhysics ())
+		Host_Error ("%s", csqc_physics_error);
+}
+
 /*
 ==================
 Host_Frame
@@ -811,9 +971,13 @@ void _Host_Frame (double time)
 	static double time2 = 0;
 	static double time3 = 0;
 	double        pass1, pass2, pass3;
+	qboolean      ran_csqc = false;
 
 	if (setjmp (host_abortserver))
+	{
+		SV_ResetInstance ();
 		return; // something bad happened, or the server disconnected
+	}
 
 	// keep the random time dependent
 	rand ();
@@ -823,10 +987,14 @@ void _Host_Frame (double time)
 	if (!Host_FilterTime (time))
 		return; // don't run too fast, or packets will flood out
 
+	Tasks_TraceNewFrame ();
+	Tasks_TraceZoneBegin ("_Host_Frame");
+
 	if (host_speeds.value)
 		time3 = Sys_DoubleTime ();
 
 	// get new key events
+	Tasks_TraceZoneBegin ("input");
 	Key_UpdateForDest ();
 	IN_UpdateInputMode ();
 	Sys_SendKeyEvents ();
@@ -836,11 +1004,18 @@ void _Host_Frame (double time)
 
 	// check the stdin for commands (dedicated servers)
 	Host_GetConsoleCommands ();
+	Tasks_TraceZoneEnd ();
 
 	// process console commands
+	Tasks_TraceZoneBegin ("Cbuf_Execute");
 	Cbuf_Execute ();
+	Tasks_TraceZoneEnd ();
+
+	Host_PollSavegame ();
 
+	Tasks_TraceZoneBegin ("NET_Poll");
 	NET_Poll ();
+	Tasks_TraceZoneEnd ();
 
 	if (cl.sendprespawn)
 	{
@@ -855,6 +1030,7 @@ void _Host_Frame (double time)
 	CL_AccumulateCmd ();
 
 	// Run the server+networking (client->server->client), at a different rate from everyt
+	Tasks_TraceZoneBegin ("server");
 	while ((host_netinterval == 0) || (accumtime >= host_netinterval))
 	{
 		float realframetime = host_frametime;
@@ -869,7 +1045,9 @@ void _Host_Frame (double time)
 		}
 
 		CL_SendCmd ();
-		if (sv.active)
+		if (SV_NumInstances () > 1)
+			SV_RunInstances ();
+		else if (sv.active)
 		{
 			PR_SwitchQCVM (&sv.qcvm);
 			Host_ServerFrame ();
@@ -881,31 +1059,57 @@ void _Host_Frame (double time)
 		if (host_netinterval == 0 || isDedicated)
 			break;
 	}
+	Tasks_TraceZoneEnd ();
 
 	if (cl.qcvm.progs)
 	{
-		PR_SwitchQCVM (&cl.qcvm);
-		pr_global_struct->frametime = host_frametime;
-		SV_Physics ();
-		PR_SwitchQCVM (NULL);
+		ran_csqc = true;
+		if (cl_csqc_tasks.value && cls.state == ca_connected && Tasks_NumWorkers () > 1)
+		{ // overlap with CL_ReadFromServer, which runs with the builtin lock held
+			Host_WaitForCSQCPhysics ();
+			World_SnapshotNetwork ();
+			PR_LockBuiltins ();
+			csqc_physics_task = Task_AllocateAndAssignFunc ("CSQC SV_Physics", Host_CSQCPhysicsTask, NULL, 0);
+			Task_SetWorkerOnly (csqc_physics_task);
+			Task_Submit (csqc_physics_task);
+		}
+		else
+		{
+			Tasks_TraceZoneBegin ("CSQC SV_Physics");
+			Host_CSQCPhysics (NULL);
+			csqc_physics_wait = csqc_physics_time; // nothing saved
+			Tasks_TraceZoneEnd ();
+		}
 	}
 
 	// fetch results from server
 	if (cls.state == ca_connected)
+	{
+		Tasks_TraceZoneBegin ("CL_ReadFromServer");
 		CL_ReadFromServer ();
+		Tasks_TraceZoneEnd ();
+	}
+
+	// CSQC_DrawHud needs the results
+	Host_WaitForCSQCPhysics ();
 
 	// update video
 	if (host_speeds.value)
 		time1 = Sys_DoubleTime ();
 
+	Tasks_TraceZoneBegin ("SCR_UpdateScreen");
 	SCR_UpdateScreen (true);
+	Tasks_TraceZoneEnd ();
 
+	Tasks_TraceZoneBegin ("CL_RunParticles");
 	CL_RunParticles (); // johnfitz -- seperated from rendering
+	Tasks_TraceZoneEnd ();
 
 	if (host_speeds.value)
 		time2 = Sys_DoubleTime ();
 
 	// update audio
+	Tasks_TraceZoneBegin ("sound");
 	BGM_Update (); // adds music raw samples and/or advances midi driver
 	if (cls.signon == SIGNONS)
 	{
@@ -916,6 +1120,7 @@ void _Host_Frame (double time)
 		S_Update (vec3_origin, vec3_origin, vec3_origin, vec3_origin);
 
 	CDAudio_Update ();
+	Tasks_TraceZoneEnd ();
 
 	if (host_speeds.value)
 	{
@@ -924,8 +1129,12 @@ void _Host_Frame (double time)
 		pass2 = (time2 - time1) * 1000;
 		pass3 = (time3 - time2) * 1000;
 		Con_Printf ("%5.2f tot %5.2f server %5.2f gfx %5.2f snd\n", pass1 + pass2 + pass3, pass1, pass2, pass3);
+		if (ran_csqc) // what the task took off the main thread, minus the time the join still waited for it
+			Con_Printf ("%5.2f csqc %5.2f saved\n", csqc_physics_time * 1000, q_max (0.0, csqc_physics_time - csqc_physics_wait) * 1000);
 	}
 
+	Tasks_TraceZoneEnd ();
+	Mem_EndFrame ();
 	host_framecount++;
 }
 
@@ -984,9 +1193,9 @@ void Host_Init (void)
 	COM_Init ();
 	COM_InitFilesystem ();
 	Host_InitLocal ();
-	W_LoadWadFile (); // johnfitz -- filename is now hard-coded for honesty
 	if (cls.state != ca_dedicated)
 	{
+		W_LoadWadFile (); // johnfitz -- filename is now hard-coded for honesty
 		Key_Init ();
 		Con_Init ();
 	}
@@ -1072,8 +1281,10 @@ void Host_Shutdown (void)
 	// keep Con_Printf from trying to update the screen
 	scr_disabled_for_loading = true;
 
+	Host_WaitForSavegame ();
 	Host_WriteConfiguration ();
 
+	SV_ShutdownInstances ();
 	NET_Shutdown ();
 
 	if (cls.state != ca_dedicated)
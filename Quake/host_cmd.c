@@ -1026,10 +1026,11 @@ Host_Savegame_f
 */
 static void Host_Savegame_f (void)
 {
-	char  name[MAX_OSPATH];
-	FILE *f;
-	int   i;
-	char  comment[SAVEGAME_COMMENT_LENGTH + 1];
+	char     name[MAX_OSPATH];
+	FILE    *f;
+	int      i;
+	char     comment[SAVEGAME_COMMENT_LENGTH + 1];
+	qboolean binary;
 
 	if (cmd_source != src_command)
 		return;
@@ -1076,8 +1077,12 @@ static void Host_Savegame_f (void)
 	q_snprintf (name, sizeof (name), "%s/%s", com_gamedir, Cmd_Argv (1));
 	COM_AddExtension (name, ".sav", sizeof (name));
 
+	// a binary save of the same name may still be in flight
+	Host_WaitForSavegame ();
+
+	binary = CVAR_TO_BOOL (sv_savebinary);
 	Con_Printf ("Saving game to %s...\n", name);
-	f = fopen (name, "w");
+	f = fopen (name, binary ? "wb" : "w");
 	if (!f)
 	{
 		Con_Printf ("ERROR: couldn't open.\n");
@@ -1086,9 +1091,18 @@ static void Host_Savegame_f (void)
 
 	PR_SwitchQCVM (&sv.qcvm);
 
-	fprintf (f, "%i\n", SAVEGAME_VERSION);
+	fprintf (f, "%i\n", binary ? SAVEGAME_VERSION_BINARY : SAVEGAME_VERSION);
 	Host_SavegameComment (comment);
 	fprintf (f, "%s\n", comment);
+
+	if (binary)
+	{
+		// the file is finished and closed by a worker, Host_PollSavegame reports the result
+		Host_WriteBinarySavegame (f);
+		PR_SwitchQCVM (NULL);
+		return;
+	}
+
 	for (i = 0; i < NUM_BASIC_SPAWN_PARMS; i++)
 		fprintf (f, "%f\n", svs.clients->spawn_parms[i]);
 	fprintf (f, "%d\n", current_skill);
@@ -1106,10 +1120,7 @@ static void Host_Savegame_f (void)
 
 	ED_WriteGlobals (f);
 	for (i = 0; i < qcvm->num_edicts; i++)
-	{
 		ED_Write (f, EDICT_NUM (i));
-		fflush (f);
-	}
 
 	// add extra info (lightstyles, precaches, etc) in a way that's supposed to be compatible with DP.
 	// sidenote - this provides extended lightstyles and support for late precaches
@@ -1162,15 +1173,17 @@ static void Host_Loadgame_f (void)
 {
 	static char *start;
 
-	char        name[MAX_OSPATH];
-	char        mapname[MAX_QPATH];
-	float       time, tfloat;
-	const char *data;
-	int         i;
-	edict_t    *ent;
-	int         entnum;
-	int         version;
-	float       spawn_parms[NUM_TOTAL_SPAWN_PARMS];
+	char            name[MAX_OSPATH];
+	char            mapname[MAX_QPATH];
+	float           time, tfloat;
+	const char     *data;
+	int             i;
+	edict_t        *ent;
+	int             entnum;
+	int             version;
+	float           spawn_parms[NUM_TOTAL_SPAWN_PARMS];
+	qboolean        binary;
+	savegame_info_t binary_save;
 
 	if (cmd_source != src_command)
 		return;
@@ -1198,39 +1211,56 @@ static void Host_Loadgame_f (void)
 
 	Con_Printf ("Loading game from %s...\n", name);
 
+	// make sure a pending binary save has hit the disk
+	Host_WaitForSavegame ();
+
 	// avoid leaking if the previous Host_Loadgame_f failed with a Host_Error
 	if (start != NULL)
 		Mem_Free (start);
+	start = NULL;
+	data = NULL;
 
-	start = (char *)COM_LoadMallocFile_TextMode_OSPath (name, NULL);
-	if (start == NULL)
+	binary = Host_ReadBinarySavegame (name, &binary_save);
+	if (binary)
 	{
-		Con_Printf ("ERROR: couldn't open.\n");
-		return;
+		memcpy (spawn_parms, binary_save.spawn_parms, sizeof (spawn_parms));
+		current_skill = binary_save.skill;
+		Cvar_SetValue ("skill", (float)current_skill);
+		q_strlcpy (mapname, binary_save.mapname, sizeof (mapname));
+		time = binary_save.time;
 	}
-
-	data = start;
-	data = COM_ParseIntNewline (data, &version);
-	if (version != SAVEGAME_VERSION)
+	else
 	{
-		Mem_Free (start);
-		start = NULL;
-		Host_Error ("Savegame is version %i, not %i", version, SAVEGAME_VERSION);
-		return;
+		start = (char *)COM_LoadMallocFile_TextMode_OSPath (name, NULL);
+		if (start == NULL)
+		{
+			Con_Printf ("ERROR: couldn't open.\n");
+			return;
+		}
+
+		data = start;
+		data = COM_ParseIntNewline (data, &version);
+		if (version != SAVEGAME_VERSION)
+		{
+			Mem_Free (start);
+			start = NULL;
+			Host_Error ("Savegame is version %i, not %i", version, SAVEGAME_VERSION);
+			return;
+		}
+		data = COM_ParseStringNewline (data);
+		for (i = 0; i < NUM_BASIC_SPAWN_PARMS; i++)
+			data = COM_ParseFloatNewline (data, &spawn_parms[i]);
+		for (; i < NUM_TOTAL_SPAWN_PARMS; i++)
+			spawn_parms[i] = 0;
+		// this silliness is so we can load 1.06 save files, which have float skill values
+		data = COM_ParseFloatNewline (data, &tfloat);
+		current_skill = (int)(tfloat + 0.1);
+		Cvar_SetValue ("skill", (float)current_skill);
+
+		data = COM_ParseStringNewline (data);
+		q_strlcpy (mapname, com_token, sizeof (mapname));
+		data = COM_ParseFloatNewline (data, &time);
 	}
-	data = COM_ParseStringNewline (data);
-	for (i = 0; i < NUM_BASIC_SPAWN_PARMS; i++)
-		data = COM_ParseFloatNewline (data, &spawn_parms[i]);
-	for (; i < NUM_TOTAL_SPAWN_PARMS; i++)
-		spawn_parms[i] = 0;
-	// this silliness is so we can load 1.06 save files, which have float skill values
-	data = COM_ParseFloatNewline (data, &tfloat);
-	current_skill = (int)(tfloat + 0.1);
-	Cvar_SetValue ("skill", (float)current_skill);
-
-	data = COM_ParseStringNewline (data);
-	q_strlcpy (mapname, com_token, sizeof (mapname));
-	data = COM_ParseFloatNewline (data, &time);
 
 	CL_Disconnect_f ();
 
@@ -1240,8 +1270,7 @@ static void Host_Loadgame_f (void)
 	if (!sv.active)
 	{
 		PR_SwitchQCVM (NULL);
-		Mem_Free (start);
-		start = NULL;
+		SAFE_FREE (start);
 		SCR_EndLoadingPlaque ();
 		Con_Printf ("Couldn't load map\n");
 		return;
@@ -1249,6 +1278,12 @@ static void Host_Loadgame_f (void)
 	sv.paused = true; // pause until all clients connect
 	sv.loadgame = true;
 
+	if (binary)
+	{
+		Host_RestoreBinarySavegame (&binary_save);
+		goto restored;
+	}
+
 	// load the light styles
 	for (i = 0; i < MAX_LIGHTSTYLES; i++)
 	{
@@ -1294,7 +1329,7 @@ static void Host_Loadgame_f (void)
 					if (idx >= 1 && idx < MAX_MODELS)
 					{
 						sv.model_precache[idx] = (const char *)q_strdup (com_token);
-						sv.models[idx] = Mod_ForName (sv.model_precache[idx], idx == 1);
+						sv.models[idx] = SV_ModelForName (sv.model_precache[idx], idx == 1);
 						// if (idx == 1)
 						//	sv.worldmodel = sv.models[idx];
 					}
@@ -1376,11 +1411,12 @@ static void Host_Loadgame_f (void)
 	}
 
 	qcvm->num_edicts = entnum;
-	qcvm->time = time;
-
 	Mem_Free (start);
 	start = NULL;
 
+restored:
+	qcvm->time = time;
+
 	for (i = 0; i < NUM_TOTAL_SPAWN_PARMS; i++)
 		svs.clients->spawn_parms[i] = spawn_parms[i];
 
@@ -2444,6 +2480,20 @@ static void Host_Stopdemo_f (void)
 	CL_Disconnect ();
 }
 
+/*
+==================
+Host_CacheStats_f
+
+Reuse of the models and sounds kept across the last map change
+==================
+*/
+static void Host_CacheStats_f (void)
+{
+	Mod_PrintCacheStats ();
+	if (cls.state != ca_dedicated)
+		S_PrintCacheStats ();
+}
+
 //=============================================================================
 
 /*
@@ -2498,4 +2548,5 @@ void Host_InitCommands (void)
 	Cmd_AddCommand ("viewprev", Host_Viewprev_f);
 
 	Cmd_AddCommand ("mcache", Mod_Print);
+	Cmd_AddCommand ("cachestats", Host_CacheStats_f);
 }
@@ -0,0 +1,828 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// host_save.c -- binary savegames
+
+/*
+A binary savegame starts with the same two text lines as a regular one
+(version number and comment), so M_ScanSaves can list it unchanged.
+They are followed by a savegame_binary_header_t and a raw deflate stream.
+
+The uncompressed payload is a snapshot of the server qcvm: the edict fields
+and the saved globals are copied as-is, string references are remapped into
+a string table that is appended at the end. Since field and global offsets
+are stored raw, a binary savegame can only be loaded with the same progs.dat
+it was written with; the payload is native endian.
+
+Snapshotting happens on the main thread; compression and file I/O are done
+on a worker so quicksaves don't stall the game.
+*/
+
+#include "quakedef.h"
+#include "miniz.h"
+
+#define SAVEGAME_BINARY_MAGIC (('B' << 24) | ('V' << 16) | ('S' << 8) | 'Q')
+
+#define SAVESTRINGS_HASH_SIZE 4096
+
+// info, spawn parms, skill and map name
+#define SAVEGAME_BINARY_MIN_SIZE ((int)sizeof (savegame_binary_info_t) + (4 * NUM_TOTAL_SPAWN_PARMS) + 4 + MAX_QPATH)
+
+typedef struct
+{
+	int          magic;
+	int          uncompressed_size;
+	int          compressed_size;
+	unsigned int checksum;
+} savegame_binary_header_t;
+
+typedef struct
+{
+	int      edicts_offset;
+	int      strings_offset;
+	unsigned progs_crc;
+	int      entityfields;
+	int      num_edicts;
+	int      serverflags;
+	double   time;
+} savegame_binary_info_t;
+
+typedef struct
+{
+	FILE *f;
+	byte *data;
+	int   size;
+} save_task_args_t;
+
+typedef struct
+{
+	const char **strings;
+	int          num_strings;
+	int          max_strings;
+	int          total_length;
+	string_t     hash_keys[SAVESTRINGS_HASH_SIZE];
+	int          hash_values[SAVESTRINGS_HASH_SIZE];
+} savestrings_t;
+
+cvar_t sv_savebinary = {"sv_savebinary", "0", CVAR_ARCHIVE};
+
+static task_handle_t save_task = INVALID_TASK_HANDLE;
+static qboolean      save_failed; // set by the task, read after the join
+static byte         *load_data;
+
+/*
+===============================================================================
+
+DEFLATE
+
+The vendored miniz is inflate-only, so binary savegames are compressed with a
+small greedy LZ77 coder that emits a single fixed Huffman block. Edict data is
+dominated by zeros and repeated vectors, which this handles well enough.
+
+===============================================================================
+*/
+
+#define DEFLATE_WINDOW_SIZE  32768
+#define DEFLATE_HASH_BITS    15
+#define DEFLATE_MIN_MATCH    3
+#define DEFLATE_MAX_MATCH    258
+#define DEFLATE_MAX_DISTANCE DEFLATE_WINDOW_SIZE
+
+static const unsigned short deflate_length_base[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                                       31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const byte           deflate_length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const unsigned short deflate_dist_base[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                                     193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const byte deflate_dist_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+typedef struct
+{
+	byte    *out;
+	size_t   pos;
+	uint64_t bits;
+	int      num_bits;
+} bitwriter_t;
+
+/*
+===============
+Deflate_PutBits
+===============
+*/
+static inline void Deflate_PutBits (bitwriter_t *w, uint32_t value, int count)
+{
+	w->bits |= (uint64_t)value << w->num_bits;
+	w->num_bits += count;
+	while (w->num_bits >= 8)
+	{
+		w->out[w->pos++] = (byte)w->bits;
+		w->bits >>= 8;
+		w->num_bits -= 8;
+	}
+}
+
+/*
+===============
+Deflate_PutCode
+
+Huffman codes are stored MSB first
+===============
+*/
+static inline void Deflate_PutCode (bitwriter_t *w, uint32_t code, int count)
+{
+	uint32_t reversed = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		reversed = (reversed << 1) | (code & 1);
+		code >>= 1;
+	}
+	Deflate_PutBits (w, reversed, count);
+}
+
+/*
+===============
+Deflate_PutLiteral
+===============
+*/
+static inline void Deflate_PutLiteral (bitwriter_t *w, int symbol)
+{
+	if (symbol < 144)
+		Deflate_PutCode (w, 0x30 + symbol, 8);
+	else if (symbol < 256)
+		Deflate_PutCode (w, 0x190 + (symbol - 144), 9);
+	else if (symbol < 280)
+		Deflate_PutCode (w, symbol - 256, 7);
+	else
+		Deflate_PutCode (w, 0xC0 + (symbol - 280), 8);
+}
+
+/*
+===============
+Deflate_PutMatch
+===============
+*/
+static inline void Deflate_PutMatch (bitwriter_t *w, int length, int distance)
+{
+	int code = 28;
+	while (deflate_length_base[code] > length)
+		--code;
+	Deflate_PutLiteral (w, 257 + code);
+	Deflate_PutBits (w, length - deflate_length_base[code], deflate_length_extra[code]);
+
+	code = 29;
+	while (deflate_dist_base[code] > distance)
+		--code;
+	Deflate_PutCode (w, code, 5);
+	Deflate_PutBits (w, distance - deflate_dist_base[code], deflate_dist_extra[code]);
+}
+
+/*
+===============
+Deflate_Bound
+===============
+*/
+static size_t Deflate_Bound (size_t size)
+{
+	// literals are at most 9 bits
+	return size + (size / 8) + 16;
+}
+
+/*
+===============
+Deflate_Compress
+
+Returns the number of bytes written to out, which must hold Deflate_Bound (size) bytes
+===============
+*/
+static size_t Deflate_Compress (const byte *in, size_t size, byte *out)
+{
+	bitwriter_t w = {out, 0, 0, 0};
+	int        *head = Mem_Alloc (sizeof (int) * (1 << DEFLATE_HASH_BITS));
+	size_t      pos = 0;
+
+	memset (head, 0xFF, sizeof (int) * (1 << DEFLATE_HASH_BITS));
+
+	// BFINAL = 1, BTYPE = 01 (fixed Huffman)
+	Deflate_PutBits (&w, 1, 1);
+	Deflate_PutBits (&w, 1, 2);
+
+	while (pos < size)
+	{
+		int best_length = 0;
+		int best_distance = 0;
+		if (pos + DEFLATE_MIN_MATCH <= size)
+		{
+			const uint32_t key = in[pos] | (in[pos + 1] << 8) | (in[pos + 2] << 16);
+			const uint32_t hash = (key * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+			const int      candidate = head[hash];
+			head[hash] = (int)pos;
+			if ((candidate >= 0) && ((pos - candidate) <= DEFLATE_MAX_DISTANCE))
+			{
+				const size_t max_length = q_min (size - pos, (size_t)DEFLATE_MAX_MATCH);
+				size_t       length = 0;
+				while ((length < max_length) && (in[candidate + length] == in[pos + length]))
+					++length;
+				if (length >= DEFLATE_MIN_MATCH)
+				{
+					best_length = (int)length;
+					best_distance = (int)(pos - candidate);
+				}
+			}
+		}
+
+		if (best_length)
+		{
+			Deflate_PutMatch (&w, best_length, best_distance);
+			pos += best_length;
+		}
+		else
+		{
+			Deflate_PutLiteral (&w, in[pos]);
+			pos += 1;
+		}
+	}
+
+	Deflate_PutLiteral (&w, 256);
+	Deflate_PutBits (&w, 0, 7); // flush
+	Mem_Free (head);
+	return w.pos;
+}
+
+/*
+===============================================================================
+
+SNAPSHOT
+
+===============================================================================
+*/
+
+/*
+===============
+SaveStrings_Add
+===============
+*/
+static int SaveStrings_Add (savestrings_t *table, const char *s)
+{
+	if (table->num_strings == table->max_strings)
+	{
+		table->max_strings = q_max (table->max_strings * 2, 256);
+		table->strings = Mem_Realloc ((void *)table->strings, sizeof (const char *) * table->max_strings);
+	}
+	table->strings[table->num_strings] = s;
+	table->total_length += strlen (s) + 1;
+	return table->num_strings++;
+}
+
+/*
+===============
+SaveStrings_AddQC
+
+Strings from the progs string area are kept as offsets, everything else
+is stored as -1 - table index. Identical string_t values share an entry.
+===============
+*/
+static string_t SaveStrings_AddQC (savestrings_t *table, string_t s)
+{
+	if ((s >= 0) && (s < qcvm->stringssize))
+		return s;
+
+	uint32_t hash = ((uint32_t)s * 2654435761u) & (SAVESTRINGS_HASH_SIZE - 1);
+	for (int i = 0; i < SAVESTRINGS_HASH_SIZE; ++i)
+	{
+		const uint32_t slot = (hash + i) & (SAVESTRINGS_HASH_SIZE - 1);
+		if (table->hash_values[slot] == 0)
+		{
+			const int index = SaveStrings_Add (table, PR_GetString (s));
+			table->hash_keys[slot] = s;
+			table->hash_values[slot] = index + 1;
+			return -1 - index;
+		}
+		if (table->hash_keys[slot] == s)
+			return -1 - (table->hash_values[slot] - 1);
+	}
+
+	// hash table is full, just store a duplicate
+	return -1 - SaveStrings_Add (table, PR_GetString (s));
+}
+
+/*
+===============
+SaveStrings_AddEngine
+===============
+*/
+static int SaveStrings_AddEngine (savestrings_t *table, const char *s)
+{
+	return s ? SaveStrings_Add (table, s) : -1;
+}
+
+/*
+===============
+Save_DefIsString
+===============
+*/
+static qboolean Save_DefIsString (const ddef_t *def)
+{
+	return (def->type & ~DEF_SAVEGLOBAL) == ev_string;
+}
+
+/*
+===============
+Save_IsSavedGlobal
+
+Same set of globals as ED_WriteGlobals
+===============
+*/
+static qboolean Save_IsSavedGlobal (const ddef_t *def)
+{
+	const int type = def->type & ~DEF_SAVEGLOBAL;
+	if (!(def->type & DEF_SAVEGLOBAL))
+		return false;
+	return (type == ev_string) || (type == ev_float) || (type == ev_ext_integer) || (type == ev_entity);
+}
+
+/*
+===============
+Host_SnapshotBinarySavegame
+
+Serializes the server state, returns a Mem_Alloc'd buffer
+===============
+*/
+static byte *Host_SnapshotBinarySavegame (int *out_size)
+{
+	savestrings_t         *table = Mem_Alloc (sizeof (savestrings_t));
+	savegame_binary_info_t info;
+	sizebuf_t              buf;
+	int                   *string_fields = NULL;
+	int                    num_string_fields = 0;
+	int                    num_saveglobals = 0;
+	int                    i, j;
+	const int              fields_size = qcvm->progs->entityfields * 4;
+
+	for (i = 1; i < qcvm->progs->numfielddefs; i++)
+		if (Save_DefIsString (&qcvm->fielddefs[i]))
+			++num_string_fields;
+	string_fields = Mem_Alloc (sizeof (int) * q_max (num_string_fields, 1));
+	for (i = 1, num_string_fields = 0; i < qcvm->progs->numfielddefs; i++)
+		if (Save_DefIsString (&qcvm->fielddefs[i]))
+			string_fields[num_string_fields++] = qcvm->fielddefs[i].ofs;
+
+	for (i = 0; i < qcvm->progs->numglobaldefs; i++)
+		if (Save_IsSavedGlobal (&qcvm->globaldefs[i]))
+			++num_saveglobals;
+
+	buf.allowoverflow = false;
+	buf.overflowed = false;
+	buf.cursize = 0;
+	buf.maxsize = sizeof (info) + (sizeof (float) * NUM_TOTAL_SPAWN_PARMS) + MAX_QPATH +
+				  (sizeof (int) * (2 + MAX_LIGHTSTYLES + MAX_MODELS + MAX_SOUNDS + MAX_PARTICLETYPES)) + (sizeof (int) * 2 * num_saveglobals) +
+				  (qcvm->num_edicts * (2 + fields_size));
+	buf.data = Mem_Alloc (buf.maxsize);
+
+	SZ_GetSpace (&buf, sizeof (info));
+	for (i = 0; i < NUM_TOTAL_SPAWN_PARMS; i++)
+		MSG_WriteFloat (&buf, svs.clients->spawn_parms[i]);
+	MSG_WriteLong (&buf, current_skill);
+	memset (SZ_GetSpace (&buf, MAX_QPATH), 0, MAX_QPATH);
+	q_strlcpy ((char *)buf.data + buf.cursize - MAX_QPATH, sv.name, MAX_QPATH);
+
+	for (i = 0; i < MAX_LIGHTSTYLES; i++)
+		MSG_WriteLong (&buf, SaveStrings_AddEngine (table, sv.lightstyles[i] ? sv.lightstyles[i] : "m"));
+	for (i = 0; i < MAX_MODELS; i++)
+		MSG_WriteLong (&buf, SaveStrings_AddEngine (table, i ? sv.model_precache[i] : NULL));
+	for (i = 0; i < MAX_SOUNDS; i++)
+		MSG_WriteLong (&buf, SaveStrings_AddEngine (table, i ? sv.sound_precache[i] : NULL));
+	for (i = 0; i < MAX_PARTICLETYPES; i++)
+		MSG_WriteLong (&buf, SaveStrings_AddEngine (table, i ? sv.particle_precache[i] : NULL));
+
+	// globals are stored by offset
+	MSG_WriteLong (&buf, num_saveglobals);
+	for (i = 0; i < qcvm->progs->numglobaldefs; i++)
+	{
+		const ddef_t *def = &qcvm->globaldefs[i];
+		if (!Save_IsSavedGlobal (def))
+			continue;
+		int value = *(int *)&qcvm->globals[def->ofs];
+		if (Save_DefIsString (def))
+			value = SaveStrings_AddQC (table, value);
+		MSG_WriteLong (&buf, def->ofs);
+		MSG_WriteLong (&buf, value);
+	}
+
+	info.edicts_offset = buf.cursize;
+	for (i = 0; i < qcvm->num_edicts; i++)
+	{
+		edict_t *ed = EDICT_NUM (i);
+		MSG_WriteByte (&buf, ed->free);
+		MSG_WriteByte (&buf, ed->alpha);
+		if (ed->free)
+			continue;
+
+		int *v = (int *)SZ_GetSpace (&buf, fields_size);
+		memcpy (v, &ed->v, fields_size);
+		for (j = 0; j < num_string_fields; j++)
+			if (v[string_fields[j]])
+				v[string_fields[j]] = SaveStrings_AddQC (table, v[string_fields[j]]);
+	}
+
+	// the string table goes last, its size is only known now
+	info.strings_offset = buf.cursize;
+	buf.maxsize = buf.cursize + sizeof (int) + table->total_length;
+	buf.data = Mem_Realloc (buf.data, buf.maxsize);
+	MSG_WriteLong (&buf, table->num_strings);
+	for (i = 0; i < table->num_strings; i++)
+		SZ_Write (&buf, table->strings[i], strlen (table->strings[i]) + 1);
+
+	info.progs_crc = qcvm->progs->crc;
+	info.entityfields = qcvm->progs->entityfields;
+	info.num_edicts = qcvm->num_edicts;
+	info.serverflags = svs.serverflags;
+	info.time = qcvm->time;
+	memcpy (buf.data, &info, sizeof (info));
+
+	Mem_Free (string_fields);
+	Mem_Free ((void *)table->strings);
+	Mem_Free (table);
+
+	*out_size = buf.cursize;
+	return buf.data;
+}
+
+/*
+===============
+Host_WriteSavegameTask
+===============
+*/
+static void Host_WriteSavegameTask (save_task_args_t *args)
+{
+	savegame_binary_header_t header;
+	byte                    *compressed = Mem_Alloc (Deflate_Bound (args->size));
+
+	header.magic = SAVEGAME_BINARY_MAGIC;
+	header.uncompressed_size = args->size;
+	header.compressed_size = (int)Deflate_Compress (args->data, args->size, compressed);
+	header.checksum = Com_BlockChecksum (args->data, args->size);
+
+	save_failed = (fwrite (&header, sizeof (header), 1, args->f) != 1) || (fwrite (compressed, header.compressed_size, 1, args->f) != 1);
+	if (fclose (args->f) != 0)
+		save_failed = true;
+
+	Mem_Free (compressed);
+	Mem_Free (args->data);
+}
+
+/*
+===============
+Host_FinishSavegame
+
+Reports how the binary savegame write went, once its task has been joined
+===============
+*/
+static void Host_FinishSavegame (void)
+{
+	save_task = INVALID_TASK_HANDLE;
+	if (save_failed)
+		Con_Printf ("ERROR: couldn't write savegame.\n");
+	else
+		Con_Printf ("done.\n");
+	SaveList_Rebuild ();
+}
+
+/*
+===============
+Host_WaitForSavegame
+
+Blocks until a pending binary savegame has been written to disk
+===============
+*/
+void Host_WaitForSavegame (void)
+{
+	if (save_task == INVALID_TASK_HANDLE)
+		return;
+	Task_Join (save_task, SDL_MUTEX_MAXWAIT);
+	Host_FinishSavegame ();
+}
+
+/*
+===============
+Host_PollSavegame
+
+Called every frame, finishes a binary savegame once the worker is done with it
+===============
+*/
+void Host_PollSavegame (void)
+{
+	if ((save_task != INVALID_TASK_HANDLE) && Task_Join (save_task, 0))
+		Host_FinishSavegame ();
+}
+
+/*
+===============
+Host_WriteBinarySavegame
+
+f has the text header already written, it will be closed by the worker
+===============
+*/
+void Host_WriteBinarySavegame (FILE *f)
+{
+	save_task_args_t args;
+	double           start = Sys_DoubleTime ();
+
+	Host_WaitForSavegame ();
+
+	args.f = f;
+	args.data = Host_SnapshotBinarySavegame (&args.size);
+	Con_DPrintf ("Savegame snapshot: %d bytes in %.2f ms\n", args.size, (Sys_DoubleTime () - start) * 1000.0);
+
+	save_task = Task_AllocateAssignFuncAndSubmit ("Host_WriteSavegameTask", (task_func_t)Host_WriteSavegameTask, &args, sizeof (args));
+}
+
+/*
+===============================================================================
+
+LOAD
+
+===============================================================================
+*/
+
+/*
+===============
+Host_ReadBinarySavegame
+
+Returns false if path isn't a binary savegame. Otherwise decompresses it and
+fills in everything Host_Loadgame_f needs before spawning the server.
+===============
+*/
+qboolean Host_ReadBinarySavegame (const char *path, savegame_info_t *save)
+{
+	savegame_binary_header_t header;
+	savegame_binary_info_t   info;
+	tinfl_decompressor      *inflator;
+	byte                    *compressed;
+	const byte              *data;
+	size_t                   in_size, out_size;
+	tinfl_status             status;
+	char                     line[256];
+	FILE                    *f;
+	int                      i;
+
+	if (load_data)
+	{
+		// avoid leaking if the previous Host_Loadgame_f failed with a Host_Error
+		Mem_Free (load_data);
+		load_data = NULL;
+	}
+
+	f = fopen (path, "rb");
+	if (!f)
+		return false;
+	if (!fgets (line, sizeof (line), f) || (atoi (line) != SAVEGAME_VERSION_BINARY))
+	{
+		fclose (f);
+		return false;
+	}
+
+	// skip the comment
+	if (!fgets (line, sizeof (line), f) || (fread (&header, sizeof (header), 1, f) != 1) || (header.magic != SAVEGAME_BINARY_MAGIC) ||
+		(header.compressed_size <= 0) || (header.uncompressed_size < SAVEGAME_BINARY_MIN_SIZE))
+	{
+		fclose (f);
+		Host_Error ("Binary savegame is corrupt");
+	}
+
+	compressed = Mem_Alloc (header.compressed_size);
+	if (fread (compressed, header.compressed_size, 1, f) != 1)
+	{
+		fclose (f);
+		Mem_Free (compressed);
+		Host_Error ("Binary savegame is corrupt");
+	}
+	fclose (f);
+
+	load_data = Mem_Alloc (header.uncompressed_size);
+	inflator = Mem_Alloc (sizeof (tinfl_decompressor));
+	tinfl_init (inflator);
+	in_size = header.compressed_size;
+	out_size = header.uncompressed_size;
+	status = tinfl_decompress (inflator, compressed, &in_size, load_data, load_data, &out_size, TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+	Mem_Free (inflator);
+	Mem_Free (compressed);
+
+	if ((status != TINFL_STATUS_DONE) || (out_size != (size_t)header.uncompressed_size) ||
+		(Com_BlockChecksum (load_data, out_size) != header.checksum))
+	{
+		Mem_Free (load_data);
+		load_data = NULL;
+		Host_Error ("Binary savegame is corrupt");
+	}
+
+	memcpy (&info, load_data, sizeof (info));
+	data = load_data + sizeof (info);
+	for (i = 0; i < NUM_TOTAL_SPAWN_PARMS; i++, data += 4)
+		save->spawn_parms[i] = LittleFloat (*(float *)data);
+	save->skill = LittleLong (*(int *)data);
+	data += 4;
+	q_strlcpy (save->mapname, (const char *)data, sizeof (save->mapname));
+	save->time = info.time;
+	save->size = header.uncompressed_size;
+	return true;
+}
+
+/*
+===============
+Host_RestoreBinarySavegame
+
+Called after SV_SpawnServer with the server qcvm active
+===============
+*/
+void Host_RestoreBinarySavegame (savegame_info_t *save)
+{
+	savegame_binary_info_t info;
+	const byte            *data = load_data + SAVEGAME_BINARY_MIN_SIZE;
+	const byte            *end = load_data + save->size;
+	const char           **strings;
+	string_t              *qcstrings;
+	int                    num_strings;
+	int                   *string_fields;
+	int                    num_string_fields = 0;
+	int                    i, j, index;
+	const int              fields_size = qcvm->progs->entityfields * 4;
+
+	memcpy (&info, load_data, sizeof (info));
+	if ((info.progs_crc != qcvm->progs->crc) || (info.entityfields != qcvm->progs->entityfields))
+		Host_Error ("Binary savegame was written with a different progs.dat");
+	if ((info.num_edicts < 0) || (info.num_edicts > qcvm->max_edicts) || (info.edicts_offset < SAVEGAME_BINARY_MIN_SIZE) ||
+		(info.edicts_offset > info.strings_offset) || (info.strings_offset > save->size - (int)sizeof (int)))
+		Host_Error ("Binary savegame is corrupt");
+
+	// string table
+	num_strings = LittleLong (*(int *)(load_data + info.strings_offset));
+	strings = Mem_Alloc (sizeof (const char *) * q_max (num_strings, 1));
+	qcstrings = Mem_Alloc (sizeof (string_t) * q_max (num_strings, 1));
+	{
+		const char *s = (const char *)(load_data + info.strings_offset + sizeof (int));
+		for (i = 0; i < num_strings; i++)
+		{
+			const char *string_end = memchr (s, 0, (const char *)end - s);
+			if (!string_end)
+				Host_Error ("Binary savegame is corrupt");
+			strings[i] = s;
+			s = string_end + 1;
+		}
+	}
+
+#define SAVE_READ_INT(x)                                \
+	do                                                  \
+	{                                                   \
+		if (data + 4 > end)                             \
+			Host_Error ("Binary savegame is corrupt");  \
+		x = LittleLong (*(int *)data);                  \
+		data += 4;                                      \
+	} while (false)
+#define SAVE_STRING(index) (((index) >= 0 && (index) < num_strings) ? strings[index] : NULL)
+
+	for (i = 0; i < MAX_LIGHTSTYLES; i++)
+	{
+		SAVE_READ_INT (index);
+		sv.lightstyles[i] = (const char *)q_strdup (SAVE_STRING (index) ? SAVE_STRING (index) : "m");
+	}
+	for (i = 0; i < MAX_MODELS; i++)
+	{
+		SAVE_READ_INT (index);
+		if (i && SAVE_STRING (index))
+			sv.model_precache[i] = (const char *)q_strdup (SAVE_STRING (index));
+	}
+	// the world must exist, the rest is loaded as a batch like the client precaches
+	if (sv.model_precache[1])
+		sv.models[1] = SV_ModelForName (sv.model_precache[1], true);
+	for (i = 2; i < MAX_MODELS && sv.model_precache[i]; i++)
+		;
+	if (i > 2)
+		SV_ModelsForNames (&sv.model_precache[2], &sv.models[2], i - 2, false);
+	for (i = 0; i < MAX_SOUNDS; i++)
+	{
+		SAVE_READ_INT (index);
+		if (i && SAVE_STRING (index))
+			sv.sound_precache[i] = (const char *)q_strdup (SAVE_STRING (index));
+	}
+	for (i = 0; i < MAX_PARTICLETYPES; i++)
+	{
+		SAVE_READ_INT (index);
+		if (i && SAVE_STRING (index))
+		{
+			Mem_Free ((void *)sv.particle_precache[i]);
+			sv.particle_precache[i] = (const char *)q_strdup (SAVE_STRING (index));
+		}
+	}
+	svs.serverflags = info.serverflags;
+
+	// QC strings are allocated on first use and shared by all references
+#define SAVE_QCSTRING(value)                                                             \
+	do                                                                                   \
+	{                                                                                    \
+		if ((value) < 0)                                                                 \
+		{                                                                                \
+			const int string_index = -1 - (value);                                       \
+			if (string_index >= num_strings)                                             \
+				Host_Error ("Binary savegame is corrupt");                               \
+			if (!qcstrings[string_index])                                                \
+			{                                                                            \
+				char     *p;                                                             \
+				const int length = strlen (strings[string_index]) + 1;                   \
+				qcstrings[string_index] = PR_AllocString (length, &p);                   \
+				memcpy (p, strings[string_index], length);                               \
+			}                                                                            \
+			(value) = qcstrings[string_index];                                           \
+		}                                                                                \
+	} while (false)
+
+	// globals
+	{
+		int   num_saveglobals;
+		byte *string_globals = Mem_Alloc (qcvm->progs->numglobals);
+		for (i = 0; i < qcvm->progs->numglobaldefs; i++)
+			if (Save_DefIsString (&qcvm->globaldefs[i]) && (qcvm->globaldefs[i].ofs < qcvm->progs->numglobals))
+				string_globals[qcvm->globaldefs[i].ofs] = true;
+
+		SAVE_READ_INT (num_saveglobals);
+		for (i = 0; i < num_saveglobals; i++)
+		{
+			int ofs, value;
+			SAVE_READ_INT (ofs);
+			SAVE_READ_INT (value);
+			if ((ofs < 0) || (ofs >= qcvm->progs->numglobals))
+				Host_Error ("Binary savegame is corrupt");
+			if (string_globals[ofs])
+				SAVE_QCSTRING (value);
+			*(int *)&qcvm->globals[ofs] = value;
+		}
+		Mem_Free (string_globals);
+	}
+
+	// edicts
+	for (i = 1; i < qcvm->progs->numfielddefs; i++)
+		if (Save_DefIsString (&qcvm->fielddefs[i]))
+			++num_string_fields;
+	string_fields = Mem_Alloc (sizeof (int) * q_max (num_string_fields, 1));
+	for (i = 1, num_string_fields = 0; i < qcvm->progs->numfielddefs; i++)
+		if (Save_DefIsString (&qcvm->fielddefs[i]))
+			string_fields[num_string_fields++] = qcvm->fielddefs[i].ofs;
+
+	data = load_data + info.edicts_offset;
+	for (i = 0; i < info.num_edicts; i++)
+	{
+		edict_t *ent = EDICT_NUM (i);
+		if (data + 2 > end)
+			Host_Error ("Binary savegame is corrupt");
+
+		if (i < qcvm->num_edicts)
+			memset (&ent->v, 0, fields_size);
+		else
+			memset (ent, 0, qcvm->edict_size);
+		ent->free = data[0];
+		ent->alpha = data[1];
+		data += 2;
+		if (ent->free)
+			continue;
+
+		if (data + fields_size > end)
+			Host_Error ("Binary savegame is corrupt");
+		memcpy (&ent->v, data, fields_size);
+		data += fields_size;
+
+		int *v = (int *)&ent->v;
+		for (j = 0; j < num_string_fields; j++)
+			SAVE_QCSTRING (v[string_fields[j]]);
+
+		// link it into the bsp tree
+		SV_LinkEdict (ent, false);
+	}
+
+#undef SAVE_QCSTRING
+#undef SAVE_STRING
+#undef SAVE_READ_INT
+
+	qcvm->num_edicts = info.num_edicts;
+
+	Mem_Free (string_fields);
+	Mem_Free (qcstrings);
+	Mem_Free ((void *)strings);
+	Mem_Free (load_data);
+	load_data = NULL;
+}
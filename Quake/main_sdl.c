@@ -53,7 +53,7 @@ static quakeparms_t parms;
 
 int main (int argc, char *argv[])
 {
-	double time, oldtime, newtime;
+	double time, oldtime, newtime, init_time;
 
 	host_parms = &parms;
 	parms.basedir = ".";
@@ -65,7 +65,11 @@ int main (int argc, char *argv[])
 
 	COM_InitArgv (parms.argc, parms.argv);
 
+#ifdef SERVERONLY
+	isDedicated = true;
+#else
 	isDedicated = (COM_CheckParm ("-dedicated") != 0);
+#endif
 
 	Sys_InitSDL ();
 
@@ -83,7 +87,9 @@ int main (int argc, char *argv[])
 #endif
 
 	Sys_Printf ("Host_Init\n");
+	init_time = Sys_DoubleTime ();
 	Host_Init ();
+	Sys_Printf ("Host_Init took %.1f ms\n", (Sys_DoubleTime () - init_time) * 1000.0);
 
 	oldtime = Sys_DoubleTime ();
 	if (isDedicated)
@@ -48,6 +48,54 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 size_t THREAD_LOCAL thread_stack_alloc_size = 0;
 size_t max_thread_stack_alloc_size = 0;
 
+cvar_t mem_framewarn = {"mem_framewarn", "0", CVAR_NONE};
+
+#ifdef USE_MEM_TAGS
+// in front of every allocation, keeps the result 16 byte aligned
+typedef struct
+{
+	size_t   size;
+	uint32_t tag;
+	uint32_t pad;
+} mem_header_t;
+
+#define MEM_HEADER_SIZE 16
+COMPILE_TIME_ASSERT (mem_header, sizeof (mem_header_t) <= MEM_HEADER_SIZE);
+
+#define MEM_MAX_THREADS 64
+
+typedef struct
+{
+	atomic_uint64_t bytes;
+	atomic_uint64_t peak_bytes;
+	atomic_uint64_t live;
+	atomic_uint64_t allocs;
+	atomic_uint32_t frame_allocs;
+	uint32_t        last_frame_allocs; // main thread only
+	uint32_t        peak_frame_allocs;
+} memtag_stats_t;
+
+typedef struct
+{
+	atomic_uint64_t allocs;
+	atomic_uint64_t frees;
+	atomic_uint64_t bytes;
+} memthread_stats_t;
+
+static const char *memtag_names[MEMTAG_COUNT] = {"misc", "model", "texture", "sound", "qc strings", "edicts", "particles", "rt scratch"};
+
+static memtag_stats_t    memtag_stats[MEMTAG_COUNT];
+static memthread_stats_t memthread_stats[MEM_MAX_THREADS];
+static atomic_uint64_t   mem_total_bytes;
+static atomic_uint64_t   mem_peak_bytes;
+static atomic_uint32_t   mem_num_threads;
+
+static THREAD_LOCAL memtag_t mem_thread_tag;
+static THREAD_LOCAL int      mem_thread_slot; // 1 based, 0 until the thread first allocates
+
+static memthread_stats_t *Mem_ThreadStats (void);
+#endif
+
 /*
 ====================
 Mem_Init
@@ -55,6 +103,10 @@ Mem_Init
 */
 void Mem_Init ()
 {
+#ifdef USE_MEM_TAGS
+	// claims the first thread slot for the main thread
+	Mem_ThreadStats ();
+#endif
 #ifdef _WIN32
 	max_thread_stack_alloc_size = MAX_STACK_ALLOC_SIZE;
 #else /* unix: */
@@ -71,10 +123,10 @@ void Mem_Init ()
 
 /*
 ====================
-Mem_Alloc
+Mem_RawAlloc
 ====================
 */
-void *Mem_Alloc (const size_t size)
+static void *Mem_RawAlloc (const size_t size)
 {
 #if defined(USE_MI_MALLOC)
 	return mi_calloc (1, size);
@@ -87,10 +139,10 @@ void *Mem_Alloc (const size_t size)
 
 /*
 ====================
-Mem_Realloc
+Mem_RawRealloc
 ====================
 */
-void *Mem_Realloc (void *ptr, const size_t size)
+static void *Mem_RawRealloc (void *ptr, const size_t size)
 {
 #if defined(USE_MI_MALLOC)
 	return mi_realloc (ptr, size);
@@ -103,10 +155,10 @@ void *Mem_Realloc (void *ptr, const size_t size)
 
 /*
 ====================
-Mem_Free
+Mem_RawFree
 ====================
 */
-void Mem_Free (const void *ptr)
+static void Mem_RawFree (const void *ptr)
 {
 #if defined(USE_MI_MALLOC)
 	mi_free ((void *)ptr);
@@ -116,3 +168,267 @@ void Mem_Free (const void *ptr)
 	free ((void *)ptr);
 #endif
 }
+
+#ifdef USE_MEM_TAGS
+/*
+====================
+Mem_ThreadStats
+====================
+*/
+static memthread_stats_t *Mem_ThreadStats (void)
+{
+	if (!mem_thread_slot)
+	{
+		// threads past the limit share the last slot
+		mem_thread_slot = Atomic_IncrementUInt32 (&mem_num_threads) + 1;
+		mem_thread_slot = q_min (mem_thread_slot, MEM_MAX_THREADS);
+	}
+	return &memthread_stats[mem_thread_slot - 1];
+}
+
+/*
+====================
+Mem_UpdatePeak
+====================
+*/
+static void Mem_UpdatePeak (atomic_uint64_t *peak, uint64_t value)
+{
+	uint64_t expected = Atomic_LoadUInt64 (peak);
+	while (value > expected && !Atomic_CompareExchangeUInt64 (peak, &expected, value))
+		;
+}
+
+/*
+====================
+Mem_AddAllocation
+====================
+*/
+static void Mem_AddAllocation (memtag_t tag, size_t size)
+{
+	memtag_stats_t    *stats = &memtag_stats[tag];
+	memthread_stats_t *thread_stats = Mem_ThreadStats ();
+
+	Mem_UpdatePeak (&stats->peak_bytes, Atomic_AddUInt64 (&stats->bytes, size) + size);
+	Mem_UpdatePeak (&mem_peak_bytes, Atomic_AddUInt64 (&mem_total_bytes, size) + size);
+	Atomic_IncrementUInt64 (&stats->live);
+	Atomic_IncrementUInt64 (&stats->allocs);
+	Atomic_IncrementUInt32 (&stats->frame_allocs);
+	Atomic_IncrementUInt64 (&thread_stats->allocs);
+	Atomic_AddUInt64 (&thread_stats->bytes, size);
+}
+
+/*
+====================
+Mem_RemoveAllocation
+====================
+*/
+static void Mem_RemoveAllocation (memtag_t tag, size_t size)
+{
+	memtag_stats_t *stats = &memtag_stats[tag];
+
+	Atomic_SubUInt64 (&stats->bytes, size);
+	Atomic_SubUInt64 (&mem_total_bytes, size);
+	Atomic_SubUInt64 (&stats->live, 1);
+	Atomic_IncrementUInt64 (&Mem_ThreadStats ()->frees);
+}
+
+/*
+====================
+Mem_AllocTagged
+====================
+*/
+void *Mem_AllocTagged (const size_t size, memtag_t tag)
+{
+	mem_header_t *header = Mem_RawAlloc (size + MEM_HEADER_SIZE);
+	if (!header)
+		return NULL;
+	header->size = size;
+	header->tag = tag;
+	Mem_AddAllocation (tag, size);
+	return (byte *)header + MEM_HEADER_SIZE;
+}
+
+/*
+====================
+Mem_ReallocTagged
+
+Moves the allocation to tag
+====================
+*/
+void *Mem_ReallocTagged (void *ptr, const size_t size, memtag_t tag)
+{
+	mem_header_t *header;
+
+	if (!ptr)
+		return Mem_AllocTagged (size, tag);
+
+	header = (mem_header_t *)((byte *)ptr - MEM_HEADER_SIZE);
+	header = Mem_RawRealloc (header, size + MEM_HEADER_SIZE);
+	if (!header)
+		return NULL;
+	Mem_RemoveAllocation (header->tag, header->size);
+	header->size = size;
+	header->tag = tag;
+	Mem_AddAllocation (tag, size);
+	return (byte *)header + MEM_HEADER_SIZE;
+}
+
+/*
+====================
+Mem_SetTag
+====================
+*/
+memtag_t Mem_SetTag (memtag_t tag)
+{
+	const memtag_t prev = mem_thread_tag;
+	mem_thread_tag = tag;
+	return prev;
+}
+
+/*
+====================
+Mem_GetAllocCount
+====================
+*/
+uint64_t Mem_GetAllocCount (void)
+{
+	uint64_t count = 0;
+	for (int i = 0; i < MEMTAG_COUNT; ++i)
+		count += Atomic_LoadUInt64 (&memtag_stats[i].allocs);
+	return count;
+}
+
+/*
+====================
+Mem_EndFrame
+
+Called by the main thread at the end of every host frame. With mem_framewarn set,
+lists the tags that allocated during the frame, so steady state allocations in hot
+paths can be found.
+====================
+*/
+void Mem_EndFrame (void)
+{
+	char     line[256];
+	qboolean warn = false;
+
+	line[0] = 0;
+	for (int i = 0; i < MEMTAG_COUNT; ++i)
+	{
+		memtag_stats_t *stats = &memtag_stats[i];
+		const uint32_t  count = Atomic_LoadUInt32 (&stats->frame_allocs);
+
+		Atomic_AddUInt32 (&stats->frame_allocs, -count);
+		stats->last_frame_allocs = count;
+		stats->peak_frame_allocs = q_max (stats->peak_frame_allocs, count);
+		if (count && mem_framewarn.value)
+		{
+			q_strlcat (line, va (" %s %u", memtag_names[i], count), sizeof (line));
+			warn = true;
+		}
+	}
+	if (warn)
+		Con_Printf ("frame %d allocations:%s\n", host_framecount, line);
+
+	// a Host_Error can longjmp out of a tagged scope
+	mem_thread_tag = MEMTAG_MISC;
+}
+
+/*
+====================
+Mem_PrintBenchmarkStats
+====================
+*/
+void Mem_PrintBenchmarkStats (uint64_t start_allocs, int frames)
+{
+	const uint64_t allocs = Mem_GetAllocCount () - start_allocs;
+	Con_Printf (
+		"%.0f allocations %.1f per frame, %.1f MB current %.1f MB peak\n", (double)allocs, frames ? (double)allocs / frames : 0.0,
+		Atomic_LoadUInt64 (&mem_total_bytes) / (1024.0 * 1024.0), Atomic_LoadUInt64 (&mem_peak_bytes) / (1024.0 * 1024.0));
+}
+#endif
+
+/*
+====================
+Mem_Alloc
+====================
+*/
+void *Mem_Alloc (const size_t size)
+{
+#ifdef USE_MEM_TAGS
+	return Mem_AllocTagged (size, mem_thread_tag);
+#else
+	return Mem_RawAlloc (size);
+#endif
+}
+
+/*
+====================
+Mem_Realloc
+====================
+*/
+void *Mem_Realloc (void *ptr, const size_t size)
+{
+#ifdef USE_MEM_TAGS
+	if (!ptr)
+		return Mem_AllocTagged (size, mem_thread_tag);
+	return Mem_ReallocTagged (ptr, size, ((mem_header_t *)((byte *)ptr - MEM_HEADER_SIZE))->tag);
+#else
+	return Mem_RawRealloc (ptr, size);
+#endif
+}
+
+/*
+====================
+Mem_Free
+====================
+*/
+void Mem_Free (const void *ptr)
+{
+#ifdef USE_MEM_TAGS
+	const mem_header_t *header;
+
+	if (!ptr)
+		return;
+	header = (const mem_header_t *)((const byte *)ptr - MEM_HEADER_SIZE);
+	Mem_RemoveAllocation (header->tag, header->size);
+	Mem_RawFree (header);
+#else
+	Mem_RawFree (ptr);
+#endif
+}
+
+/*
+====================
+Mem_Stats_f
+====================
+*/
+void Mem_Stats_f (void)
+{
+#ifdef USE_MEM_TAGS
+	const int num_threads = q_min ((int)Atomic_LoadUInt32 (&mem_num_threads), MEM_MAX_THREADS);
+
+	Con_Printf ("tag            current KB    peak KB     live    allocs  frame  peak frame\n");
+	for (int i = 0; i < MEMTAG_COUNT; ++i)
+	{
+		memtag_stats_t *stats = &memtag_stats[i];
+		Con_Printf (
+			"%-12s %12.1f %10.1f %8.0f %9.0f %6u %11u\n", memtag_names[i], Atomic_LoadUInt64 (&stats->bytes) / 1024.0,
+			Atomic_LoadUInt64 (&stats->peak_bytes) / 1024.0, (double)Atomic_LoadUInt64 (&stats->live), (double)Atomic_LoadUInt64 (&stats->allocs),
+			stats->last_frame_allocs, stats->peak_frame_allocs);
+	}
+	Con_Printf (
+		"total        %12.1f %10.1f\n\n", Atomic_LoadUInt64 (&mem_total_bytes) / 1024.0, Atomic_LoadUInt64 (&mem_peak_bytes) / 1024.0);
+
+	Con_Printf ("thread      allocs     frees  allocated KB\n");
+	for (int i = 0; i < num_threads; ++i)
+	{
+		memthread_stats_t *stats = &memthread_stats[i];
+		Con_Printf (
+			"%-6s %11.0f %9.0f %13.1f\n", i ? va ("%d", i) : "main", (double)Atomic_LoadUInt64 (&stats->allocs), (double)Atomic_LoadUInt64 (&stats->frees),
+			Atomic_LoadUInt64 (&stats->bytes) / 1024.0);
+	}
+#else
+	Con_Printf ("memstats: built with NO_MEM_TAGS\n");
+#endif
+}
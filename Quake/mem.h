@@ -26,10 +26,59 @@
 // Mem_Alloc will always return zero initialized memory
 // A lot of old code was assuming this and overhead is negligible
 
+// Allocations are accounted per tag, see memstats. Mem_Alloc uses the calling thread's
+// current tag, which subsystems set with Mem_SetTag around their loading code.
+// Build with NO_MEM_TAGS to compile the accounting out.
+#ifndef NO_MEM_TAGS
+#define USE_MEM_TAGS
+#endif
+
+typedef enum
+{
+	MEMTAG_MISC,
+	MEMTAG_MODEL,
+	MEMTAG_TEXTURE,
+	MEMTAG_SOUND,
+	MEMTAG_QCSTRING,
+	MEMTAG_EDICT,
+	MEMTAG_PARTICLE,
+	MEMTAG_RT,
+	MEMTAG_COUNT
+} memtag_t;
+
 void  Mem_Init ();
 void *Mem_Alloc (const size_t size);
 void *Mem_Realloc (void *ptr, const size_t size);
 void  Mem_Free (const void *ptr);
+void  Mem_Stats_f (void);
+
+#ifdef USE_MEM_TAGS
+void    *Mem_AllocTagged (const size_t size, memtag_t tag);
+void    *Mem_ReallocTagged (void *ptr, const size_t size, memtag_t tag);
+memtag_t Mem_SetTag (memtag_t tag); // returns the previous tag of the calling thread
+uint64_t Mem_GetAllocCount (void);
+void     Mem_EndFrame (void);
+void     Mem_PrintBenchmarkStats (uint64_t start_allocs, int frames);
+#else
+static inline void *Mem_AllocTagged (const size_t size, memtag_t tag)
+{
+	return Mem_Alloc (size);
+}
+static inline void *Mem_ReallocTagged (void *ptr, const size_t size, memtag_t tag)
+{
+	return Mem_Realloc (ptr, size);
+}
+static inline memtag_t Mem_SetTag (memtag_t tag)
+{
+	return MEMTAG_MISC;
+}
+static inline uint64_t Mem_GetAllocCount (void)
+{
+	return 0;
+}
+static inline void Mem_EndFrame (void) {}
+static inline void Mem_PrintBenchmarkStats (uint64_t start_allocs, int frames) {}
+#endif
 
 #define SAFE_FREE(ptr)  \
 	do                  \
@@ -101,6 +101,17 @@ void NET_Close (struct qsocket_s *sock);
 // A netcon_t number will not be reused until this function is called for it
 
 void NET_Poll (void);
+void NET_BeginSendBatch (void);
+void NET_FlushSendBatch (void);
+// datagrams sent between these two calls may be coalesced into fewer system calls
+
+// listening sockets of an additional server instance, on a port of its own.
+// swapping them in makes the datagram driver accept and read on them instead.
+typedef struct net_listenset_s net_listenset_t;
+net_listenset_t *NET_OpenListenSet (int port);
+void             NET_CloseListenSet (net_listenset_t *set);
+void             NET_SwapListenSet (net_listenset_t *set);
+void             NET_AllocQSockets (int count);
 
 // Server list related globals:
 extern qboolean slistInProgress;
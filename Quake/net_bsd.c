@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "net_dgrm.h"
 #include "net_loop.h"
+#include "net_replay.h"
 
 net_driver_t net_drivers[] = {
 	{"Loopback", false, Loop_Init, Loop_Listen, Loop_QueryAddresses, Loop_SearchForHosts, Loop_Connect, Loop_CheckNewConnections, Loop_GetAnyMessage,
@@ -34,12 +35,24 @@ net_driver_t net_drivers[] = {
 
 	{"Datagram", false, Datagram_Init, Datagram_Listen, Datagram_QueryAddresses, Datagram_SearchForHosts, Datagram_Connect, Datagram_CheckNewConnections,
      Datagram_GetAnyMessage, Datagram_GetMessage, Datagram_SendMessage, Datagram_SendUnreliableMessage, Datagram_CanSendMessage,
-     Datagram_CanSendUnreliableMessage, Datagram_Close, Datagram_Shutdown}};
+     Datagram_CanSendUnreliableMessage, Datagram_Close, Datagram_Shutdown},
+
+	{"Replay", false, Replay_Init, Replay_Listen, Replay_QueryAddresses, Replay_SearchForHosts, Replay_Connect, Replay_CheckNewConnections,
+     Replay_GetAnyMessage, Replay_GetMessage, Replay_SendMessage, Replay_SendUnreliableMessage, Replay_CanSendMessage, Replay_CanSendUnreliableMessage,
+     Replay_Close, Replay_Shutdown}};
 
 const int net_numdrivers = (sizeof (net_drivers) / sizeof (net_drivers[0]));
 
 #include "net_udp.h"
 
+#ifdef UDP_BATCHED_IO
+#define UDP_READBATCH  UDP_ReadBatch
+#define UDP_WRITEBATCH UDP_WriteBatch
+#else
+#define UDP_READBATCH  NULL
+#define UDP_WRITEBATCH NULL
+#endif
+
 net_landriver_t net_landrivers[] = {
 	{"UDP",
      false,
@@ -62,7 +75,9 @@ net_landriver_t net_landrivers[] = {
      UDP4_GetAddrFromName,
      UDP_AddrCompare,
      UDP_GetSocketPort,
-     UDP_SetSocketPort},
+     UDP_SetSocketPort,
+     UDP_READBATCH,
+     UDP_WRITEBATCH},
 	{"UDP6",
      false,
      0,
@@ -84,6 +99,8 @@ net_landriver_t net_landrivers[] = {
      UDP6_GetAddrFromName,
      UDP_AddrCompare,
      UDP_GetSocketPort,
-     UDP_SetSocketPort}};
+     UDP_SetSocketPort,
+     UDP_READBATCH,
+     UDP_WRITEBATCH}};
 
 const int net_numlandrivers = (sizeof (net_landrivers) / sizeof (net_landrivers[0]));
@@ -182,6 +182,14 @@ extern qsocket_t *net_activeSockets;
 extern qsocket_t *net_freeSockets;
 extern int        net_numsockets;
 
+// one datagram of a batched read or write (see ReadBatch/WriteBatch below)
+typedef struct
+{
+	struct qsockaddr addr;
+	byte            *data;
+	int              length;
+} net_batchpacket_t;
+
 typedef struct
 {
 	const char  *name;
@@ -206,6 +214,9 @@ typedef struct
 	int (*AddrCompare) (struct qsockaddr *addr1, struct qsockaddr *addr2);
 	int (*GetSocketPort) (struct qsockaddr *addr);
 	int (*SetSocketPort) (struct qsockaddr *addr, int port);
+	// optional: move several datagrams with a single system call. NULL if unsupported.
+	int (*ReadBatch) (sys_socket_t socketid, net_batchpacket_t *packets, int count, int maxlen);
+	int (*WriteBatch) (sys_socket_t socketid, net_batchpacket_t *packets, int count);
 
 	sys_socket_t listeningSock;
 } net_landriver_t;
@@ -28,6 +28,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "quakedef.h"
 #include "net_defs.h"
 #include "net_dgrm.h"
+#include "net_replay.h"
 
 // these two macros are to make the code more readable
 #define sfunc net_landrivers[sock->landriver]
@@ -71,6 +72,31 @@ static struct
 	byte         data[MAX_DATAGRAM];
 } packetBuffer;
 
+// datagrams drained from a listening socket with a single ReadBatch, waiting to be dispatched to their qsockets
+#define NET_PACKETPOOL_SIZE 32
+typedef struct
+{
+	net_batchpacket_t packets[NET_PACKETPOOL_SIZE];
+	byte             *buffer;
+	int               count;
+	int               next;
+} packetpool_t;
+static packetpool_t packetPool[MAX_NET_DRIVERS];
+
+// outgoing datagrams queued between Datagram_BeginSendBatch and Datagram_FlushSendBatch
+#define NET_SENDQUEUE_SIZE  128
+#define NET_SENDQUEUE_BYTES (256 * 1024)
+static struct
+{
+	qboolean          active;
+	int               count;
+	int               used;
+	byte             *data;
+	int               landriver[NET_SENDQUEUE_SIZE];
+	sys_socket_t      socket[NET_SENDQUEUE_SIZE];
+	net_batchpacket_t packets[NET_SENDQUEUE_SIZE];
+} sendQueue;
+
 static int myDriverLevel;
 
 extern qboolean m_return_onerror;
@@ -148,6 +174,169 @@ static void NET_Ban_f (void)
 }
 #endif // BAN_TEST
 
+/*
+====================
+Datagram_FillPacketPool
+====================
+*/
+static int Datagram_FillPacketPool (int landriver, sys_socket_t sock)
+{
+	packetpool_t *pool = &packetPool[landriver];
+	int           i;
+
+	if (!pool->buffer)
+	{
+		pool->buffer = (byte *)Mem_Alloc (NET_PACKETPOOL_SIZE * NET_DATAGRAMSIZE);
+		for (i = 0; i < NET_PACKETPOOL_SIZE; i++)
+			pool->packets[i].data = pool->buffer + i * NET_DATAGRAMSIZE;
+	}
+
+	pool->next = 0;
+	pool->count = net_landrivers[landriver].ReadBatch (sock, pool->packets, NET_PACKETPOOL_SIZE, NET_DATAGRAMSIZE);
+	if (pool->count < 0)
+	{
+		pool->count = 0;
+		return -1;
+	}
+	return pool->count;
+}
+
+/*
+====================
+Datagram_ReadListening
+
+Reads the next datagram of the listening socket into packetBuffer,
+going through the packet pool when the lan driver supports batching.
+====================
+*/
+static int Datagram_ReadListening (sys_socket_t sock, struct qsockaddr *addr)
+{
+	packetpool_t      *pool = &packetPool[net_landriverlevel];
+	net_batchpacket_t *packet;
+	int                ret;
+
+	if (!dfunc.ReadBatch)
+		return dfunc.Read (sock, (byte *)&packetBuffer, NET_DATAGRAMSIZE, addr);
+
+	if (pool->next == pool->count)
+	{
+		ret = Datagram_FillPacketPool (net_landriverlevel, sock);
+		if (ret <= 0)
+			return ret;
+	}
+
+	packet = &pool->packets[pool->next++];
+	memcpy (&packetBuffer, packet->data, packet->length);
+	*addr = packet->addr;
+	return packet->length;
+}
+
+/*
+====================
+Datagram_Poll
+
+Drains everything that is pending on the listening sockets into the packet pools,
+so that the following Datagram_GetAnyMessage calls don't need a system call per packet.
+====================
+*/
+void Datagram_Poll (void)
+{
+	int i;
+
+	for (i = 0; i < net_numlandrivers; i++)
+	{
+		if (!net_landrivers[i].initialized || !net_landrivers[i].ReadBatch)
+			continue;
+		if (net_landrivers[i].listeningSock == INVALID_SOCKET)
+			continue;
+		if (packetPool[i].next == packetPool[i].count)
+			Datagram_FillPacketPool (i, net_landrivers[i].listeningSock);
+	}
+}
+
+/*
+====================
+Datagram_BeginSendBatch
+
+Until the next Datagram_FlushSendBatch, datagrams written by lan drivers
+that support batching are queued instead of being sent one by one.
+====================
+*/
+void Datagram_BeginSendBatch (void)
+{
+	if (!sendQueue.data)
+		sendQueue.data = (byte *)Mem_Alloc (NET_SENDQUEUE_BYTES);
+	sendQueue.active = true;
+}
+
+static void Datagram_FlushSendQueue (void)
+{
+	net_batchpacket_t batch[NET_SENDQUEUE_SIZE];
+	qboolean          sent[NET_SENDQUEUE_SIZE];
+	int               i, j, n;
+
+	memset (sent, 0, sizeof (sent[0]) * sendQueue.count);
+	for (i = 0; i < sendQueue.count; i++)
+	{
+		if (sent[i])
+			continue;
+
+		// one WriteBatch per socket, keeping the order of each socket's datagrams
+		for (j = i, n = 0; j < sendQueue.count; j++)
+		{
+			if (sent[j] || sendQueue.landriver[j] != sendQueue.landriver[i] || sendQueue.socket[j] != sendQueue.socket[i])
+				continue;
+			batch[n++] = sendQueue.packets[j];
+			sent[j] = true;
+		}
+		net_landrivers[sendQueue.landriver[i]].WriteBatch (sendQueue.socket[i], batch, n);
+	}
+
+	sendQueue.count = 0;
+	sendQueue.used = 0;
+}
+
+/*
+====================
+Datagram_FlushSendBatch
+====================
+*/
+void Datagram_FlushSendBatch (void)
+{
+	Datagram_FlushSendQueue ();
+	sendQueue.active = false;
+}
+
+/*
+====================
+Datagram_Write
+
+Write errors of queued datagrams cannot be reported back to the caller,
+they are treated like lost packets (reliables get resent, dead clients time out).
+====================
+*/
+static int Datagram_Write (qsocket_t *sock, byte *data, int length)
+{
+	net_batchpacket_t *packet;
+
+	if (!sendQueue.active || !sfunc.WriteBatch)
+		return sfunc.Write (sock->socket, data, length, &sock->addr);
+
+	if (sendQueue.count == NET_SENDQUEUE_SIZE || sendQueue.used + length > NET_SENDQUEUE_BYTES)
+		Datagram_FlushSendQueue ();
+
+	packet = &sendQueue.packets[sendQueue.count];
+	packet->addr = sock->addr;
+	packet->data = sendQueue.data + sendQueue.used;
+	packet->length = length;
+	memcpy (packet->data, data, length);
+	sendQueue.landriver[sendQueue.count] = sock->landriver;
+	sendQueue.socket[sendQueue.count] = sock->socket;
+	sendQueue.count++;
+	sendQueue.used += length;
+	return length;
+}
+
 int Datagram_SendMessage (qsocket_t *sock, sizebuf_t *data)
 {
 	unsigned int packetLen;
@@ -188,7 +377,7 @@ int Datagram_SendMessage (qsocket_t *sock, sizebuf_t *data)
 
 	sock->canSend = false;
 
-	if (sfunc.Write (sock->socket, (byte *)&packetBuffer, packetLen, &sock->addr) == -1)
+	if (Datagram_Write (sock, (byte *)&packetBuffer, packetLen) == -1)
 		return -1;
 
 	sock->lastSendTime = net_time;
@@ -220,7 +409,7 @@ static int SendMessageNext (qsocket_t *sock)
 
 	sock->sendNext = false;
 
-	if (sfunc.Write (sock->socket, (byte *)&packetBuffer, packetLen, &sock->addr) == -1)
+	if (Datagram_Write (sock, (byte *)&packetBuffer, packetLen) == -1)
 		return -1;
 
 	sock->lastSendTime = net_time;
@@ -250,7 +439,7 @@ static int ReSendMessage (qsocket_t *sock)
 	packetBuffer.sequence = BigLong (sock->sendSequence - 1);
 	memcpy (packetBuffer.data, sock->sendMessage, dataLen);
 
-	if (sfunc.Write (sock->socket, (byte *)&packetBuffer, packetLen, &sock->addr) == -1)
+	if (Datagram_Write (sock, (byte *)&packetBuffer, packetLen) == -1)
 		return -1;
 
 	sock->lastSendTime = net_time;
@@ -289,7 +478,7 @@ int Datagram_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
 	packetBuffer.sequence = BigLong (sock->unreliableSendSequence++);
 	memcpy (packetBuffer.data, data->data, data->cursize);
 
-	if (sfunc.Write (sock->socket, (byte *)&packetBuffer, packetLen, &sock->addr) == -1)
+	if (Datagram_Write (sock, (byte *)&packetBuffer, packetLen) == -1)
 		return -1;
 
 	packetsSent++;
@@ -385,7 +574,7 @@ qboolean Datagram_ProcessPacket (unsigned int length, qsocket_t *sock)
 	{
 		packetBuffer.length = BigLong (NET_HEADERSIZE | NETFLAG_ACK);
 		packetBuffer.sequence = BigLong (sequence);
-		sfunc.Write (sock->socket, (byte *)&packetBuffer, NET_HEADERSIZE, &sock->addr);
+		Datagram_Write (sock, (byte *)&packetBuffer, NET_HEADERSIZE);
 
 		if (sequence != sock->receiveSequence)
 		{
@@ -442,7 +631,7 @@ qsocket_t *Datagram_GetAnyMessage (void)
 
 		while (1)
 		{
-			length = dfunc.Read (sock, (byte *)&packetBuffer, NET_DATAGRAMSIZE, &addr);
+			length = Datagram_ReadListening (sock, &addr);
 			if (length == -1 || !length)
 			{
 				// no more packets, move on to the next.
@@ -464,13 +653,14 @@ qsocket_t *Datagram_GetAnyMessage (void)
 					continue;
 				if (s->disconnected)
 					continue;
-				if (!s->isvirtual)
+				if (!s->isvirtual || s->socket != sock)
 					continue;
 				if (dfunc.AddrCompare (&addr, &s->addr) == 0)
 				{
 					// okay, looks like this is us. try to process it, and if there's new data
 					if (Datagram_ProcessPacket (length, s))
 					{
+						NET_CaptureMessage (s);
 						s->lastMessageTime = net_time;
 						return s; // the server needs to parse that packet.
 					}
@@ -483,8 +673,8 @@ qsocket_t *Datagram_GetAnyMessage (void)
 	{
 		if (s->driver != net_driverlevel)
 			continue;
-		if (!s->isvirtual)
-			continue;
+		if (!s->isvirtual || s->socket != net_landrivers[s->landriver].listeningSock)
+			continue; // not a client of the running server instance
 
 		if (s->sendNext)
 			SendMessageNext (s);
@@ -1013,6 +1203,110 @@ JustDoIt:
 	SchedulePollProcedure (&test2PollProcedure, 0.05);
 }
 
+/*
+====================
+Datagram_BenchmarkSocket
+
+Sends packets datagrams of size bytes to the socket itself, in bursts of
+NET_PACKETPOOL_SIZE, and reads them back. Returns the elapsed time.
+====================
+*/
+static double Datagram_BenchmarkSocket (sys_socket_t sock, struct qsockaddr *addr, int packets, int size, qboolean batched, int *received)
+{
+	net_batchpacket_t batch[NET_PACKETPOOL_SIZE];
+	struct qsockaddr  from;
+	byte             *buffer = (byte *)Mem_Alloc (NET_PACKETPOOL_SIZE * size);
+	double            start = Sys_DoubleTime ();
+	int               i, n, got, ret, sent;
+
+	*received = 0;
+	for (sent = 0; sent < packets; sent += n)
+	{
+		n = q_min (packets - sent, NET_PACKETPOOL_SIZE);
+		got = 0;
+		if (batched)
+		{
+			for (i = 0; i < n; i++)
+			{
+				batch[i].addr = *addr;
+				batch[i].data = buffer + i * size;
+				batch[i].length = size;
+			}
+			dfunc.WriteBatch (sock, batch, n);
+			while (got < n)
+			{
+				ret = dfunc.ReadBatch (sock, batch, n - got, size);
+				if (ret <= 0)
+					break;
+				got += ret;
+			}
+		}
+		else
+		{
+			for (i = 0; i < n; i++)
+				dfunc.Write (sock, buffer, size, addr);
+			while (got < n)
+			{
+				ret = dfunc.Read (sock, buffer, size, &from);
+				if (ret <= 0)
+					break;
+				got++;
+			}
+		}
+		*received += got;
+	}
+
+	Mem_Free (buffer);
+	return Sys_DoubleTime () - start;
+}
+
+/*
+====================
+NET_Benchmark_f
+
+net_benchmark [packets] [size]: loopback stress test comparing per-packet and batched socket I/O.
+====================
+*/
+static void NET_Benchmark_f (void)
+{
+	int              packets = (Cmd_Argc () > 1) ? atoi (Cmd_Argv (1)) : 100000;
+	int              size = (Cmd_Argc () > 2) ? atoi (Cmd_Argv (2)) : 64;
+	int              received_single, received_batched;
+	double           time_single, time_batched;
+	qboolean         tested = false;
+	struct qsockaddr addr;
+	sys_socket_t     sock;
+
+	packets = q_max (packets, NET_PACKETPOOL_SIZE);
+	size = CLAMP ((int)NET_HEADERSIZE, size, (int)NET_DATAGRAMSIZE);
+
+	for (net_landriverlevel = 0; net_landriverlevel < net_numlandrivers; net_landriverlevel++)
+	{
+		if (!dfunc.initialized || !dfunc.ReadBatch || !dfunc.WriteBatch)
+			continue;
+		sock = dfunc.Open_Socket (0);
+		if (sock == INVALID_SOCKET)
+			continue;
+		if (dfunc.GetSocketAddr (sock, &addr) == -1)
+		{
+			dfunc.Close_Socket (sock);
+			continue;
+		}
+
+		time_single = Datagram_BenchmarkSocket (sock, &addr, packets, size, false, &received_single);
+		time_batched = Datagram_BenchmarkSocket (sock, &addr, packets, size, true, &received_batched);
+		dfunc.Close_Socket (sock);
+		tested = true;
+
+		Con_Printf ("%s: %i packets of %i bytes to %s\n", dfunc.name, packets, size, dfunc.AddrToString (&addr, false));
+		Con_Printf ("  single : %8.0f packets/s (%i received)\n", received_single / q_max (time_single, 1e-6), received_single);
+		Con_Printf ("  batched: %8.0f packets/s (%i received)\n", received_batched / q_max (time_batched, 1e-6), received_batched);
+	}
+
+	if (!tested)
+		Con_Printf ("net_benchmark: no lan driver with batched I/O\n");
+}
+
 int Datagram_Init (void)
 {
 	int          i, num_inited;
@@ -1046,6 +1340,7 @@ int Datagram_Init (void)
 
 	Cmd_AddCommand ("test", Test_f);
 	Cmd_AddCommand ("test2", Test2_f);
+	Cmd_AddCommand ("net_benchmark", NET_Benchmark_f);
 
 	return 0;
 }
@@ -1067,10 +1362,23 @@ void Datagram_Shutdown (void)
 			net_landrivers[i].initialized = false;
 		}
 	}
+
+	//
+	// release the batching buffers, anything still pooled or queued is dropped with the sockets
+	//
+	for (i = 0; i < MAX_NET_DRIVERS; i++)
+	{
+		SAFE_FREE (packetPool[i].buffer);
+		packetPool[i].count = packetPool[i].next = 0;
+	}
+	SAFE_FREE (sendQueue.data);
+	sendQueue.active = false;
+	sendQueue.count = sendQueue.used = 0;
 }
 
 void Datagram_Close (qsocket_t *sock)
 {
+	NET_CaptureClose (sock);
 	if (sock->isvirtual)
 	{
 		sock->isvirtual = false;
@@ -1092,13 +1400,17 @@ void Datagram_Listen (qboolean state)
 	{
 		if (net_landrivers[i].initialized)
 		{
+			sys_socket_t oldsock = net_landrivers[i].listeningSock;
+
 			net_landrivers[i].listeningSock = net_landrivers[i].Listen (state);
+			packetPool[i].count = packetPool[i].next = 0;
 			if (net_landrivers[i].listeningSock != INVALID_SOCKET)
 				islistening = true;
 
+			// clients of other server instances are on sockets of their own
 			for (s = net_activeSockets; s; s = s->next)
 			{
-				if (s->isvirtual)
+				if (s->isvirtual && s->landriver == i && s->socket == oldsock)
 				{
 					s->isvirtual = false;
 					s->socket = INVALID_SOCKET;
@@ -1114,6 +1426,89 @@ void Datagram_Listen (qboolean state)
 	}
 }
 
+struct net_listenset_s
+{
+	sys_socket_t sockets[MAX_NET_DRIVERS];
+};
+
+/*
+====================
+Datagram_OpenListenSet
+
+Opens a socket on port for every lan driver that is currently listening.
+Returns NULL if none could be opened.
+====================
+*/
+net_listenset_t *Datagram_OpenListenSet (int port)
+{
+	net_listenset_t *set = (net_listenset_t *)Mem_Alloc (sizeof (net_listenset_t));
+	qboolean         opened = false;
+	int              i;
+
+	for (i = 0; i < MAX_NET_DRIVERS; i++)
+	{
+		set->sockets[i] = INVALID_SOCKET;
+		if (i >= net_numlandrivers || !net_landrivers[i].initialized || net_landrivers[i].listeningSock == INVALID_SOCKET)
+			continue;
+		set->sockets[i] = net_landrivers[i].Open_Socket (port);
+		if (set->sockets[i] != INVALID_SOCKET)
+			opened = true;
+	}
+
+	if (!opened)
+	{
+		Mem_Free (set);
+		return NULL;
+	}
+	return set;
+}
+
+/*
+====================
+Datagram_CloseListenSet
+
+The set must not be swapped in.
+====================
+*/
+void Datagram_CloseListenSet (net_listenset_t *set)
+{
+	int i;
+
+	if (!set)
+		return;
+	for (i = 0; i < net_numlandrivers; i++)
+	{
+		if (set->sockets[i] != INVALID_SOCKET)
+			net_landrivers[i].Close_Socket (set->sockets[i]);
+	}
+	Mem_Free (set);
+}
+
+/*
+====================
+Datagram_SwapListenSet
+
+Exchanges the listening sockets of the lan drivers with the ones in set, calling it
+again swaps them back. Virtual qsockets stay bound to the socket they were accepted on.
+Datagrams still pooled from the previous sockets are dropped like lost packets.
+====================
+*/
+void Datagram_SwapListenSet (net_listenset_t *set)
+{
+	sys_socket_t sock;
+	int          i;
+
+	for (i = 0; i < net_numlandrivers; i++)
+	{
+		if (!net_landrivers[i].initialized)
+			continue;
+		sock = net_landrivers[i].listeningSock;
+		net_landrivers[i].listeningSock = set->sockets[i];
+		set->sockets[i] = sock;
+		packetPool[i].count = packetPool[i].next = 0;
+	}
+}
+
 static struct qsockaddr rcon_response_address;
 static sys_socket_t     rcon_response_socket;
 static sys_socket_t     rcon_response_landriver;
@@ -1462,6 +1857,8 @@ static void _Datagram_ServerControlPacket (sys_socket_t acceptsock, struct qsock
 			continue;
 		if (s->disconnected)
 			continue;
+		if (s->isvirtual && s->socket != acceptsock)
+			continue; // connected to another server instance
 		ret = dfunc.AddrCompare (clientaddr, &s->addr);
 		if (ret == 0)
 		{
@@ -36,5 +36,12 @@ qboolean   Datagram_CanSendMessage (qsocket_t *sock);
 qboolean   Datagram_CanSendUnreliableMessage (qsocket_t *sock);
 void       Datagram_Close (qsocket_t *sock);
 void       Datagram_Shutdown (void);
+void       Datagram_Poll (void);
+void       Datagram_BeginSendBatch (void);
+void       Datagram_FlushSendBatch (void);
+
+net_listenset_t *Datagram_OpenListenSet (int port);
+void             Datagram_CloseListenSet (net_listenset_t *set);
+void             Datagram_SwapListenSet (net_listenset_t *set);
 
 #endif /* __NET_DATAGRAM_H */
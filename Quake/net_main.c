@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "net_sys.h"
 #include "quakedef.h"
 #include "net_defs.h"
+#include "net_dgrm.h"
 
 qsocket_t *net_activeSockets = NULL;
 qsocket_t *net_freeSockets = NULL;
@@ -804,8 +805,7 @@ NET_Init
 
 void NET_Init (void)
 {
-	int        i;
-	qsocket_t *s;
+	int i;
 
 	i = COM_CheckParm ("-port");
 	if (!i)
@@ -822,21 +822,12 @@ void NET_Init (void)
 	}
 	net_hostport = DEFAULTnet_hostport;
 
-	net_numsockets = svs.maxclientslimit;
-	if (cls.state != ca_dedicated)
-		net_numsockets++;
 	if (COM_CheckParm ("-listen") || cls.state == ca_dedicated)
 		listening = true;
 
 	SetNetTime ();
 
-	for (i = 0; i < net_numsockets; i++)
-	{
-		s = (qsocket_t *)Mem_Alloc (sizeof (qsocket_t));
-		s->next = net_freeSockets;
-		net_freeSockets = s;
-		s->disconnected = true;
-	}
+	NET_AllocQSockets (svs.maxclientslimit + (cls.state != ca_dedicated ? 1 : 0));
 
 	// allocate space for network message buffer
 	SZ_Alloc (&net_message, NET_MAXMESSAGE);
@@ -925,6 +916,68 @@ void NET_Poll (void)
 		pollProcedureList = pp->next;
 		pp->procedure (pp->arg);
 	}
+
+	if (listening)
+		Datagram_Poll ();
+}
+
+/*
+====================
+NET_BeginSendBatch
+
+Datagrams sent until NET_FlushSendBatch may be queued and sent together.
+====================
+*/
+void NET_BeginSendBatch (void)
+{
+	Datagram_BeginSendBatch ();
+}
+
+/*
+====================
+NET_FlushSendBatch
+====================
+*/
+void NET_FlushSendBatch (void)
+{
+	Datagram_FlushSendBatch ();
+}
+
+/*
+====================
+NET_AllocQSockets
+
+Adds count qsockets to the free list, for the clients of another server instance
+====================
+*/
+void NET_AllocQSockets (int count)
+{
+	qsocket_t *s;
+	int        i;
+
+	for (i = 0; i < count; i++)
+	{
+		s = (qsocket_t *)Mem_Alloc (sizeof (qsocket_t));
+		s->next = net_freeSockets;
+		net_freeSockets = s;
+		s->disconnected = true;
+	}
+	net_numsockets += count;
+}
+
+net_listenset_t *NET_OpenListenSet (int port)
+{
+	return Datagram_OpenListenSet (port);
+}
+
+void NET_CloseListenSet (net_listenset_t *set)
+{
+	Datagram_CloseListenSet (set);
+}
+
+void NET_SwapListenSet (net_listenset_t *set)
+{
+	Datagram_SwapListenSet (set);
 }
 
 void SchedulePollProcedure (PollProcedure *proc, double timeOffset)
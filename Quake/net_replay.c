@@ -0,0 +1,543 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// net_replay.c -- server-side network capture and replay
+
+/*
+net_capture records every complete message the datagram driver hands to the
+server (see Datagram_GetAnyMessage), with the time it was received.
+
+net_replay feeds a capture back to the running server through this driver,
+which is registered next to the loopback and datagram ones. The server is
+stepped with a fixed sys_ticrate, either as fast as possible or at the
+captured pace, and the time spent in each Host_ServerFrame is reported
+along with the bytes the server sent to each replayed client.
+
+All fields are little endian:
+	header: ident, version, maxclients, map[MAX_QPATH]
+	event:  float time, slot, type, length, data[length]
+*/
+
+#include "q_stdinc.h"
+#include "arch_def.h"
+#include "net_sys.h"
+#include "quakedef.h"
+#include "net_defs.h"
+#include "net_replay.h"
+
+#define NETCAPTURE_IDENT   (('P' << 24) + ('C' << 16) + ('N' << 8) + 'Q')
+#define NETCAPTURE_VERSION 1
+
+typedef enum
+{
+	NETCAPTURE_CONNECT,
+	NETCAPTURE_MESSAGE,
+	NETCAPTURE_DISCONNECT,
+} netcapture_type_t;
+
+typedef struct
+{
+	float time;
+	int   slot;
+	int   type;
+	int   length;
+} netcapture_event_t;
+
+static FILE      *capture_file;
+static double     capture_start;
+static qsocket_t *capture_sockets[MAX_SCOREBOARD];
+
+typedef struct
+{
+	qsocket_t *sock;
+	int        connected;
+	int        reliable_bytes;
+	int        unreliable_bytes;
+	int        messages;
+} replay_client_t;
+
+static int replay_driverlevel;
+
+static struct
+{
+	qboolean        active;
+	byte           *data;
+	int             size;
+	int             pos;
+	double          clock;
+	replay_client_t clients[MAX_SCOREBOARD];
+} replay;
+
+/*
+==============================================================================
+
+CAPTURE
+
+==============================================================================
+*/
+
+static void NET_CaptureWriteEvent (int slot, netcapture_type_t type, const void *data, int length)
+{
+	int   header[4];
+	float time = LittleFloat ((float)(Sys_DoubleTime () - capture_start));
+
+	memcpy (&header[0], &time, sizeof (time));
+	header[1] = LittleLong (slot);
+	header[2] = LittleLong (type);
+	header[3] = LittleLong (length);
+	fwrite (header, sizeof (header), 1, capture_file);
+	if (length)
+		fwrite (data, length, 1, capture_file);
+}
+
+/*
+====================
+NET_CaptureMessage
+
+Called with the message that was just received for sock in net_message.
+====================
+*/
+void NET_CaptureMessage (qsocket_t *sock)
+{
+	int slot, free_slot = -1;
+	int params[2];
+
+	if (!capture_file)
+		return;
+
+	for (slot = 0; slot < MAX_SCOREBOARD; slot++)
+	{
+		if (capture_sockets[slot] == sock)
+			break;
+		if (!capture_sockets[slot] && free_slot < 0)
+			free_slot = slot;
+	}
+	if (slot == MAX_SCOREBOARD)
+	{
+		if (free_slot < 0)
+			return;
+		slot = free_slot;
+		capture_sockets[slot] = sock;
+		params[0] = LittleLong (sock->pending_max_datagram);
+		params[1] = LittleLong (sock->proquake_angle_hack);
+		NET_CaptureWriteEvent (slot, NETCAPTURE_CONNECT, params, sizeof (params));
+	}
+
+	NET_CaptureWriteEvent (slot, NETCAPTURE_MESSAGE, net_message.data, net_message.cursize);
+}
+
+/*
+====================
+NET_CaptureClose
+====================
+*/
+void NET_CaptureClose (qsocket_t *sock)
+{
+	int slot;
+
+	if (!capture_file)
+		return;
+
+	for (slot = 0; slot < MAX_SCOREBOARD; slot++)
+	{
+		if (capture_sockets[slot] == sock)
+		{
+			NET_CaptureWriteEvent (slot, NETCAPTURE_DISCONNECT, NULL, 0);
+			capture_sockets[slot] = NULL;
+		}
+	}
+}
+
+/*
+====================
+NET_Capture_f
+====================
+*/
+static void NET_Capture_f (void)
+{
+	char name[MAX_OSPATH];
+	int  header[3];
+	char map[MAX_QPATH];
+
+	if (Cmd_Argc () != 2)
+	{
+		Con_Printf ("net_capture <name> : record client messages received by the server\n");
+		Con_Printf ("net_capture stop   : stop recording\n");
+		return;
+	}
+
+	if (capture_file)
+	{
+		fclose (capture_file);
+		capture_file = NULL;
+		Con_Printf ("Completed network capture\n");
+	}
+	if (!strcmp (Cmd_Argv (1), "stop"))
+		return;
+
+	if (!sv.active)
+	{
+		Con_Printf ("net_capture: no server running\n");
+		return;
+	}
+
+	q_snprintf (name, sizeof (name), "%s/%s", com_gamedir, Cmd_Argv (1));
+	COM_AddExtension (name, ".ncap", sizeof (name));
+	capture_file = fopen (name, "wb");
+	if (!capture_file)
+	{
+		Con_Printf ("ERROR: couldn't create %s\n", name);
+		return;
+	}
+	Con_Printf ("Capturing network traffic to %s\n", name);
+
+	header[0] = LittleLong (NETCAPTURE_IDENT);
+	header[1] = LittleLong (NETCAPTURE_VERSION);
+	header[2] = LittleLong (svs.maxclients);
+	memset (map, 0, sizeof (map));
+	q_strlcpy (map, sv.name, sizeof (map));
+	fwrite (header, sizeof (header), 1, capture_file);
+	fwrite (map, sizeof (map), 1, capture_file);
+
+	capture_start = Sys_DoubleTime ();
+	memset (capture_sockets, 0, sizeof (capture_sockets));
+}
+
+/*
+==============================================================================
+
+REPLAY DRIVER
+
+==============================================================================
+*/
+
+static qboolean Replay_PeekEvent (netcapture_event_t *ev)
+{
+	int header[4];
+
+	if (!replay.active || replay.pos + (int)sizeof (header) > replay.size)
+		return false;
+
+	memcpy (header, replay.data + replay.pos, sizeof (header));
+	memcpy (&ev->time, &header[0], sizeof (ev->time));
+	ev->time = LittleFloat (ev->time);
+	ev->slot = LittleLong (header[1]);
+	ev->type = LittleLong (header[2]);
+	ev->length = LittleLong (header[3]);
+	if (ev->slot < 0 || ev->slot >= MAX_SCOREBOARD || ev->length < 0 || ev->length > replay.size - replay.pos - (int)sizeof (header))
+	{
+		Con_Printf ("net_replay: corrupt capture at offset %i\n", replay.pos);
+		replay.pos = replay.size;
+		return false;
+	}
+	return ev->time <= replay.clock;
+}
+
+static const byte *Replay_NextEvent (const netcapture_event_t *ev)
+{
+	const byte *data = replay.data + replay.pos + 4 * sizeof (int);
+	replay.pos += 4 * sizeof (int) + ev->length;
+	return data;
+}
+
+static void NET_Replay_f (void);
+
+int Replay_Init (void)
+{
+	replay_driverlevel = net_driverlevel;
+	Cmd_AddCommand ("net_capture", NET_Capture_f);
+	Cmd_AddCommand ("net_replay", NET_Replay_f);
+	return 0;
+}
+
+void Replay_Shutdown (void)
+{
+	if (capture_file)
+	{
+		fclose (capture_file);
+		capture_file = NULL;
+	}
+}
+
+void Replay_Listen (qboolean state) {}
+
+qboolean Replay_SearchForHosts (qboolean xmit)
+{
+	return false;
+}
+
+qsocket_t *Replay_Connect (const char *host)
+{
+	return NULL;
+}
+
+qsocket_t *Replay_CheckNewConnections (void)
+{
+	netcapture_event_t ev;
+	replay_client_t   *client;
+	const byte        *data;
+	qsocket_t         *sock;
+
+	if (!Replay_PeekEvent (&ev) || ev.type != NETCAPTURE_CONNECT)
+		return NULL;
+
+	data = Replay_NextEvent (&ev);
+	client = &replay.clients[ev.slot];
+	if ((sock = NET_NewQSocket ()) == NULL)
+	{
+		Con_Printf ("net_replay: no qsocket available for client %i\n", ev.slot);
+		return NULL;
+	}
+	q_snprintf (sock->trueaddress, sizeof (sock->trueaddress), "replay:%i", ev.slot);
+	q_strlcpy (sock->maskedaddress, sock->trueaddress, sizeof (sock->maskedaddress));
+	if (ev.length >= 2 * (int)sizeof (int))
+	{
+		int params[2];
+		memcpy (params, data, sizeof (params));
+		sock->max_datagram = sock->pending_max_datagram = LittleLong (params[0]);
+		sock->proquake_angle_hack = LittleLong (params[1]);
+	}
+	sock->driverdata = client;
+	client->sock = sock;
+	client->connected++;
+	return sock;
+}
+
+qsocket_t *Replay_GetAnyMessage (void)
+{
+	netcapture_event_t ev;
+	replay_client_t   *client;
+	const byte        *data;
+
+	while (Replay_PeekEvent (&ev))
+	{
+		if (ev.type == NETCAPTURE_CONNECT)
+			return NULL; // let Replay_CheckNewConnections pick it up first
+
+		data = Replay_NextEvent (&ev);
+		client = &replay.clients[ev.slot];
+		if (!client->sock)
+			continue; // dropped by the server during the replay
+
+		SZ_Clear (&net_message);
+		if (ev.type == NETCAPTURE_DISCONNECT)
+			MSG_WriteByte (&net_message, clc_disconnect); // the captured client timed out or was dropped
+		else if (ev.length <= net_message.maxsize)
+			SZ_Write (&net_message, data, ev.length);
+		client->sock->lastMessageTime = net_time;
+		return client->sock;
+	}
+	return NULL;
+}
+
+int Replay_GetMessage (qsocket_t *sock)
+{
+	return 0;
+}
+
+int Replay_SendMessage (qsocket_t *sock, sizebuf_t *data)
+{
+	replay_client_t *client = (replay_client_t *)sock->driverdata;
+
+	if (!client)
+		return -1;
+	client->reliable_bytes += data->cursize;
+	client->messages++;
+	return 1;
+}
+
+int Replay_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
+{
+	replay_client_t *client = (replay_client_t *)sock->driverdata;
+
+	if (!client)
+		return -1;
+	client->unreliable_bytes += data->cursize;
+	client->messages++;
+	return 1;
+}
+
+qboolean Replay_CanSendMessage (qsocket_t *sock)
+{
+	return sock->driverdata != NULL;
+}
+
+qboolean Replay_CanSendUnreliableMessage (qsocket_t *sock)
+{
+	return true;
+}
+
+void Replay_Close (qsocket_t *sock)
+{
+	replay_client_t *client = (replay_client_t *)sock->driverdata;
+
+	if (client)
+		client->sock = NULL;
+	sock->driverdata = NULL;
+}
+
+/*
+==============================================================================
+
+REPLAY BENCHMARK
+
+==============================================================================
+*/
+
+static int Replay_CompareTicks (const void *a, const void *b)
+{
+	double da = *(const double *)a;
+	double db = *(const double *)b;
+	return (da > db) - (da < db);
+}
+
+/*
+====================
+NET_Replay_f
+
+net_replay <name> [realtime]
+====================
+*/
+static void NET_Replay_f (void)
+{
+	char      name[MAX_OSPATH];
+	char      map[MAX_QPATH];
+	int       header[3];
+	double   *ticks = NULL;
+	int       numticks = 0, maxticks = 0;
+	double    frametime, start, t, total;
+	double    saved_frametime = host_frametime;
+	qboolean  realtime;
+	int       i;
+	client_t *cl;
+
+	if (Cmd_Argc () < 2)
+	{
+		Con_Printf ("net_replay <name> [realtime] : replay a network capture against the running server\n");
+		return;
+	}
+	if (!sv.active || !listening)
+	{
+		Con_Printf ("net_replay: needs a listening server\n");
+		return;
+	}
+	if (replay.active)
+		return;
+
+	q_strlcpy (name, Cmd_Argv (1), sizeof (name));
+	COM_AddExtension (name, ".ncap", sizeof (name));
+	replay.data = COM_LoadFile (name, NULL);
+	if (!replay.data)
+	{
+		Con_Printf ("ERROR: couldn't open %s\n", name);
+		return;
+	}
+	replay.size = com_filesize;
+	if (replay.size < (int)(sizeof (header) + sizeof (map)))
+	{
+		Con_Printf ("net_replay: %s is too short\n", name);
+		Mem_Free (replay.data);
+		replay.data = NULL;
+		return;
+	}
+	memcpy (header, replay.data, sizeof (header));
+	memcpy (map, replay.data + sizeof (header), sizeof (map));
+	map[sizeof (map) - 1] = 0;
+	if (LittleLong (header[0]) != NETCAPTURE_IDENT || LittleLong (header[1]) != NETCAPTURE_VERSION)
+	{
+		Con_Printf ("net_replay: %s is not a version %i network capture\n", name, NETCAPTURE_VERSION);
+		Mem_Free (replay.data);
+		replay.data = NULL;
+		return;
+	}
+	if (strcmp (map, sv.name))
+		Con_Warning ("net_replay: captured on %s, replaying on %s\n", map, sv.name);
+	if (LittleLong (header[2]) > svs.maxclients)
+		Con_Warning ("net_replay: captured with %i clients, server has %i\n", LittleLong (header[2]), svs.maxclients);
+
+	realtime = Cmd_Argc () > 2 && atoi (Cmd_Argv (2));
+	frametime = q_max (sys_ticrate.value, 0.001f);
+	memset (replay.clients, 0, sizeof (replay.clients));
+	replay.pos = sizeof (header) + sizeof (map);
+	replay.clock = 0;
+	replay.active = true;
+
+	Con_Printf ("Replaying %s (%s, %.0f Hz)\n", name, realtime ? "real time" : "max speed", 1.0 / frametime);
+
+	start = Sys_DoubleTime ();
+	PR_SwitchQCVM (&sv.qcvm);
+	while (replay.pos < replay.size && sv.active)
+	{
+		replay.clock += frametime;
+		if (realtime)
+		{
+			while ((t = replay.clock - (Sys_DoubleTime () - start)) > 0)
+				Sys_Sleep ((unsigned long)(t * 1000.0));
+		}
+
+		t = Sys_DoubleTime ();
+		host_frametime = frametime;
+		Host_ServerFrame ();
+		t = Sys_DoubleTime () - t;
+
+		if (numticks == maxticks)
+		{
+			maxticks = q_max (maxticks * 2, 1024);
+			ticks = (double *)Mem_Realloc (ticks, maxticks * sizeof (double));
+		}
+		ticks[numticks++] = t;
+	}
+
+	// the replayed clients leave with the replay
+	for (i = 0, cl = svs.clients; i < svs.maxclients; i++, cl++)
+	{
+		if (cl->active && cl->netconnection && cl->netconnection->driver == replay_driverlevel)
+		{
+			host_client = cl;
+			SV_DropClient (false);
+		}
+	}
+	PR_SwitchQCVM (NULL);
+	host_frametime = saved_frametime;
+	replay.active = false;
+
+	total = 0;
+	for (i = 0; i < numticks; i++)
+		total += ticks[i];
+	if (numticks)
+	{
+		qsort (ticks, numticks, sizeof (double), Replay_CompareTicks);
+		Con_Printf ("%i ticks (%.1f s of traffic) in %.2f s\n", numticks, replay.clock, Sys_DoubleTime () - start);
+		Con_Printf ("tick ms: avg %.3f, p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n", 1000.0 * total / numticks, 1000.0 * ticks[numticks / 2],
+		            1000.0 * ticks[numticks * 90 / 100], 1000.0 * ticks[numticks * 99 / 100], 1000.0 * ticks[numticks - 1]);
+	}
+	for (i = 0; i < MAX_SCOREBOARD; i++)
+	{
+		replay_client_t *client = &replay.clients[i];
+		if (!client->connected)
+			continue;
+		Con_Printf ("client %2i: %8i reliable bytes, %8i unreliable bytes, %6i messages\n", i, client->reliable_bytes, client->unreliable_bytes,
+		            client->messages);
+	}
+
+	Mem_Free (ticks);
+	Mem_Free (replay.data);
+	replay.data = NULL;
+}
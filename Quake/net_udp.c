@@ -20,6 +20,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* recvmmsg, sendmmsg */
+#endif
+
 #include "q_stdinc.h"
 #include "arch_def.h"
 #include "net_sys.h"
@@ -372,6 +376,106 @@ int UDP_Write (sys_socket_t socketid, byte *buf, int len, struct qsockaddr *addr
 
 //=============================================================================
 
+#ifdef UDP_BATCHED_IO
+#define UDP_MAX_BATCH 64
+
+/*
+====================
+UDP_ReadBatch
+
+Reads up to count pending datagrams with a single recvmmsg.
+Each packet's data must point at maxlen bytes of storage.
+Returns the number of packets read, 0 if none are pending, -1 on error.
+====================
+*/
+int UDP_ReadBatch (sys_socket_t socketid, net_batchpacket_t *packets, int count, int maxlen)
+{
+	struct mmsghdr msgs[UDP_MAX_BATCH];
+	struct iovec   iovecs[UDP_MAX_BATCH];
+	int            i, ret;
+
+	count = q_min (count, UDP_MAX_BATCH);
+	memset (msgs, 0, sizeof (msgs[0]) * count);
+	for (i = 0; i < count; i++)
+	{
+		iovecs[i].iov_base = packets[i].data;
+		iovecs[i].iov_len = maxlen;
+		msgs[i].msg_hdr.msg_name = &packets[i].addr;
+		msgs[i].msg_hdr.msg_namelen = sizeof (struct qsockaddr);
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	ret = recvmmsg (socketid, msgs, count, MSG_DONTWAIT, NULL);
+	if (ret == SOCKET_ERROR)
+	{
+		int err = SOCKETERRNO;
+		if (err == NET_EWOULDBLOCK || err == NET_ECONNREFUSED)
+			return 0;
+		Con_SafePrintf ("UDP_ReadBatch, recvmmsg: %s\n", socketerror (err));
+		return -1;
+	}
+
+	for (i = 0; i < ret; i++)
+		packets[i].length = msgs[i].msg_len;
+	return ret;
+}
+
+/*
+====================
+UDP_WriteBatch
+
+Sends count datagrams, using as few sendmmsg calls as the kernel allows.
+Returns the number of packets sent, -1 on error.
+====================
+*/
+int UDP_WriteBatch (sys_socket_t socketid, net_batchpacket_t *packets, int count)
+{
+	struct mmsghdr msgs[UDP_MAX_BATCH];
+	struct iovec   iovecs[UDP_MAX_BATCH];
+	int            i, n, ret, sent = 0;
+
+	while (sent < count)
+	{
+		n = q_min (count - sent, UDP_MAX_BATCH);
+		memset (msgs, 0, sizeof (msgs[0]) * n);
+		for (i = 0; i < n; i++)
+		{
+			net_batchpacket_t    *packet = &packets[sent + i];
+			struct qsockaddr_hdr *hdr = (struct qsockaddr_hdr *)&packet->addr;
+
+			iovecs[i].iov_base = packet->data;
+			iovecs[i].iov_len = packet->length;
+			msgs[i].msg_hdr.msg_name = &packet->addr;
+			msgs[i].msg_hdr.msg_namelen = (hdr->qsa_family == AF_INET6) ? sizeof (struct sockaddr_in6) : sizeof (struct sockaddr_in);
+			msgs[i].msg_hdr.msg_iov = &iovecs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		ret = sendmmsg (socketid, msgs, n, 0);
+		if (ret == SOCKET_ERROR)
+		{
+			int err = SOCKETERRNO;
+			if (err == NET_EWOULDBLOCK)
+				return sent; // same as UDP_Write, the rest are dropped
+			if (err == ENETUNREACH)
+			{
+				// skip the offending packet, the others may still be deliverable
+				Con_SafePrintf ("UDP_WriteBatch: %s (%s)\n", socketerror (err), UDP_AddrToString (&packets[sent].addr, false));
+				sent++;
+				continue;
+			}
+			Con_SafePrintf ("UDP_WriteBatch, sendmmsg: %s\n", socketerror (err));
+			return -1;
+		}
+		sent += ret;
+	}
+	return sent;
+}
+#endif // UDP_BATCHED_IO
+
+//=============================================================================
+
 const char *UDP_AddrToString (struct qsockaddr *addr, qboolean masked)
 {
 	static char buffer[64];
@@ -62,4 +62,10 @@ int          UDP_GetSocketPort (struct qsockaddr *addr);
 int          UDP_SetSocketPort (struct qsockaddr *addr, int port);
 int          UDP6_GetAddresses (qhostaddr_t *addresses, int maxaddresses);
 
+#if defined(__linux__)
+#define UDP_BATCHED_IO /* recvmmsg/sendmmsg */
+int UDP_ReadBatch (sys_socket_t socketid, net_batchpacket_t *packets, int count, int maxlen);
+int UDP_WriteBatch (sys_socket_t socketid, net_batchpacket_t *packets, int count);
+#endif
+
 #endif /* __net_udp_h */
@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "net_dgrm.h"
 #include "net_loop.h"
+#include "net_replay.h"
 
 net_driver_t net_drivers[] = {
 	{"Loopback", false, Loop_Init, Loop_Listen, Loop_QueryAddresses, Loop_SearchForHosts, Loop_Connect, Loop_CheckNewConnections, Loop_GetAnyMessage,
@@ -34,7 +35,11 @@ net_driver_t net_drivers[] = {
 
 	{"Datagram", false, Datagram_Init, Datagram_Listen, Datagram_QueryAddresses, Datagram_SearchForHosts, Datagram_Connect, Datagram_CheckNewConnections,
      Datagram_GetAnyMessage, Datagram_GetMessage, Datagram_SendMessage, Datagram_SendUnreliableMessage, Datagram_CanSendMessage,
-     Datagram_CanSendUnreliableMessage, Datagram_Close, Datagram_Shutdown}};
+     Datagram_CanSendUnreliableMessage, Datagram_Close, Datagram_Shutdown},
+
+	{"Replay", false, Replay_Init, Replay_Listen, Replay_QueryAddresses, Replay_SearchForHosts, Replay_Connect, Replay_CheckNewConnections,
+     Replay_GetAnyMessage, Replay_GetMessage, Replay_SendMessage, Replay_SendUnreliableMessage, Replay_CanSendMessage, Replay_CanSendUnreliableMessage,
+     Replay_Close, Replay_Shutdown}};
 
 const int net_numdrivers = (sizeof (net_drivers) / sizeof (net_drivers[0]));
 
@@ -63,7 +68,9 @@ net_landriver_t net_landrivers[] = {
      WINIPv4_GetAddrFromName,
      WINS_AddrCompare,
      WINS_GetSocketPort,
-     WINS_SetSocketPort},
+     WINS_SetSocketPort,
+     NULL,
+     NULL},
 #ifdef IPPROTO_IPV6
 	{"Winsock IPv6",
      false,
@@ -86,7 +93,9 @@ net_landriver_t net_landrivers[] = {
      WINIPv6_GetAddrFromName,
      WINS_AddrCompare,
      WINS_GetSocketPort,
-     WINS_SetSocketPort},
+     WINS_SetSocketPort,
+     NULL,
+     NULL},
 #endif
 	{"Winsock IPX",
      false,
@@ -109,6 +118,8 @@ net_landriver_t net_landrivers[] = {
      WIPX_GetAddrFromName,
      WIPX_AddrCompare,
      WIPX_GetSocketPort,
-     WIPX_SetSocketPort}};
+     WIPX_SetSocketPort,
+     NULL,
+     NULL}};
 
 const int net_numlandrivers = (sizeof (net_landrivers) / sizeof (net_landrivers[0]));
@@ -903,7 +903,7 @@ static void PF_localcmd (void)
 		svs.changelevel_issued = true;
 	}
 
-	Cbuf_AddText (str);
+	SV_InstanceCommand (str);
 }
 
 /*
@@ -1147,7 +1147,7 @@ int SV_Precache_Model (const char *s)
 			}
 
 			sv.model_precache[i] = s;
-			sv.models[i] = Mod_ForName (s, i == 1);
+			sv.models[i] = SV_ModelForName (s, i == 1);
 			return i;
 		}
 		if (!strcmp (sv.model_precache[i], s))
@@ -1179,7 +1179,7 @@ static void PF_sv_precache_model (void)
 			}
 
 			sv.model_precache[i] = s;
-			sv.models[i] = Mod_ForName (s, i == 1);
+			sv.models[i] = SV_ModelForName (s, i == 1);
 			return;
 		}
 		if (!strcmp (sv.model_precache[i], s))
@@ -1690,7 +1690,7 @@ static void PF_sv_changelevel (void)
 	svs.changelevel_issued = true;
 
 	s = G_STRING (OFS_PARM0);
-	Cbuf_AddText (va ("changelevel %s\n", s));
+	SV_InstanceCommand (va ("changelevel %s\n", s));
 }
 
 /*
@@ -1895,4 +1895,28 @@ builtin_t pr_csqcbuiltins[] = {
 	PF_NoCSQC, // PF_setspawnparms
 };
 // clang-format on
-int pr_csqcnumbuiltins = sizeof (pr_csqcbuiltins) / sizeof (pr_csqcbuiltins[0]);
\ No newline at end of file
+int pr_csqcnumbuiltins = sizeof (pr_csqcbuiltins) / sizeof (pr_csqcbuiltins[0]);
+
+// only touch the calling vm, its world and the trace globals, see PR_CallTaskBuiltin
+static const builtin_t pr_tasksafebuiltins[] = {
+	PF_makevectors, PF_setorigin, PF_setsize,   PF_random, PF_normalize,  PF_vlen,          PF_vectoyaw,  PF_vectoangles,
+	PF_Spawn,       PF_Remove,    PF_traceline, PF_Find,   PF_findradius, PF_nextent,       PF_walkmove,  PF_droptofloor,
+	PF_checkbottom, PF_rint,      PF_floor,     PF_ceil,   PF_fabs,       PF_pointcontents, PF_changeyaw, SV_MoveToGoal,
+};
+
+/*
+==============
+PR_IsTaskSafeBuiltin
+==============
+*/
+qboolean PR_IsTaskSafeBuiltin (builtin_t builtin)
+{
+	size_t i;
+
+	for (i = 0; i < countof (pr_tasksafebuiltins); i++)
+	{
+		if (pr_tasksafebuiltins[i] == builtin)
+			return true;
+	}
+	return false;
+}
\ No newline at end of file
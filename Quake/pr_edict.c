@@ -36,6 +36,8 @@ int type_size[8] = {
 
 static ddef_t *ED_FieldAtOfs (int ofs);
 
+extern SDL_mutex *pr_builtinmutex;
+
 cvar_t nomonsters = {"nomonsters", "0", CVAR_NONE};
 cvar_t gamecfg = {"gamecfg", "0", CVAR_NONE};
 cvar_t scratch1 = {"scratch1", "0", CVAR_NONE};
@@ -755,7 +757,7 @@ static void ED_RezoneString (string_t *ref, const char *str)
 		// initialised with
 	}
 
-	buf = Mem_Alloc (len);
+	buf = Mem_AllocTagged (len, MEMTAG_QCSTRING);
 	memcpy (buf, str, len);
 	id = -1 - (*ref = PR_SetEngineString (buf));
 	// make sure its flagged as zoned so we can clean up properly after.
@@ -764,7 +766,7 @@ static void ED_RezoneString (string_t *ref, const char *str)
 		int old_size = (qcvm->knownzonesize + 7) >> 3;
 		qcvm->knownzonesize = (id + 32) & ~7;
 		int new_size = (qcvm->knownzonesize + 7) >> 3;
-		qcvm->knownzone = Mem_Realloc (qcvm->knownzone, new_size);
+		qcvm->knownzone = Mem_ReallocTagged (qcvm->knownzone, new_size, MEMTAG_QCSTRING);
 		memset (qcvm->knownzone + old_size, 0, new_size - old_size);
 	}
 	qcvm->knownzone[id >> 3] |= 1u << (id & 7);
@@ -1079,8 +1081,9 @@ void ED_LoadFromFile (const char *data)
 }
 
 #ifndef PR_SwitchQCVM
-qcvm_t	   *qcvm;
-globalvars_t *pr_global_struct;
+// per thread, so that a task can run one vm while the main thread runs another
+THREAD_LOCAL qcvm_t       *qcvm;
+THREAD_LOCAL globalvars_t *pr_global_struct;
 void          PR_SwitchQCVM (qcvm_t *nvm)
 {
 	if (qcvm && nvm)
@@ -1429,6 +1432,7 @@ PR_Init
 */
 void PR_Init (void)
 {
+	pr_builtinmutex = SDL_CreateMutex ();
 	Cmd_AddCommand ("edict", ED_PrintEdict_f);
 	Cmd_AddCommand ("edicts", ED_PrintEdicts);
 	Cmd_AddCommand ("edictcount", ED_Count);
@@ -1476,8 +1480,8 @@ static void PR_AllocStringSlots (void)
 {
 	qcvm->maxknownstrings += PR_STRING_ALLOCSLOTS;
 	Con_DPrintf2 ("PR_AllocStringSlots: realloc'ing for %d slots\n", qcvm->maxknownstrings);
-	qcvm->knownstrings = (const char **)Mem_Realloc ((void *)qcvm->knownstrings, qcvm->maxknownstrings * sizeof (char *));
-	qcvm->knownstringsowned = (qboolean *)Mem_Realloc ((void *)qcvm->knownstringsowned, qcvm->maxknownstrings * sizeof (qboolean));
+	qcvm->knownstrings = (const char **)Mem_ReallocTagged ((void *)qcvm->knownstrings, qcvm->maxknownstrings * sizeof (char *), MEMTAG_QCSTRING);
+	qcvm->knownstringsowned = (qboolean *)Mem_ReallocTagged ((void *)qcvm->knownstringsowned, qcvm->maxknownstrings * sizeof (qboolean), MEMTAG_QCSTRING);
 }
 
 const char *PR_GetString (int num)
@@ -1576,7 +1580,7 @@ int PR_AllocString (int size, char **ptr)
 		PR_AllocStringSlots ();
 	qcvm->numknownstrings++;
 	//	}
-	qcvm->knownstrings[i] = (char *)Mem_Alloc (size);
+	qcvm->knownstrings[i] = (char *)Mem_AllocTagged (size, MEMTAG_QCSTRING);
 	qcvm->knownstringsowned[i] = true;
 	if (ptr)
 		*ptr = (char *)qcvm->knownstrings[i];
@@ -221,6 +221,86 @@ void PR_RunWarning (const char *error, ...)
 	Con_Warning ("%s\n", string);
 }
 
+/*
+============================================================================
+
+A qcvm that runs on a task calls the builtins that touch more than the vm and its
+world (see PR_IsTaskSafeBuiltin) with the builtin lock held. Whatever the thread
+that submitted the task does meanwhile that could race with them is done with the
+lock held as well.
+
+============================================================================
+*/
+
+SDL_mutex             *pr_builtinmutex; // recursive, created by PR_Init
+static THREAD_LOCAL int pr_builtinlockdepth;
+
+/*
+====================
+PR_LockBuiltins
+====================
+*/
+void PR_LockBuiltins (void)
+{
+	SDL_LockMutex (pr_builtinmutex);
+	pr_builtinlockdepth++;
+}
+
+/*
+====================
+PR_UnlockBuiltins
+====================
+*/
+void PR_UnlockBuiltins (void)
+{
+	if (pr_builtinlockdepth == 0)
+		return; // already released by PR_ReleaseBuiltins
+	pr_builtinlockdepth--;
+	SDL_UnlockMutex (pr_builtinmutex);
+}
+
+/*
+====================
+PR_BuiltinLockDepth
+====================
+*/
+int PR_BuiltinLockDepth (void)
+{
+	return pr_builtinlockdepth;
+}
+
+/*
+====================
+PR_ReleaseBuiltins
+
+Unlocks until this thread holds the lock depth times
+====================
+*/
+void PR_ReleaseBuiltins (int depth)
+{
+	while (pr_builtinlockdepth > depth)
+		PR_UnlockBuiltins ();
+}
+
+/*
+====================
+PR_CallTaskBuiltin
+====================
+*/
+static void PR_CallTaskBuiltin (builtin_t builtin)
+{
+	if (PR_IsTaskSafeBuiltin (builtin))
+	{
+		builtin ();
+		return;
+	}
+	PR_LockBuiltins ();
+	if (qcvm->tasklocked)
+		qcvm->tasklocked ();
+	builtin ();
+	PR_UnlockBuiltins ();
+}
+
 /*
 ====================
 PR_EnterFunction
@@ -556,7 +636,10 @@ void PR_ExecuteProgram (func_t fnum)
 				int i = -newf->first_statement;
 				if (i >= qcvm->numbuiltins)
 					i = 0; // just invoke the fixme builtin.
-				qcvm->builtins[i]();
+				if (qcvm->ontask)
+					PR_CallTaskBuiltin (qcvm->builtins[i]);
+				else
+					qcvm->builtins[i]();
 				break;
 			}
 			// Normal function
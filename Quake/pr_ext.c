@@ -489,7 +489,7 @@ static void PF_strzone (void)
 	}
 	len++; /*for the null*/
 
-	buf = Mem_Alloc (len);
+	buf = Mem_AllocTagged (len, MEMTAG_QCSTRING);
 	G_INT (OFS_RETURN) = PR_SetEngineString (buf);
 	id = -1 - G_INT (OFS_RETURN);
 	if (id >= qcvm->knownzonesize)
@@ -497,7 +497,7 @@ static void PF_strzone (void)
 		int old_size = (qcvm->knownzonesize + 7) >> 3;
 		qcvm->knownzonesize = (id + 32) & ~7;
 		int new_size = (qcvm->knownzonesize + 7) >> 3;
-		qcvm->knownzone = Mem_Realloc (qcvm->knownzone, new_size);
+		qcvm->knownzone = Mem_ReallocTagged (qcvm->knownzone, new_size, MEMTAG_QCSTRING);
 		memset (qcvm->knownzone + old_size, 0, new_size - old_size);
 	}
 	qcvm->knownzone[id >> 3] |= 1u << (id & 7);
@@ -3096,12 +3096,12 @@ static void PF_bufstr_set (void)
 	{
 		oldcount = strbuflist[bufno].allocated;
 		strbuflist[bufno].allocated = (index + 256);
-		strbuflist[bufno].strings = Mem_Realloc (strbuflist[bufno].strings, strbuflist[bufno].allocated * sizeof (char *));
+		strbuflist[bufno].strings = Mem_ReallocTagged (strbuflist[bufno].strings, strbuflist[bufno].allocated * sizeof (char *), MEMTAG_QCSTRING);
 		memset (strbuflist[bufno].strings + oldcount, 0, (strbuflist[bufno].allocated - oldcount) * sizeof (char *));
 	}
 	if (strbuflist[bufno].strings[index])
 		Mem_Free (strbuflist[bufno].strings[index]);
-	strbuflist[bufno].strings[index] = Mem_Alloc (strlen (string) + 1);
+	strbuflist[bufno].strings[index] = Mem_AllocTagged (strlen (string) + 1, MEMTAG_QCSTRING);
 	strcpy (strbuflist[bufno].strings[index], string);
 
 	if (index >= strbuflist[bufno].used)
@@ -3130,14 +3130,14 @@ static int PF_bufstr_add_internal (unsigned int bufno, const char *string, int a
 		unsigned int oldcount;
 		oldcount = strbuflist[bufno].allocated;
 		strbuflist[bufno].allocated = (index + 256);
-		strbuflist[bufno].strings = Mem_Realloc (strbuflist[bufno].strings, strbuflist[bufno].allocated * sizeof (char *));
+		strbuflist[bufno].strings = Mem_ReallocTagged (strbuflist[bufno].strings, strbuflist[bufno].allocated * sizeof (char *), MEMTAG_QCSTRING);
 		memset (strbuflist[bufno].strings + oldcount, 0, (strbuflist[bufno].allocated - oldcount) * sizeof (char *));
 	}
 
 	// add in the new string.
 	if (strbuflist[bufno].strings[index])
 		Mem_Free (strbuflist[bufno].strings[index]);
-	strbuflist[bufno].strings[index] = Mem_Alloc (strlen (string) + 1);
+	strbuflist[bufno].strings[index] = Mem_AllocTagged (strlen (string) + 1, MEMTAG_QCSTRING);
 	strcpy (strbuflist[bufno].strings[index], string);
 
 	if (index >= strbuflist[bufno].used)
@@ -65,6 +65,11 @@ typedef struct qcvm_s qcvm_t;
 void PR_Init (void);
 
 void     PR_ExecuteProgram (func_t fnum);
+void     PR_LockBuiltins (void);
+void     PR_UnlockBuiltins (void);
+int      PR_BuiltinLockDepth (void);
+void     PR_ReleaseBuiltins (int depth); // back to depth, after a Host_Error unwound the locks taken since
+qboolean PR_IsTaskSafeBuiltin (builtin_t builtin);
 void     PR_ClearProgs (qcvm_t *vm);
 qboolean PR_LoadProgs (const char *filename, qboolean fatal, unsigned int needcrc, builtin_t *builtins, size_t numbuiltins);
 
@@ -311,6 +316,11 @@ struct qcvm_s
 	builtin_t builtins[1024];
 	int       numbuiltins;
 
+	// set while a task runs the vm, the builtins that aren't task safe are then called with
+	// the builtin lock held, right after tasklocked (if any) has been called with it held
+	qboolean ontask;
+	void (*tasklocked) (void);
+
 	int argc;
 
 	qboolean     trace;
@@ -361,10 +371,10 @@ struct qcvm_s
 	areanode_t areanodes[AREA_NODES];
 	int        numareanodes;
 };
-extern globalvars_t *pr_global_struct;
+extern THREAD_LOCAL globalvars_t *pr_global_struct;
 
-extern qcvm_t *qcvm;
-void           PR_SwitchQCVM (qcvm_t *nvm);
+extern THREAD_LOCAL qcvm_t *qcvm;
+void                        PR_SwitchQCVM (qcvm_t *nvm);
 
 extern builtin_t pr_ssqcbuiltins[];
 extern int       pr_ssqcnumbuiltins;
@@ -25,6 +25,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #ifndef __QUAKE_SOUND__
 #define __QUAKE_SOUND__
 
+#include "atomics.h"
+#include "tasks.h"
+
 /* !!! if this is changed, it must be changed in asm_i386.h too !!! */
 typedef struct
 {
@@ -43,10 +46,23 @@ typedef struct
 	byte data[1]; /* variable sized	*/
 } sfxcache_t;
 
+typedef enum
+{
+	SFX_UNLOADED,
+	SFX_LOADING,
+	SFX_LOADED,
+	SFX_FAILED
+} sfxstate_t;
+
 typedef struct sfx_s
 {
-	char        name[MAX_QPATH];
-	sfxcache_t *cache;
+	char            name[MAX_QPATH];
+	sfxcache_t     *cache;
+	atomic_uint32_t state;       /* sfxstate_t, cache is only valid once SFX_LOADED	*/
+	task_handle_t   decode_task; /* set while SFX_LOADING				*/
+	filestamp_t     filestamp;   /* file the cache was decoded from		*/
+	int             cachebytes;
+	int             cacheseq; /* map sequence the sound was last precached on	*/
 } sfx_t;
 
 typedef struct
@@ -75,6 +91,7 @@ typedef struct
 	vec3_t origin;     /* origin of sound effect			*/
 	vec_t  dist_mult;  /* distance multiplier (attenuation/clipK)	*/
 	int    master_vol; /* 0-255 master volume				*/
+	int    pending;    /* sfx still decoding, end holds the start time	*/
 } channel_t;
 
 #define WAV_FORMAT_PCM 1
@@ -109,6 +126,7 @@ void   S_TouchSound (const char *sample);
 void   S_ClearPrecache (void);
 void   S_BeginPrecaching (void);
 void   S_EndPrecaching (void);
+void   S_PrintCacheStats (void);
 void   S_PaintChannels (int endtime);
 void   S_InitPaintChannels (void);
 
@@ -182,6 +200,17 @@ extern cvar_t bgmvolume;
 
 void        S_LocalSound (const char *name);
 sfxcache_t *S_LoadSound (sfx_t *s);
+sfxcache_t *S_WaitSound (sfx_t *s);
+void        S_QueueLoadSound (sfx_t *s);
+
+/* a pending channel whose sfx finishes decoding later than this is dropped */
+#define SND_MAX_LATE_MSEC 100
+
+/* asynchronous decoding statistics, see S_SoundInfo_f */
+extern atomic_uint32_t snd_decoded;
+extern atomic_uint32_t snd_late;
+extern atomic_uint32_t snd_missed;
+extern atomic_uint32_t snd_unprecached;
 
 wavinfo_t GetWavinfo (const char *name, byte *wav, int wavlength);
 
@@ -384,6 +384,30 @@ void ExtraMaps_NewGame (void);
 void DemoList_Rebuild (void);
 void SaveList_Rebuild (void);
 
+//
+// host_save
+//
+#define SAVEGAME_VERSION_BINARY 105
+
+typedef struct
+{
+	float  spawn_parms[NUM_TOTAL_SPAWN_PARMS];
+	int    skill;
+	char   mapname[MAX_QPATH];
+	double time;
+	int    size;
+} savegame_info_t;
+
+extern cvar_t sv_savebinary;
+
+void     Host_WriteBinarySavegame (FILE *f);
+void     Host_WaitForSavegame (void);
+void     Host_PollSavegame (void);
+void     Host_WaitForCSQCPhysics (void);
+qboolean Host_RunTask (void (*func) (void *), void *arg, char *error, size_t errorsize);
+qboolean Host_ReadBinarySavegame (const char *path, savegame_info_t *save);
+void     Host_RestoreBinarySavegame (savegame_info_t *save);
+
 extern int current_skill; // skill level for currently loaded level (in case
                           //  the user changes the cvar while the level is
                           //  running, this reflects the level actually in use)
@@ -66,11 +66,11 @@ typedef struct
 	unsigned int flags;
 } aliasubo_t;
 
-static const RgVertex *GetModelVerticesForPose (const qmodel_t *m, const aliashdr_t *hdr, int pose)
+static const trivertx_t *GetModelVerticesForPose (const qmodel_t *m, const aliashdr_t *hdr, int pose)
 {
-	assert (m != NULL && m->rtvertices != NULL);
+	assert (m != NULL && m->rtposes != NULL);
 
-	return &m->rtvertices[(size_t)pose * hdr->numverts_vbo];
+	return &m->rtposes[(size_t)pose * hdr->numverts_vbo];
 }
 
 static size_t GetNextAllocStep (size_t x)
@@ -97,57 +97,242 @@ static float Lerp (float a, float b, float t)
 	return a + dt * t;
 }
 
-static void LerpPosition (float *dst, const float *src1, const float *src2, float blend)
+/*
+=================
+DecodePoseVertices
+
+Expands quantized poses to full vertices, lerping the positions. The normal is always the one of the first pose.
+=================
+*/
+static void DecodePoseVertices (RgVertex *dst, const trivertx_t *src1, const trivertx_t *src2, const float *texcoords, int numverts, float blend)
+{
+	int i = 0;
+#if defined(USE_SSE2)
+	// the 4th lane of every position store lands in normal[0], which is written right after
+	COMPILE_TIME_ASSERT (rgvertex_layout, offsetof (RgVertex, normal) == offsetof (RgVertex, position) + 3 * sizeof (float));
+	const __m128  vblend = _mm_set1_ps (blend);
+	const __m128i zero = _mm_setzero_si128 ();
+	for (; i + 4 <= numverts; i += 4)
+	{
+		// 4 trivertx_t per load, widened to 4 x (x, y, z, lightnormalindex) floats
+		const __m128i v1 = _mm_loadu_si128 ((const __m128i *)(src1 + i));
+		const __m128i v2 = _mm_loadu_si128 ((const __m128i *)(src2 + i));
+		const __m128i v1lo = _mm_unpacklo_epi8 (v1, zero);
+		const __m128i v1hi = _mm_unpackhi_epi8 (v1, zero);
+		const __m128i v2lo = _mm_unpacklo_epi8 (v2, zero);
+		const __m128i v2hi = _mm_unpackhi_epi8 (v2, zero);
+		__m128        p1[4], p2[4];
+		p1[0] = _mm_cvtepi32_ps (_mm_unpacklo_epi16 (v1lo, zero));
+		p1[1] = _mm_cvtepi32_ps (_mm_unpackhi_epi16 (v1lo, zero));
+		p1[2] = _mm_cvtepi32_ps (_mm_unpacklo_epi16 (v1hi, zero));
+		p1[3] = _mm_cvtepi32_ps (_mm_unpackhi_epi16 (v1hi, zero));
+		p2[0] = _mm_cvtepi32_ps (_mm_unpacklo_epi16 (v2lo, zero));
+		p2[1] = _mm_cvtepi32_ps (_mm_unpackhi_epi16 (v2lo, zero));
+		p2[2] = _mm_cvtepi32_ps (_mm_unpacklo_epi16 (v2hi, zero));
+		p2[3] = _mm_cvtepi32_ps (_mm_unpackhi_epi16 (v2hi, zero));
+		for (int j = 0; j < 4; j++)
+		{
+			RgVertex    *v = &dst[i + j];
+			const float *normal = r_avertexnormals[src1[i + j].lightnormalindex];
+			_mm_storeu_ps (v->position, _mm_add_ps (p1[j], _mm_mul_ps (_mm_sub_ps (p2[j], p1[j]), vblend)));
+			v->normal[0] = normal[0];
+			v->normal[1] = normal[1];
+			v->normal[2] = normal[2];
+			v->texCoord[0] = texcoords[(i + j) * 2 + 0];
+			v->texCoord[1] = texcoords[(i + j) * 2 + 1];
+			v->packedColor = RT_PACKED_COLOR_WHITE;
+		}
+	}
+#endif
+	for (; i < numverts; i++)
+	{
+		RgVertex    *v = &dst[i];
+		const float *normal = r_avertexnormals[src1[i].lightnormalindex];
+		for (int j = 0; j < 3; j++)
+		{
+			v->position[j] = Lerp (src1[i].v[j], src2[i].v[j], blend);
+			v->normal[j] = normal[j];
+		}
+		v->texCoord[0] = texcoords[i * 2 + 0];
+		v->texCoord[1] = texcoords[i * 2 + 1];
+		v->packedColor = RT_PACKED_COLOR_WHITE;
+	}
+}
+
+/*
+=================
+Alias pose cache
+
+Entities that share a model and animation state (rows of idle monsters, item
+pickups, torches) would all decode the same vertices. Unlit poses are cached
+for the current frame, keyed by model, poses and blend quantized to
+POSE_CACHE_BLEND_STEPS. Entries belong to r_framecount and are reclaimed
+lazily once it moves on: all draw tasks of a frame are joined before the next
+one starts and the uploads copy the vertex data.
+=================
+*/
+#define POSE_CACHE_SIZE        128
+#define POSE_CACHE_PROBES      16
+#define POSE_CACHE_BLEND_STEPS 32
+#define POSE_CACHE_VERTS_ALIGN 256
+
+typedef struct
+{
+	const qmodel_t *model;
+	int             pose1, pose2;
+	int             blend_step;
+	int             framecount;
+	atomic_uint32_t ready;
+	int             numverts;
+	RgVertex       *vertices;
+} pose_cache_entry_t;
+
+cvar_t r_aliasposecache = {"r_aliasposecache", "1", CVAR_NONE};
+
+static pose_cache_entry_t pose_cache[POSE_CACHE_SIZE];
+static SDL_mutex         *pose_cache_mutex;
+
+/*
+=================
+R_InitAliasPoseCache
+=================
+*/
+void R_InitAliasPoseCache (void)
+{
+	pose_cache_mutex = SDL_CreateMutex ();
+	R_ClearAliasPoseCache ();
+}
+
+/*
+=================
+R_ClearAliasPoseCache
+
+r_framecount restarts on a new map and the model slots get reused
+=================
+*/
+void R_ClearAliasPoseCache (void)
 {
-	for (int j = 0; j < 3; j++)
+	for (int i = 0; i < POSE_CACHE_SIZE; ++i)
+	{
+		pose_cache[i].model = NULL;
+		pose_cache[i].framecount = -1;
+		Atomic_StoreUInt32 (&pose_cache[i].ready, false);
+	}
+}
+
+/*
+=================
+GetCachedPoseVertices
+
+Returns NULL if the pose could not be cached, e.g. all probed slots are used this frame
+=================
+*/
+static const RgVertex *GetCachedPoseVertices (const qmodel_t *m, const aliashdr_t *hdr, int pose1, int pose2, float blend)
+{
+	int blend_step = (int)(blend * POSE_CACHE_BLEND_STEPS + 0.5f);
+	blend_step = CLAMP (0, blend_step, POSE_CACHE_BLEND_STEPS);
+	if (blend_step == 0)
+		pose2 = pose1;
+	else if (blend_step == POSE_CACHE_BLEND_STEPS)
+	{
+		pose1 = pose2;
+		blend_step = 0;
+	}
+
+	const int framecount = r_framecount;
+	uint32_t  hash = (uint32_t)((uintptr_t)m >> 4) * 2654435761u;
+	hash ^= (uint32_t)pose1 * 40503u + (uint32_t)pose2 * 9973u + (uint32_t)blend_step;
+
+	Atomic_IncrementUInt32 (&rs_aliasposelookups);
+
+	pose_cache_entry_t *entry = NULL;
+	SDL_LockMutex (pose_cache_mutex);
+	for (int i = 0; i < POSE_CACHE_PROBES; ++i)
 	{
-		dst[j] = Lerp (src1[j], src2[j], blend);
+		pose_cache_entry_t *probe = &pose_cache[(hash + i) % POSE_CACHE_SIZE];
+		if (probe->framecount != framecount)
+		{
+			// claim a slot left over from an earlier frame
+			probe->model = m;
+			probe->pose1 = pose1;
+			probe->pose2 = pose2;
+			probe->blend_step = blend_step;
+			probe->framecount = framecount;
+			Atomic_StoreUInt32 (&probe->ready, false);
+			entry = probe;
+			break;
+		}
+		if (probe->model == m && probe->pose1 == pose1 && probe->pose2 == pose2 && probe->blend_step == blend_step)
+		{
+			const qboolean ready = Atomic_LoadUInt32 (&probe->ready);
+			SDL_UnlockMutex (pose_cache_mutex);
+			if (!ready)
+				return NULL; // another task is still decoding it
+			Atomic_IncrementUInt32 (&rs_aliasposehits);
+			return probe->vertices;
+		}
 	}
+	SDL_UnlockMutex (pose_cache_mutex);
+
+	if (!entry)
+		return NULL;
+
+	// the slot is ours until ready is set, nobody else touches the buffer this frame
+	if (hdr->numverts_vbo > entry->numverts)
+	{
+		entry->numverts = (hdr->numverts_vbo + (POSE_CACHE_VERTS_ALIGN - 1)) & ~(POSE_CACHE_VERTS_ALIGN - 1);
+		Mem_Free (entry->vertices);
+		entry->vertices = Mem_AllocTagged ((size_t)entry->numverts * sizeof (RgVertex), MEMTAG_RT);
+	}
+
+	const trivertx_t *v_pose1 = GetModelVerticesForPose (m, hdr, pose1);
+	const trivertx_t *v_pose2 = (pose1 == pose2) ? v_pose1 : GetModelVerticesForPose (m, hdr, pose2);
+	DecodePoseVertices (entry->vertices, v_pose1, v_pose2, m->rttexcoords, hdr->numverts_vbo, (float)blend_step / POSE_CACHE_BLEND_STEPS);
+
+	Atomic_StoreUInt32 (&entry->ready, true);
+	return entry->vertices;
 }
 
 static const RgVertex *
 GetPoseVertices (const qmodel_t *m, const aliashdr_t *hdr, int pose1, int pose2, float blend, /* const */ vec3_t shadevector, /* const */ vec3_t lightcolor)
 {
-	const RgVertex *v_pose1 = GetModelVerticesForPose (m, hdr, pose1);
-	const RgVertex *v_pose2 = GetModelVerticesForPose (m, hdr, pose2);
-
 	// we don't care about per-vertex colors with RT
 	const qboolean need_vertex_lighting = CVAR_TO_BOOL (rt_classic_render);
 
-	if (blend < FLT_EPSILON && !need_vertex_lighting)
+	// vertex colors depend on the entity's lighting, so only unlit poses can be shared
+	if (!need_vertex_lighting && CVAR_TO_BOOL (r_aliasposecache))
 	{
-		return v_pose1;
+		const RgVertex *cached = GetCachedPoseVertices (m, hdr, pose1, pose2, blend);
+		if (cached)
+			return cached;
 	}
 
-	static RgVertex *tempstorage = NULL;
-	static size_t    tempstorage_numverts = 0;
+	const trivertx_t *v_pose1 = GetModelVerticesForPose (m, hdr, pose1);
+	const trivertx_t *v_pose2 = (blend < FLT_EPSILON) ? v_pose1 : GetModelVerticesForPose (m, hdr, pose2);
+
+	// entities are drawn from several tasks, the data is copied by the upload before the next call on this thread
+	static THREAD_LOCAL RgVertex *tempstorage = NULL;
+	static THREAD_LOCAL size_t    tempstorage_numverts = 0;
 	if ((size_t)hdr->numverts_vbo > tempstorage_numverts)
 	{
 		tempstorage_numverts = GetNextAllocStep (hdr->numverts_vbo);
 		Mem_Free (tempstorage);
-		tempstorage = Mem_Alloc (tempstorage_numverts * sizeof (RgVertex));
+		tempstorage = Mem_AllocTagged (tempstorage_numverts * sizeof (RgVertex), MEMTAG_RT);
 	}
 
-	memcpy (tempstorage, v_pose1, hdr->numverts_vbo * sizeof (RgVertex));
+	DecodePoseVertices (tempstorage, v_pose1, v_pose2, m->rttexcoords, hdr->numverts_vbo, blend);
 
-	for (int i = 0; i < hdr->numverts_vbo; i++)
+	if (need_vertex_lighting)
 	{
-	    RgVertex *dst = &tempstorage[i];
-
-		const RgVertex *src1 = &v_pose1[i];
-		const RgVertex *src2 = &v_pose2[i];
-
-		LerpPosition (dst->position, src1->position, src2->position, blend);
-
-		if (need_vertex_lighting)
+		for (int i = 0; i < hdr->numverts_vbo; i++)
 		{
-			float dot1 = r_avertexnormal_dot (src1->normal, shadevector);
-			float dot2 = r_avertexnormal_dot (src2->normal, shadevector);
+			float dot1 = r_avertexnormal_dot (r_avertexnormals[v_pose1[i].lightnormalindex], shadevector);
+			float dot2 = r_avertexnormal_dot (r_avertexnormals[v_pose2[i].lightnormalindex], shadevector);
 
 			vec3_t vertcolor;
 			VectorScale (lightcolor, Lerp (dot1, dot2, blend), vertcolor);
 
-			dst->packedColor = RT_PackColorToUint32_FromFloat01 (vertcolor[0], vertcolor[1], vertcolor[2], 1.0f);
+			tempstorage[i].packedColor = RT_PackColorToUint32_FromFloat01 (vertcolor[0], vertcolor[1], vertcolor[2], 1.0f);
 		}
 	}
 
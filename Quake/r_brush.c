@@ -54,6 +54,9 @@ extern cvar_t r_simd;
 extern cvar_t rt_classic_render;
 
 RgVertex *rtallbrushvertices;
+int       rt_brushbatchgen = 1; // zeroed models never match
+
+static void *rtbrushbatchdata;
 
 
 /*
@@ -197,6 +200,34 @@ void DrawGLPoly (
 =============================================================
 */
 
+#ifdef USE_SSE2
+/*
+===============
+R_BackFaceCullBlockSIMD
+
+Returns the lanes of a block of 8 SoA planes that face the (splatted) origin
+===============
+*/
+static inline uint32_t R_BackFaceCullBlockSIMD (soa_plane_t *plane, __m128 px, __m128 py, __m128 pz)
+{
+	__m128 v0 = _mm_mul_ps (_mm_loadu_ps ((*plane) + 0), px);
+	__m128 v1 = _mm_mul_ps (_mm_loadu_ps ((*plane) + 4), px);
+
+	v0 = _mm_add_ps (v0, _mm_mul_ps (_mm_loadu_ps ((*plane) + 8), py));
+	v1 = _mm_add_ps (v1, _mm_mul_ps (_mm_loadu_ps ((*plane) + 12), py));
+
+	v0 = _mm_add_ps (v0, _mm_mul_ps (_mm_loadu_ps ((*plane) + 16), pz));
+	v1 = _mm_add_ps (v1, _mm_mul_ps (_mm_loadu_ps ((*plane) + 20), pz));
+
+	// same epsilon as the scalar test, the planes are already flipped for SURF_PLANEBACK
+	const __m128 eps = _mm_set1_ps (BACKFACE_EPSILON);
+	__m128       pd0 = _mm_add_ps (_mm_loadu_ps ((*plane) + 24), eps);
+	__m128       pd1 = _mm_add_ps (_mm_loadu_ps ((*plane) + 28), eps);
+
+	return (uint32_t)(_mm_movemask_ps (_mm_cmplt_ps (pd0, v0)) | (_mm_movemask_ps (_mm_cmplt_ps (pd1, v1)) << 4));
+}
+#endif // def USE_SSE2
+
 /*
 =================
 R_DrawBrushModel
@@ -204,12 +235,17 @@ R_DrawBrushModel
 */
 void R_DrawBrushModel (cb_context_t *cbx, entity_t *e, int chain, int entuniqueid)
 {
-	int         i, k;
-	msurface_t *psurf;
-	float       dot;
-	mplane_t   *pplane;
-	qmodel_t   *clmodel;
-	vec3_t      modelorg;
+	int          i, k;
+	msurface_t  *psurf;
+	float        dot;
+	mplane_t    *pplane;
+	qmodel_t    *clmodel;
+	vec3_t       modelorg;
+	soa_plane_t *soa_planes = NULL;
+#ifdef USE_SSE2
+	__m128   px, py, pz;
+	uint32_t facing = 0;
+#endif
 
 	if (CVAR_TO_BOOL (rt_enable_pvs))
 	{
@@ -233,6 +269,17 @@ void R_DrawBrushModel (cb_context_t *cbx, entity_t *e, int chain, int entuniquei
 			modelorg[1] = -DotProduct (temp, right);
 			modelorg[2] = DotProduct (temp, up);
 		}
+
+#ifdef USE_SSE2
+		if (use_simd)
+		{
+			// inline submodels share the surfaces, and so the SoA planes, of the world
+			soa_planes = (clmodel->surfaces == cl.worldmodel->surfaces) ? cl.worldmodel->soa_surfplanes : clmodel->soa_surfplanes;
+			px = _mm_set1_ps (modelorg[0]);
+			py = _mm_set1_ps (modelorg[1]);
+			pz = _mm_set1_ps (modelorg[2]);
+		}
+#endif
 	}
 
 	psurf = &clmodel->surfaces[clmodel->firstmodelsurface];
@@ -250,10 +297,23 @@ void R_DrawBrushModel (cb_context_t *cbx, entity_t *e, int chain, int entuniquei
 		}
 	}
 
+	// the prebuilt batches hold every opaque surface, so they can't be used when back faces are culled
+	const qboolean use_batches = !CVAR_TO_BOOL (rt_enable_pvs) && R_HasBrushBatches (clmodel);
+
 	R_ClearTextureChains (clmodel, chain);
 	for (i = 0; i < clmodel->nummodelsurfaces; i++, psurf++)
 	{
-		if (CVAR_TO_BOOL (rt_enable_pvs))
+		if (soa_planes)
+		{
+#ifdef USE_SSE2
+			const int surfindex = clmodel->firstmodelsurface + i;
+			if (i == 0 || (surfindex & 7) == 0)
+				facing = R_BackFaceCullBlockSIMD (&soa_planes[surfindex >> 3], px, py, pz);
+			if (!(facing & (1u << (surfindex & 7))))
+				continue;
+#endif
+		}
+		else if (CVAR_TO_BOOL (rt_enable_pvs))
 		{
 			pplane = psurf->plane;
 			dot = DotProduct (modelorg, pplane->normal) - pplane->dist;
@@ -261,7 +321,8 @@ void R_DrawBrushModel (cb_context_t *cbx, entity_t *e, int chain, int entuniquei
 				continue;
 		}
 
-        R_ChainSurface (psurf, chain);
+		if (!use_batches || (psurf->flags & SURF_DRAWTURB))
+			R_ChainSurface (psurf, chain);
         if (!r_gpulightmapupdate.value)
             R_RenderDynamicLightmaps (psurf);
         else if (psurf->lightmaptexturenum >= 0)
@@ -269,7 +330,14 @@ void R_DrawBrushModel (cb_context_t *cbx, entity_t *e, int chain, int entuniquei
         Atomic_IncrementUInt32 (&rs_brushpolys);
     }
 
-	R_DrawTextureChains (cbx, clmodel, e, chain, entuniqueid);
+	if (use_batches)
+	{
+		if (!r_gpulightmapupdate.value)
+			R_UploadLightmaps ();
+		R_DrawBrushBatches (cbx, e, ENTALPHA_DECODE (e->alpha), entuniqueid);
+	}
+	else
+		R_DrawTextureChains (cbx, clmodel, e, chain, entuniqueid);
 	R_DrawTextureChains_Water (cbx, clmodel, e, chain, entuniqueid);
 }
 
@@ -719,6 +787,73 @@ void GL_DeleteBModelVertexBuffer (void)
 	GL_WaitForDeviceIdle ();
 
 	Mem_Free (rtallbrushvertices);
+	rtallbrushvertices = NULL;
+
+	// models that are not precached again keep their batch pointers, the generation invalidates them
+	Mem_Free (rtbrushbatchdata);
+	rtbrushbatchdata = NULL;
+	++rt_brushbatchgen;
+}
+
+/*
+==================
+GL_BuildBrushBatches
+
+Groups the opaque surfaces of a brush model by texture and lightmap, which is
+where R_DrawTextureChains_Multitexture splits its batches too. With batches ==
+NULL it only counts, so that all models fit into a single allocation.
+==================
+*/
+static int GL_BuildBrushBatches (qmodel_t *m, brushbatch_t *batches, RgVertex *verts, uint32_t *indices, int *numverts, int *numindices)
+{
+	int           numbatches = 0;
+	brushbatch_t  counting;
+	brushbatch_t *b;
+
+	for (int t = 0; t < m->numtextures; t++)
+	{
+		if (!m->textures[t])
+			continue;
+
+		b = NULL;
+
+		for (int i = 0; i < m->nummodelsurfaces; i++)
+		{
+			msurface_t *s = &m->surfaces[m->firstmodelsurface + i];
+
+			if (s->texinfo->texture != m->textures[t] || (s->flags & (SURF_DRAWTURB | SURF_DRAWTILED | SURF_NOTEXTURE | SURF_DRAWSKY)))
+				continue;
+
+			const int num_surf_indices = R_NumTriangleIndicesForSurf (s->numedges);
+
+			if (!b || s->lightmaptexturenum != b->lightmaptexturenum || b->numverts + s->numedges > MAX_BATCH_VERTS ||
+				b->numindices + num_surf_indices > MAX_BATCH_INDICES)
+			{
+				b = batches ? &batches[numbatches] : &counting;
+				b->texnum = t;
+				b->lightmaptexturenum = s->lightmaptexturenum;
+				b->firstsurf = s;
+				b->numverts = 0;
+				b->numindices = 0;
+				b->verts = batches ? &verts[*numverts] : NULL;
+				b->indices = batches ? &indices[*numindices] : NULL;
+				numbatches++;
+			}
+
+			if (batches)
+			{
+				R_TriangleIndicesForSurf (b->numverts, s->numedges, &b->indices[b->numindices]);
+				memcpy (&b->verts[b->numverts], rtallbrushvertices + s->vbo_firstvert, sizeof (RgVertex) * s->numedges);
+			}
+
+			b->numverts += s->numedges;
+			b->numindices += num_surf_indices;
+			*numverts += s->numedges;
+			*numindices += num_surf_indices;
+		}
+	}
+
+	return numbatches;
 }
 
 /*
@@ -746,7 +881,7 @@ void GL_BuildBModelVertexBuffer (void)
 		}
 	}
 
-	rtallbrushvertices = Mem_Alloc (sizeof (RgVertex) * numverts);
+	rtallbrushvertices = Mem_AllocTagged (sizeof (RgVertex) * numverts, MEMTAG_RT);
 	memset (rtallbrushvertices, 0, sizeof (RgVertex) * numverts);
 
     int varray_index = 0;
@@ -788,6 +923,43 @@ void GL_BuildBModelVertexBuffer (void)
 			varray_index += s->numedges;
 		}
 	}
+
+	//
+	// prebuild the opaque batches of every brush entity model, so that doors, lifts
+	// and platforms reuse them instead of chaining and copying their surfaces each frame
+	//
+	int numbatches = 0, numbatchverts = 0, numbatchindices = 0;
+	for (int j = 1; j < MAX_MODELS; j++)
+	{
+		qmodel_t *m = cl.model_precache[j];
+
+		if (!m || m == cl.worldmodel || m->type != mod_brush)
+			continue;
+
+		numbatches += GL_BuildBrushBatches (m, NULL, NULL, NULL, &numbatchverts, &numbatchindices);
+	}
+
+	rtbrushbatchdata = Mem_AllocTagged (
+		sizeof (brushbatch_t) * numbatches + sizeof (RgVertex) * numbatchverts + sizeof (uint32_t) * numbatchindices, MEMTAG_RT);
+
+	brushbatch_t *batches = (brushbatch_t *)rtbrushbatchdata;
+	RgVertex     *batchverts = (RgVertex *)(batches + numbatches);
+	uint32_t     *batchindices = (uint32_t *)(batchverts + numbatchverts);
+
+	numbatchverts = 0;
+	numbatchindices = 0;
+	for (int j = 1; j < MAX_MODELS; j++)
+	{
+		qmodel_t *m = cl.model_precache[j];
+
+		if (!m || m == cl.worldmodel || m->type != mod_brush)
+			continue;
+
+		m->brushbatches = batches;
+		m->numbrushbatches = GL_BuildBrushBatches (m, batches, batchverts, batchindices, &numbatchverts, &numbatchindices);
+		m->brushbatchgen = rt_brushbatchgen;
+		batches += m->numbrushbatches;
+	}
 }
 
 /*
@@ -848,6 +1020,23 @@ void GL_PrepareSIMDData (void)
 		msurface_t *surf = &cl.worldmodel->surfaces[i];
 		SoA_FillPlaneLane (cl.worldmodel->soa_surfplanes, i, surf->plane, surf->flags & SURF_PLANEBACK);
 	}
+
+	// instanced brush models (health and ammo boxes) have their own surfaces, inline submodels use the world's
+	for (int j = 1; j < MAX_MODELS; j++)
+	{
+		qmodel_t *m = cl.model_precache[j];
+
+		if (!m || m == cl.worldmodel || m->type != mod_brush || m->name[0] == '*')
+			continue;
+
+		SAFE_FREE (m->soa_surfplanes);
+		m->soa_surfplanes = Mem_Alloc (4 * sizeof (float) * ((m->numsurfaces + 31) & ~7));
+		for (i = 0; i < m->numsurfaces; ++i)
+		{
+			msurface_t *surf = &m->surfaces[i];
+			SoA_FillPlaneLane (m->soa_surfplanes, i, surf->plane, surf->flags & SURF_PLANEBACK);
+		}
+	}
 #endif // def USE_SIMD
 }
 
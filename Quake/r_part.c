@@ -159,7 +159,7 @@ R_InitParticleIndexBuffer
 void R_InitParticleIndexBuffer (void)
 {
 #if QUAD_PARTICLES
-	quadindices = Mem_Alloc (r_numparticles * sizeof (uint32_t) * 6); // 6 indices per particle quad
+	quadindices = Mem_AllocTagged (r_numparticles * sizeof (uint32_t) * 6, MEMTAG_PARTICLE); // 6 indices per particle quad
 
 	for (int i = 0; i < r_numparticles; ++i)
 	{
@@ -195,7 +195,7 @@ void R_InitParticles (void)
 		r_numparticles = MAX_PARTICLES;
 	}
 
-	particles = (particle_t *)Mem_Alloc (r_numparticles * sizeof (particle_t));
+	particles = (particle_t *)Mem_AllocTagged (r_numparticles * sizeof (particle_t), MEMTAG_PARTICLE);
 
 	Cvar_RegisterVariable (&r_particles); // johnfitz
 	// Cvar_RegisterVariable (&r_quadparticles); // johnfitz
@@ -3396,13 +3396,13 @@ qboolean PScript_Startup (void)
 		r_numbeams = MAX_BEAMSEGS;
 		r_numtrailstates = MAX_TRAILSTATES;
 
-		particles = (particle_t *)Mem_Alloc (r_numparticles * sizeof (particle_t));
+		particles = (particle_t *)Mem_AllocTagged (r_numparticles * sizeof (particle_t), MEMTAG_PARTICLE);
 
-		beams = (beamseg_t *)Mem_Alloc (r_numbeams * sizeof (beamseg_t));
+		beams = (beamseg_t *)Mem_AllocTagged (r_numbeams * sizeof (beamseg_t), MEMTAG_PARTICLE);
 
-		decals = (clippeddecal_t *)Mem_Alloc (r_numdecals * sizeof (clippeddecal_t));
+		decals = (clippeddecal_t *)Mem_AllocTagged (r_numdecals * sizeof (clippeddecal_t), MEMTAG_PARTICLE);
 
-		trailstates = (trailstate_t *)Mem_Alloc (r_numtrailstates * sizeof (trailstate_t));
+		trailstates = (trailstate_t *)Mem_AllocTagged (r_numtrailstates * sizeof (trailstate_t), MEMTAG_PARTICLE);
 		memset (trailstates, 0, r_numtrailstates * sizeof (trailstate_t));
 		ts_cycle = 0;
 
@@ -5587,7 +5587,7 @@ static void ReallocateVertexBuffer ()
     const size_t new_size = new_count * sizeof (basicvertex_t);
 	Sys_Printf ("Reallocating FTE particle vertex buffer (%u KB)\n", (int)(new_size / 1024));
 
-	cl_curstrisvert = Mem_Realloc (cl_curstrisvert, new_size);
+	cl_curstrisvert = Mem_ReallocTagged (cl_curstrisvert, new_size, MEMTAG_PARTICLE);
 
 	cl_strisvert[current_buffer_index] = cl_curstrisvert;
 	cl_maxstrisvert[current_buffer_index] = new_count;
@@ -5599,7 +5599,7 @@ static void ReallocateIndexBuffer ()
 	const size_t new_size = new_count * sizeof (unsigned short);
 	Sys_Printf ("Reallocating FTE particle index buffer (%u KB)\n", (int)(new_size / 1024));
 
-	cl_curstrisidx = Mem_Realloc (cl_curstrisidx, new_size);
+	cl_curstrisidx = Mem_ReallocTagged (cl_curstrisidx, new_size, MEMTAG_PARTICLE);
 
 	cl_strisidx[current_buffer_index] = cl_curstrisidx;
 	cl_maxstrisidx[current_buffer_index] = new_count;
@@ -6198,7 +6198,7 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 				if (cl_numstris == cl_maxstris)
 				{
 					cl_maxstris += 8;
-					cl_stris = Mem_Realloc (cl_stris, sizeof (*cl_stris) * cl_maxstris);
+					cl_stris = Mem_ReallocTagged (cl_stris, sizeof (*cl_stris) * cl_maxstris, MEMTAG_PARTICLE);
 				}
 				scenetri = &cl_stris[cl_numstris++];
 				scenetri->texture = type->looks.texture;
@@ -6286,7 +6286,7 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 					if (cl_numstris == cl_maxstris)
 					{
 						cl_maxstris += 8;
-						cl_stris = Mem_Realloc (cl_stris, sizeof (*cl_stris) * cl_maxstris);
+						cl_stris = Mem_ReallocTagged (cl_stris, sizeof (*cl_stris) * cl_maxstris, MEMTAG_PARTICLE);
 					}
 					scenetri = &cl_stris[cl_numstris++];
 					scenetri->texture = scenetri[-1].texture;
@@ -6343,7 +6343,7 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 			if (cl_numstris == cl_maxstris)
 			{
 				cl_maxstris += 8;
-				cl_stris = Mem_Realloc (cl_stris, sizeof (*cl_stris) * cl_maxstris);
+				cl_stris = Mem_ReallocTagged (cl_stris, sizeof (*cl_stris) * cl_maxstris, MEMTAG_PARTICLE);
 			}
 			scenetri = &cl_stris[cl_numstris++];
 			scenetri->texture = type->looks.texture;
@@ -6367,7 +6367,7 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 						if (cl_numstris == cl_maxstris)
 						{
 							cl_maxstris += 8;
-							cl_stris = Mem_Realloc (cl_stris, sizeof (*cl_stris) * cl_maxstris);
+							cl_stris = Mem_ReallocTagged (cl_stris, sizeof (*cl_stris) * cl_maxstris, MEMTAG_PARTICLE);
 						}
 						scenetri = &cl_stris[cl_numstris++];
 						scenetri->texture = scenetri[-1].texture;
@@ -6702,7 +6702,7 @@ static void PScript_DrawParticleTypes (cb_context_t *cbx, float pframetime)
 					if (cl_numstris == cl_maxstris)
 					{
 						cl_maxstris += 8;
-						cl_stris = Mem_Realloc (cl_stris, sizeof (*cl_stris) * cl_maxstris);
+						cl_stris = Mem_ReallocTagged (cl_stris, sizeof (*cl_stris) * cl_maxstris, MEMTAG_PARTICLE);
 					}
 					scenetri = &cl_stris[cl_numstris++];
 					scenetri->texture = scenetri[-1].texture;
@@ -38,10 +38,15 @@ extern cvar_t rt_brush_metal;
 extern cvar_t rt_brush_rough;
 extern cvar_t rt_enable_pvs;
 extern cvar_t rt_reflrefr_depth;
-extern cvar_t rt_plight_intensity, rt_plight_radius;
+extern cvar_t rt_plight_intensity, rt_plight_radius, rt_plight_budget;
 extern cvar_t rt_wlight_intensity, rt_wlight_radius;
 
 cvar_t r_parallelmark = {"r_parallelmark", "1", CVAR_NONE};
+cvar_t r_parallelmarkgrain = {"r_parallelmarkgrain", "0", CVAR_NONE}; // in blocks of 32 leafs/surfaces, 0 = automatic
+
+// r_markbenchmark overrides
+static qboolean mark_benchmark_indexed;
+static int      mark_benchmark_grain = -1;
 
 byte *SV_FatPVS (vec3_t org, qmodel_t *worldmodel);
 
@@ -53,13 +58,31 @@ extern RgVertex *rtallbrushvertices;
 #define RT_USE_SPHERE_INSTEAD_OF_POLY 1
 
 #define MAX_WORLDLIGHTS_COUNT 1024
+#if RT_USE_SPHERE_INSTEAD_OF_POLY
+typedef struct rt_worldlight_s
+{
+	uint64_t uniqueid;
+	vec3_t   center; // area weighted
+	vec3_t   normal; // area weighted, normalized once merged
+	vec3_t   color;  // rtlightcolor of each merged area, summed
+	float    area;
+} rt_worldlight_t;
+
+// the world's emissive triangles joined over shared edges, built once per map by RT_BuildWorldLights
+static rt_worldlight_t *rt_wldlights_areas = NULL;
+static int              rt_wldlights_areas_count = 0;
+static int              rt_wldlights_tris_count = 0;
+
+// the areas merged down to rt_plight_budget, uploaded each frame
+static rt_worldlight_t rt_wldlights[MAX_WORLDLIGHTS_COUNT];
+static int             rt_wldlights_count = 0;
+static int             rt_wldlights_budget = -1; // the budget rt_wldlights was merged for, -1 to merge again
+static float           rt_wldlights_cell = 0;    // grid cell size the merge ended with, 0 if none was needed
+
+static RgPolygonalLightUploadInfo rt_tempbuffer[512];
+#else
 static RgPolygonalLightUploadInfo rt_wldlights_tri[MAX_WORLDLIGHTS_COUNT];
 static int                        rt_wldlights_tri_count = 0;
-static RgSphericalLightUploadInfo rt_wldlights_sph[MAX_WORLDLIGHTS_COUNT];
-static int                        rt_wldlights_sph_count = 0;
-
-#if RT_USE_SPHERE_INSTEAD_OF_POLY
-static RgPolygonalLightUploadInfo rt_tempbuffer[512]; 
 #endif
 
 #define RT_CUSTOMLIGHTS_PATH        RT_OVERRIDEN_FOLDER "world_custom_lights.txt"
@@ -372,10 +395,10 @@ void R_MarkVisSurfacesSIMD (qboolean *use_tasks)
 
 /*
 ===============
-R_MarkLeafsSIMD
+R_MarkLeafBlockSIMD
 ===============
 */
-void R_MarkLeafsSIMD (int index, void *unused)
+static inline void R_MarkLeafBlockSIMD (int index)
 {
 	unsigned int     j;
 	unsigned int     first_leaf = index * 32;
@@ -416,10 +439,31 @@ void R_MarkLeafsSIMD (int index, void *unused)
 
 /*
 ===============
-R_BackfaceCullSurfacesSIMD
+R_MarkLeafsSIMD
 ===============
 */
-void R_BackfaceCullSurfacesSIMD (int index, void *unused)
+void R_MarkLeafsSIMD (int begin, int end, void *unused)
+{
+	for (int index = begin; index < end; ++index)
+		R_MarkLeafBlockSIMD (index);
+}
+
+/*
+===============
+R_MarkLeafsIndexedSIMD
+===============
+*/
+static void R_MarkLeafsIndexedSIMD (int index, void *unused)
+{
+	R_MarkLeafBlockSIMD (index);
+}
+
+/*
+===============
+R_BackfaceCullSurfaceBlockSIMD
+===============
+*/
+static inline void R_BackfaceCullSurfaceBlockSIMD (int index)
 {
 	uint32_t   *surfvis = (uint32_t *)cl.worldmodel->surfvis;
 	msurface_t *surf;
@@ -446,6 +490,27 @@ void R_BackfaceCullSurfacesSIMD (int index, void *unused)
 	}
 }
 
+/*
+===============
+R_BackfaceCullSurfacesSIMD
+===============
+*/
+void R_BackfaceCullSurfacesSIMD (int begin, int end, void *unused)
+{
+	for (int index = begin; index < end; ++index)
+		R_BackfaceCullSurfaceBlockSIMD (index);
+}
+
+/*
+===============
+R_BackfaceCullSurfacesIndexedSIMD
+===============
+*/
+static void R_BackfaceCullSurfacesIndexedSIMD (int index, void *unused)
+{
+	R_BackfaceCullSurfaceBlockSIMD (index);
+}
+
 /*
 ===============
 R_StoreLeafEFrags
@@ -635,7 +700,7 @@ void R_MarkSurfaces (qboolean use_tasks, task_handle_t before_mark, task_handle_
 {
 	if (use_tasks)
 	{
-		task_handle_t prepare_mark = Task_AllocateAndAssignFunc (R_MarkSurfacesPrepare, NULL, 0);
+		task_handle_t prepare_mark = Task_AllocateAndAssignFunc ("R_MarkSurfacesPrepare", R_MarkSurfacesPrepare, NULL, 0);
 		Task_AddDependency (before_mark, prepare_mark);
 		Task_Submit (prepare_mark);
 #if defined(USE_SIMD)
@@ -643,24 +708,35 @@ void R_MarkSurfaces (qboolean use_tasks, task_handle_t before_mark, task_handle_
 		{
 			if (r_parallelmark.value)
 			{
-				unsigned int  numleafs = cl.worldmodel->numleafs;
-				task_handle_t mark_surfaces = Task_AllocateAndAssignIndexedFunc (R_MarkLeafsSIMD, (numleafs + 31) / 32, NULL, 0);
+				const uint32_t numleafblocks = (cl.worldmodel->numleafs + 31) / 32;
+				const uint32_t numsurfaceblocks = (cl.worldmodel->numsurfaces + 31) / 32;
+				const uint32_t grain = (mark_benchmark_grain >= 0) ? (uint32_t)mark_benchmark_grain : (uint32_t)q_max (r_parallelmarkgrain.value, 0.0f);
+				task_handle_t  mark_surfaces;
+				if (mark_benchmark_indexed)
+				{
+					mark_surfaces = Task_AllocateAndAssignIndexedFunc ("R_MarkLeafsSIMD", R_MarkLeafsIndexedSIMD, numleafblocks, NULL, 0);
+					*cull_surfaces =
+						Task_AllocateAndAssignIndexedFunc ("R_BackfaceCullSurfacesSIMD", R_BackfaceCullSurfacesIndexedSIMD, numsurfaceblocks, NULL, 0);
+				}
+				else
+				{
+					mark_surfaces = Task_AllocateAndAssignRangedFunc ("R_MarkLeafsSIMD", R_MarkLeafsSIMD, numleafblocks, grain, NULL, 0);
+					*cull_surfaces = Task_AllocateAndAssignRangedFunc ("R_BackfaceCullSurfacesSIMD", R_BackfaceCullSurfacesSIMD, numsurfaceblocks, grain, NULL, 0);
+				}
 				Task_AddDependency (prepare_mark, mark_surfaces);
 				Task_Submit (mark_surfaces);
 
-				*store_efrags = Task_AllocateAndAssignFunc (R_StoreLeafEFrags, NULL, 0);
+				*store_efrags = Task_AllocateAndAssignFunc ("R_StoreLeafEFrags", R_StoreLeafEFrags, NULL, 0);
 				Task_AddDependency (mark_surfaces, *store_efrags);
-
-				unsigned int numsurfaces = cl.worldmodel->numsurfaces;
-				*cull_surfaces = Task_AllocateAndAssignIndexedFunc (R_BackfaceCullSurfacesSIMD, (numsurfaces + 31) / 32, NULL, 0);
 				Task_AddDependency (mark_surfaces, *cull_surfaces);
 
-				*chain_surfaces = Task_AllocateAndAssignFunc ((task_func_t)R_ChainVisSurfaces, &use_tasks, sizeof (qboolean));
+				*chain_surfaces = Task_AllocateAndAssignFunc ("R_ChainVisSurfaces", (task_func_t)R_ChainVisSurfaces, &use_tasks, sizeof (qboolean));
 				Task_AddDependency (*cull_surfaces, *chain_surfaces);
 			}
 			else
 			{
-				task_handle_t mark_surfaces = Task_AllocateAndAssignFunc ((task_func_t)R_MarkVisSurfacesSIMD, &use_tasks, sizeof (qboolean));
+				task_handle_t mark_surfaces =
+					Task_AllocateAndAssignFunc ("R_MarkVisSurfacesSIMD", (task_func_t)R_MarkVisSurfacesSIMD, &use_tasks, sizeof (qboolean));
 				Task_AddDependency (prepare_mark, mark_surfaces);
 				*store_efrags = mark_surfaces;
 				*chain_surfaces = mark_surfaces;
@@ -670,7 +746,7 @@ void R_MarkSurfaces (qboolean use_tasks, task_handle_t before_mark, task_handle_
 		else
 #endif
 		{
-			task_handle_t mark_surfaces = Task_AllocateAndAssignFunc ((task_func_t)R_MarkVisSurfaces, &use_tasks, sizeof (qboolean));
+			task_handle_t mark_surfaces = Task_AllocateAndAssignFunc ("R_MarkVisSurfaces", (task_func_t)R_MarkVisSurfaces, &use_tasks, sizeof (qboolean));
 			Task_AddDependency (prepare_mark, mark_surfaces);
 			*store_efrags = mark_surfaces;
 			*chain_surfaces = mark_surfaces;
@@ -692,13 +768,93 @@ void R_MarkSurfaces (qboolean use_tasks, task_handle_t before_mark, task_handle_
 	}
 }
 
+/*
+===============
+R_TimeMarkSurfaces
+===============
+*/
+static double R_TimeMarkSurfaces (int iterations)
+{
+	const double start = Sys_DoubleTime ();
+	for (int i = 0; i < iterations; ++i)
+	{
+		task_handle_t before_mark = Task_Allocate ("R_MarkSurfacesBenchmark");
+		task_handle_t store_efrags = INVALID_TASK_HANDLE;
+		task_handle_t cull_surfaces = INVALID_TASK_HANDLE;
+		task_handle_t chain_surfaces = INVALID_TASK_HANDLE;
+		R_MarkSurfaces (true, before_mark, &store_efrags, &cull_surfaces, &chain_surfaces);
+		Task_Submit (before_mark);
+		Task_Submit (store_efrags);
+		if (store_efrags != cull_surfaces)
+		{
+			Task_Submit (cull_surfaces);
+			Task_Submit (chain_surfaces);
+		}
+		Task_Join (store_efrags, SDL_MUTEX_MAXWAIT);
+		Task_Join (chain_surfaces, SDL_MUTEX_MAXWAIT);
+	}
+	return Sys_DoubleTime () - start;
+}
+
+/*
+===============
+R_MarkSurfacesBenchmark_f
+
+r_markbenchmark [iterations]: times the parallel R_MarkSurfaces task graph for the current view, claiming
+one block of 32 leafs/surfaces per atomic increment and with ranged tasks of several grain sizes
+===============
+*/
+void R_MarkSurfacesBenchmark_f (void)
+{
+#if defined(USE_SIMD)
+	static const int grains[] = {0, 1, 4, 16, 64};
+	const int        iterations = (Cmd_Argc () > 1) ? q_max (atoi (Cmd_Argv (1)), 1) : 200;
+
+	if (!cl.worldmodel || !r_viewleaf || (cls.signon != SIGNONS))
+	{
+		Con_Printf ("r_markbenchmark: no map loaded\n");
+		return;
+	}
+	if (!use_simd || !r_parallelmark.value)
+	{
+		Con_Printf ("r_markbenchmark: needs r_simd 1 and r_parallelmark 1\n");
+		return;
+	}
+
+	// the marked surfaces and texture chains are rebuilt by the next frame, efrags are only stored once per frame
+	GL_SynchronizeEndRenderingTask ();
+	const int numvisedicts = cl_numvisedicts;
+
+	Con_Printf (
+		"%s: %d leafs, %d surfaces, %d workers, %d iterations\n", cl.worldmodel->name, cl.worldmodel->numleafs, cl.worldmodel->numsurfaces,
+		Tasks_NumWorkers (), iterations);
+	mark_benchmark_indexed = true;
+	Con_Printf ("  indexed            : %7.3f ms\n", R_TimeMarkSurfaces (iterations) * 1000.0 / iterations);
+	mark_benchmark_indexed = false;
+	for (int i = 0; i < (int)countof (grains); ++i)
+	{
+		mark_benchmark_grain = grains[i];
+		const double time = R_TimeMarkSurfaces (iterations) * 1000.0 / iterations;
+		if (grains[i] == 0)
+			Con_Printf ("  ranged, auto grain : %7.3f ms\n", time);
+		else
+			Con_Printf ("  ranged, grain %-4d : %7.3f ms\n", grains[i], time);
+	}
+	mark_benchmark_grain = -1;
+
+	cl_numvisedicts = numvisedicts;
+#else
+	Con_Printf ("r_markbenchmark: needs SIMD support\n");
+#endif
+}
+
 //==============================================================================
 //
 // VBO SUPPORT
 //
 //==============================================================================
 
-static int R_NumTriangleIndicesForSurf (int vertcount)
+int R_NumTriangleIndicesForSurf (int vertcount)
 {
 	return q_max (0, 3 * (vertcount - 2));
 }
@@ -711,7 +867,7 @@ Writes out the triangle indices needed to draw s as a triangle list.
 The number of indices it will write is given by R_NumTriangleIndicesForSurf.
 ================
 */
-static void R_TriangleIndicesForSurf (int basevert, int vertcount, uint32_t *dest)
+void R_TriangleIndicesForSurf (int basevert, int vertcount, uint32_t *dest)
 {
 	int i;
 	for (i = 2; i < vertcount; i++)
@@ -722,12 +878,6 @@ static void R_TriangleIndicesForSurf (int basevert, int vertcount, uint32_t *des
 	}
 }
 
-static void RT_ClearBatch (cb_context_t *cbx)
-{
-	cbx->batch_verts_count = 0;
-	cbx->batch_indices_count = 0;
-}
-
 RgTransform RT_GetBrushModelMatrix (entity_t *e)
 {
 	if (e == NULL)
@@ -807,9 +957,9 @@ static qboolean HaveSharedEdge (const RgPolygonalLightUploadInfo *poly_a, const
 	return false;
 }
 
-static qboolean  RT_FindNearestTeleport (const RgGeometryUploadInfo *info, uint8_t *result, qboolean *potentially_mirror);
+static qboolean  RT_FindNearestTeleport (const RgGeometryUploadInfo *info, const msurface_t *surf, uint8_t *result, qboolean *potentially_mirror);
 static RgFloat3D ApplyTransform (const RgTransform *transform, const vec3_t v);
-static void      PolyToSphericalLights (const RgPolygonalLightUploadInfo *polys, int count, qboolean upload);
+static void      PolyToSphericalLights (const RgPolygonalLightUploadInfo *polys, int count);
 
 typedef struct rt_uploadsurf_state_t
 {
@@ -828,18 +978,16 @@ typedef struct rt_uploadsurf_state_t
 	qboolean     is_teleport;
 } rt_uploadsurf_state_t;
 
-static void RT_FlushBatch (cb_context_t *cbx, const rt_uploadsurf_state_t *s, uint32_t *brushpasses)
-{
-	if (cbx->batch_verts_count == 0 || cbx->batch_indices_count == 0)
-	{
-		return;
-	}
-
-    const RgVertex *vertices = cbx->batch_verts;
-	const uint32_t *indices = cbx->batch_indices;
-	const int       num_surf_verts = cbx->batch_verts_count;
-	const int       num_surf_indices = cbx->batch_indices_count;
+/*
+================
+RT_UploadSurfaces
 
+uploads one batch of surfaces that share the state s, s->surf names the upload
+================
+*/
+static void RT_UploadSurfaces (
+	const rt_uploadsurf_state_t *s, const RgVertex *vertices, const uint32_t *indices, const int num_surf_verts, const int num_surf_indices)
+{
 	// i.e. uploaded once at the level load
     const qboolean is_static_geom = (s->model == cl.worldmodel) && !s->is_warp;
 
@@ -864,7 +1012,12 @@ static void RT_FlushBatch (cb_context_t *cbx, const rt_uploadsurf_state_t *s, ui
 	gltexture_t *diffuse_tex = r_lightmap_cheatsafe ? NULL : s->diffuse_tex;
 	gltexture_t *lightmap_tex = r_fullbright_cheatsafe ? NULL : s->lightmap_tex;
 
+#if RT_USE_SPHERE_INSTEAD_OF_POLY
+	// the world's emissive surfaces are clustered once per map, see RT_BuildWorldLights
+	if (diffuse_tex && diffuse_tex->rtcustomtextype == RT_CUSTOMTEXTUREINFO_TYPE_POLY_LIGHT && s->model != cl.worldmodel)
+#else
 	if (diffuse_tex && diffuse_tex->rtcustomtextype == RT_CUSTOMTEXTUREINFO_TYPE_POLY_LIGHT)
+#endif
 	{
 		const RgTransform transf = RT_GetBrushModelMatrix (s->ent);
 
@@ -889,21 +1042,20 @@ static void RT_FlushBatch (cb_context_t *cbx, const rt_uploadsurf_state_t *s, ui
 					},
 			};
 
-			if (!is_static_geom)
-			{
 #if RT_USE_SPHERE_INSTEAD_OF_POLY
-				if (tri < (int) countof (rt_tempbuffer))
-				{
-					rt_tempbuffer[tri] = light_info;
-				}
-				else
-				{
-					assert (false);
-				}
+			if (tri < (int) countof (rt_tempbuffer))
+			{
+				rt_tempbuffer[tri] = light_info;
+			}
+			else
+			{
+				assert (false);
+			}
 #else
+			if (!is_static_geom)
+			{
 				RgResult r = rgUploadPolygonalLight (vulkan_globals.instance, &light_info);
 				RG_CHECK (r);
-#endif
 			}
 			else
 			{
@@ -918,13 +1070,11 @@ static void RT_FlushBatch (cb_context_t *cbx, const rt_uploadsurf_state_t *s, ui
 					assert (false);
 				}
 			}
+#endif
 		}
 
 #if RT_USE_SPHERE_INSTEAD_OF_POLY
-		if (!is_static_geom)
-		{
-			PolyToSphericalLights (rt_tempbuffer, num_surf_indices / 3, true);
-		}
+		PolyToSphericalLights (rt_tempbuffer, q_min (num_surf_indices / 3, (int)countof (rt_tempbuffer)));
 #endif
 	}
 
@@ -1023,7 +1173,7 @@ static void RT_FlushBatch (cb_context_t *cbx, const rt_uploadsurf_state_t *s, ui
 		{
 			qboolean portal_is_mirror = false;
 
-			if (RT_FindNearestTeleport (&info, &portalindex, &portal_is_mirror))
+			if (RT_FindNearestTeleport (&info, s->surf, &portalindex, &portal_is_mirror))
 			{
 				if (portal_is_mirror)
 				{
@@ -1039,27 +1189,126 @@ static void RT_FlushBatch (cb_context_t *cbx, const rt_uploadsurf_state_t *s, ui
 		RgResult r = rgUploadGeometry (vulkan_globals.instance, &info);
 		RG_CHECK (r);
 	}
+}
+
+/*
+================
+RT_HashChainSurface
 
-	RT_ClearBatch (cbx);
-	++(*brushpasses);
+FNV-1a over what decides how a surface is batched
+================
+*/
+static uint64_t RT_HashChainSurface (uint64_t hash, const msurface_t *surf, float alpha)
+{
+	const uintptr_t p = (uintptr_t)surf;
+	uint32_t        a;
+	memcpy (&a, &alpha, sizeof (a));
+
+	const uint64_t words[] = {(uint64_t)p, (uint64_t)(uint32_t)surf->lightmaptexturenum, (uint64_t)a};
+	for (int i = 0; i < (int)countof (words); i++)
+		hash = (hash ^ words[i]) * 1099511628211ull;
+	return hash;
 }
 
-static void RT_BatchSurface (cb_context_t *cbx, const rt_uploadsurf_state_t *s, uint32_t *brushpasses)
+/*
+================
+RT_ChainCacheFor
+
+Each chain of a texture is only walked by one task at a time, so the caches need no locking
+================
+*/
+static chaincache_t *RT_ChainCacheFor (texture_t *t, texchain_t chain)
 {
-	int num_surf_verts = s->surf->numedges;
-	int num_surf_indices = R_NumTriangleIndicesForSurf (num_surf_verts);
+	if (!t->chaincache[chain])
+		t->chaincache[chain] = Mem_AllocTagged (sizeof (chaincache_t), MEMTAG_RT);
+	return t->chaincache[chain];
+}
 
-	if (cbx->batch_indices_count + num_surf_indices > MAX_BATCH_INDICES ||
-		cbx->batch_verts_count + num_surf_verts > MAX_BATCH_VERTS)
+/*
+================
+RT_ReserveChainCache
+================
+*/
+static void RT_ReserveChainCache (chaincache_t *c, int numbatches, int numverts, int numindices)
+{
+	if (numbatches > c->maxbatches)
+	{
+		c->maxbatches = numbatches;
+		c->batches = Mem_ReallocTagged (c->batches, sizeof (chainbatch_t) * numbatches, MEMTAG_RT);
+	}
+	if (numverts > c->maxverts)
 	{
-		RT_FlushBatch (cbx, s, brushpasses);
+		c->maxverts = numverts;
+		c->verts = Mem_ReallocTagged (c->verts, sizeof (RgVertex) * numverts, MEMTAG_RT);
 	}
+	if (numindices > c->maxindices)
+	{
+		c->maxindices = numindices;
+		c->indices = Mem_ReallocTagged (c->indices, sizeof (uint32_t) * numindices, MEMTAG_RT);
+	}
+	c->numbatches = c->numverts = c->numindices = 0;
+}
+
+/*
+================
+RT_CacheSurface
+
+Appends a surface to the cache, starting a new batch if asked to or if the current one is full.
+Indices are relative to the first vertex of their batch.
+================
+*/
+static void RT_CacheSurface (chaincache_t *c, msurface_t *surf, float alpha, qboolean newbatch)
+{
+	const int     num_surf_verts = surf->numedges;
+	const int     num_surf_indices = R_NumTriangleIndicesForSurf (num_surf_verts);
+	chainbatch_t *b = c->numbatches ? &c->batches[c->numbatches - 1] : NULL;
+
+	if (!b || newbatch || b->numindices + num_surf_indices > MAX_BATCH_INDICES || b->numverts + num_surf_verts > MAX_BATCH_VERTS)
+	{
+		b = &c->batches[c->numbatches++];
+		b->lightmaptexturenum = surf->lightmaptexturenum;
+		b->alpha = alpha;
+		b->firstvert = c->numverts;
+		b->numverts = 0;
+		b->firstindex = c->numindices;
+		b->numindices = 0;
+	}
+
+	// the last surface names the upload, like the state a chained batch was flushed with
+	b->surf = surf;
+	R_TriangleIndicesForSurf (b->numverts, num_surf_verts, &c->indices[c->numindices]);
+	memcpy (&c->verts[c->numverts], rtallbrushvertices + surf->vbo_firstvert, sizeof (RgVertex) * num_surf_verts);
+	b->numverts += num_surf_verts;
+	b->numindices += num_surf_indices;
+	c->numverts += num_surf_verts;
+	c->numindices += num_surf_indices;
+}
 
-	R_TriangleIndicesForSurf (cbx->batch_verts_count, num_surf_verts, &cbx->batch_indices[cbx->batch_indices_count]);
-	memcpy (&cbx->batch_verts[cbx->batch_verts_count], rtallbrushvertices + s->surf->vbo_firstvert, sizeof (RgVertex) * num_surf_verts);
+/*
+================
+RT_FreeChainCache
+================
+*/
+static void RT_FreeChainCache (texture_t *t, texchain_t chain)
+{
+	chaincache_t *c = t->chaincache[chain];
+	if (!c)
+		return;
+	Mem_Free (c->batches);
+	Mem_Free (c->verts);
+	Mem_Free (c->indices);
+	SAFE_FREE (t->chaincache[chain]);
+}
 
-	cbx->batch_indices_count += num_surf_indices;
-	cbx->batch_verts_count += num_surf_verts;
+/*
+================
+R_FreeChainCaches
+================
+*/
+void R_FreeChainCaches (texture_t *t)
+{
+	for (int i = 0; i < chain_num; i++)
+		RT_FreeChainCache (t, (texchain_t)i);
 }
 
 /*
@@ -1118,21 +1367,21 @@ R_DrawTextureChains_Water -- johnfitz
 */
 void R_DrawTextureChains_Water (cb_context_t *cbx, qmodel_t *model, entity_t *ent, texchain_t chain, int entuniqueid)
 {
-	int                   i;
-	msurface_t           *s;
-	texture_t            *t;
-	rt_uploadsurf_state_t last_state = {0};
+	int           i, j;
+	msurface_t   *s;
+	texture_t    *t;
+	chaincache_t *cache;
+	uint32_t      brushpasses = 0, reused = 0, rebuilt = 0;
 
-	uint32_t brushpasses = 0;
 	for (i = 0; i < model->numtextures; ++i)
 	{
 		t = model->textures[i];
 
 		if (!t || !t->texturechains[chain] || !(t->texturechains[chain]->flags & SURF_DRAWTURB))
 			continue;
-		
-		RT_ClearBatch (cbx);
 
+		uint64_t key = 14695981039346656037ull ^ (uint64_t)rt_brushbatchgen;
+		int      numverts = 0, numindices = 0, numsurfs = 0;
 		for (s = t->texturechains[chain]; s; s = s->texturechains[chain])
 		{
 			if (model != cl.worldmodel)
@@ -1143,36 +1392,53 @@ void R_DrawTextureChains_Water (cb_context_t *cbx, qmodel_t *model, entity_t *en
 				Atomic_StoreUInt32 (&t->update_warp, true); // FIXME: one frame too late!
 			}
 
-			rt_uploadsurf_state_t cur_state = {
+			key = RT_HashChainSurface (key, s, GL_WaterAlphaForEntitySurface (ent, s));
+			numverts += s->numedges;
+			numindices += R_NumTriangleIndicesForSurf (s->numedges);
+			numsurfs++;
+		}
+
+		// every surface is its own upload, teleports are told apart by their surface
+		cache = RT_ChainCacheFor (t, chain);
+		if (cache->key != key || cache->numbatches != numsurfs)
+		{
+			RT_ReserveChainCache (cache, numsurfs, numverts, numindices);
+			for (s = t->texturechains[chain]; s; s = s->texturechains[chain])
+				RT_CacheSurface (cache, s, GL_WaterAlphaForEntitySurface (ent, s), true);
+			cache->key = key;
+			++rebuilt;
+		}
+		else
+			++reused;
+
+		for (j = 0; j < cache->numbatches; ++j)
+		{
+			const chainbatch_t *b = &cache->batches[j];
+
+			rt_uploadsurf_state_t state = {
 				.entuniqueid = entuniqueid,
 				.ent = ent,
 				.model = model,
-				.surf = s,
+				.surf = b->surf,
 				.diffuse_tex = t->gltexture, // t->warpimage,
-				.lightmap_tex = (s->lightmaptexturenum >= 0) ? lightmaps[s->lightmaptexturenum].texture : greytexture,
+				.lightmap_tex = (b->lightmaptexturenum >= 0) ? lightmaps[b->lightmaptexturenum].texture : greytexture,
 				.alpha_test = false,
-				.alpha = GL_WaterAlphaForEntitySurface (ent, s),
+				.alpha = b->alpha,
 				.use_zbias = false,
 				.is_warp = true,
-				.is_water = s->flags & SURF_DRAWWATER,
-				.is_acid = s->flags & SURF_DRAWSLIME,
-				.is_teleport = (s->flags & SURF_DRAWTELE),
+				.is_water = b->surf->flags & SURF_DRAWWATER,
+				.is_acid = b->surf->flags & SURF_DRAWSLIME,
+				.is_teleport = (b->surf->flags & SURF_DRAWTELE),
 			};
 
-			if (cur_state.lightmap_tex != last_state.lightmap_tex ||
-				fabsf(cur_state.alpha - last_state.alpha) < 0.001f)
-			{
-				RT_FlushBatch (cbx, &last_state, &brushpasses);
-			}
-
-			RT_BatchSurface (cbx, &cur_state, &brushpasses);
-			last_state = cur_state;
+			RT_UploadSurfaces (&state, cache->verts + b->firstvert, cache->indices + b->firstindex, b->numverts, b->numindices);
+			++brushpasses;
 		}
-
-		RT_FlushBatch (cbx, &last_state, &brushpasses);
 	}
 
 	Atomic_AddUInt32 (&rs_brushpasses, brushpasses);
+	Atomic_AddUInt32 (&rs_brushbatchreuses, reused);
+	Atomic_AddUInt32 (&rs_brushbatchrebuilds, rebuilt);
 }
 
 /*
@@ -1183,14 +1449,15 @@ R_DrawTextureChains_Multitexture
 void R_DrawTextureChains_Multitexture (
 	cb_context_t *cbx, qmodel_t *model, entity_t *ent, texchain_t chain, const float alpha, int texstart, int texend, int entuniqueid)
 {
-	int                   i;
-	msurface_t           *s;
-	texture_t            *t;
-	qboolean              use_zbias = (gl_zfix.value && model != cl.worldmodel);
-	int                   ent_frame = ent != NULL ? ent->frame : 0;
-	rt_uploadsurf_state_t last_state = {0};
-	
-	uint32_t brushpasses = 0;
+	int           i, j;
+	msurface_t   *s;
+	texture_t    *t;
+	chaincache_t *cache;
+	qboolean      use_zbias = (gl_zfix.value && model != cl.worldmodel);
+	int           ent_frame = ent != NULL ? ent->frame : 0;
+	qboolean      static_world = (model == cl.worldmodel && chain == chain_world);
+	uint32_t      brushpasses = 0, reused = 0, rebuilt = 0;
+
 	for (i = texstart; i < texend; ++i)
 	{
 		t = model->textures[i];
@@ -1198,20 +1465,47 @@ void R_DrawTextureChains_Multitexture (
 		if (!t || !t->texturechains[chain] || t->texturechains[chain]->flags & (SURF_DRAWTURB | SURF_DRAWTILED | SURF_NOTEXTURE))
 			continue;
 
-		RT_ClearBatch (cbx);
+		uint64_t key = 14695981039346656037ull ^ (uint64_t)rt_brushbatchgen;
+		int      numverts = 0, numindices = 0, numsurfs = 0;
+		for (s = t->texturechains[chain]; s; s = s->texturechains[chain])
+		{
+			key = RT_HashChainSurface (key, s, 1.0f);
+			numverts += s->numedges;
+			numindices += R_NumTriangleIndicesForSurf (s->numedges);
+			numsurfs++;
+		}
+
+		// a new batch starts wherever the lightmap changes, the texture state is applied per upload
+		cache = RT_ChainCacheFor (t, chain);
+		if (cache->key != key || cache->numverts != numverts)
+		{
+			RT_ReserveChainCache (cache, numsurfs, numverts, numindices);
+			int lightmaptexturenum = INT_MIN;
+			for (s = t->texturechains[chain]; s; s = s->texturechains[chain])
+			{
+				RT_CacheSurface (cache, s, 1.0f, s->lightmaptexturenum != lightmaptexturenum);
+				lightmaptexturenum = s->lightmaptexturenum;
+			}
+			cache->key = key;
+			++rebuilt;
+		}
+		else
+			++reused;
 
-		qboolean alpha_test = (t->texturechains[chain]->flags & SURF_DRAWFENCE) != 0;
+		qboolean     alpha_test = (t->texturechains[chain]->flags & SURF_DRAWFENCE) != 0;
 		gltexture_t *diffuse_tex = R_TextureAnimation (t, ent_frame)->gltexture;
 
-		for (s = t->texturechains[chain]; s; s = s->texturechains[chain])
+		for (j = 0; j < cache->numbatches; ++j)
 		{
-			rt_uploadsurf_state_t cur_state = {
+			const chainbatch_t *b = &cache->batches[j];
+
+			rt_uploadsurf_state_t state = {
 				.entuniqueid = entuniqueid,
 				.ent = ent,
 				.model = model,
-				.surf = s,
+				.surf = b->surf,
 				.diffuse_tex = diffuse_tex,
-				.lightmap_tex = (s->lightmaptexturenum >= 0) ? lightmaps[s->lightmaptexturenum].texture : greytexture,
+				.lightmap_tex = (b->lightmaptexturenum >= 0) ? lightmaps[b->lightmaptexturenum].texture : greytexture,
 				.alpha_test = alpha_test,
 				.alpha = alpha,
 				.use_zbias = use_zbias,
@@ -1221,16 +1515,55 @@ void R_DrawTextureChains_Multitexture (
 				.is_teleport = false,
 			};
 
-			if (cur_state.lightmap_tex != last_state.lightmap_tex)
-			{
-				RT_FlushBatch (cbx, &last_state, &brushpasses);
-			}
-
-			RT_BatchSurface (cbx, &cur_state, &brushpasses);
-			last_state = cur_state;
+			RT_UploadSurfaces (&state, cache->verts + b->firstvert, cache->indices + b->firstindex, b->numverts, b->numindices);
+			++brushpasses;
 		}
 
-		RT_FlushBatch (cbx, &last_state, &brushpasses);
+		// the world chains are only drawn when the static geometry is submitted again, keeping them would copy the whole world
+		if (static_world)
+			RT_FreeChainCache (t, chain);
+	}
+
+	Atomic_AddUInt32 (&rs_brushpasses, brushpasses);
+	Atomic_AddUInt32 (&rs_brushbatchreuses, reused);
+	Atomic_AddUInt32 (&rs_brushbatchrebuilds, rebuilt);
+}
+
+/*
+================
+R_DrawBrushBatches
+
+Draws the opaque surfaces of a brush entity from the batches prebuilt by
+GL_BuildBModelVertexBuffer, so only the transform and the animated textures
+are looked at per frame. The caller must have checked R_HasBrushBatches.
+================
+*/
+void R_DrawBrushBatches (cb_context_t *cbx, entity_t *ent, const float alpha, int entuniqueid)
+{
+	int       i;
+	qmodel_t *model = ent->model;
+	qboolean  use_zbias = (gl_zfix.value && model != cl.worldmodel);
+	uint32_t  brushpasses = 0;
+
+	for (i = 0; i < model->numbrushbatches; ++i)
+	{
+		const brushbatch_t *b = &model->brushbatches[i];
+		texture_t          *t = model->textures[b->texnum];
+
+		rt_uploadsurf_state_t state = {
+			.entuniqueid = entuniqueid,
+			.ent = ent,
+			.model = model,
+			.surf = b->firstsurf,
+			.diffuse_tex = R_TextureAnimation (t, ent->frame)->gltexture,
+			.lightmap_tex = (b->lightmaptexturenum >= 0) ? lightmaps[b->lightmaptexturenum].texture : greytexture,
+			.alpha_test = (b->firstsurf->flags & SURF_DRAWFENCE) != 0,
+			.alpha = alpha,
+			.use_zbias = use_zbias,
+		};
+
+		RT_UploadSurfaces (&state, b->verts, b->indices, b->numverts, b->numindices);
+		++brushpasses;
 	}
 
 	Atomic_AddUInt32 (&rs_brushpasses, brushpasses);
@@ -1256,7 +1589,7 @@ void R_DrawTextureChains (cb_context_t *cbx, qmodel_t *model, entity_t *ent, tex
 }
 
 #if RT_USE_SPHERE_INSTEAD_OF_POLY
-static void AddSphericalLight (qboolean upload, const RgPolygonalLightUploadInfo *src, vec3_t accum_center, vec3_t accum_normal, int sharing)
+static void AddSphericalLight (const RgPolygonalLightUploadInfo *src, vec3_t accum_center, vec3_t accum_normal, int sharing)
 {
 	VectorScale (accum_center, 1.0f / (float)sharing, accum_center);
 
@@ -1272,18 +1605,11 @@ static void AddSphericalLight (qboolean upload, const RgPolygonalLightUploadInfo
 		.radius = radius,
 	};
 
-	if (upload)
-	{
-		RgResult r = rgUploadSphericalLight (vulkan_globals.instance, &light_info);
-		RG_CHECK (r);
-	}
-	else
-	{
-	    rt_wldlights_sph[rt_wldlights_sph_count++] = light_info;
-	}
+	RgResult r = rgUploadSphericalLight (vulkan_globals.instance, &light_info);
+	RG_CHECK (r);
 }
 
-static void PolyToSphericalLights (const RgPolygonalLightUploadInfo *polys, int count, qboolean upload)
+static void PolyToSphericalLights (const RgPolygonalLightUploadInfo *polys, int count)
 {
 	vec3_t accum_center = {0, 0, 0};
 	vec3_t accum_normal = {0, 0, 0};
@@ -1309,7 +1635,7 @@ static void PolyToSphericalLights (const RgPolygonalLightUploadInfo *polys, int
 		{
 			if (sharing > 0)
 			{
-				AddSphericalLight (upload, poly_cur, accum_center, accum_normal, sharing);
+				AddSphericalLight (poly_cur, accum_center, accum_normal, sharing);
 
 				RT_VEC3_SET (accum_center, 0, 0, 0);
 				RT_VEC3_SET (accum_normal, 0, 0, 0);
@@ -1321,7 +1647,7 @@ static void PolyToSphericalLights (const RgPolygonalLightUploadInfo *polys, int
 
 	if (sharing > 0)
 	{
-		AddSphericalLight (upload, &polys[count - 1], accum_center, accum_normal, sharing);
+		AddSphericalLight (&polys[count - 1], accum_center, accum_normal, sharing);
 	}
 }
 #endif
@@ -1333,8 +1659,9 @@ R_DrawWorld -- ericw -- moved from R_DrawTextureChains, which is no longer speci
 */
 void R_DrawWorld (cb_context_t *cbx, int index)
 {
-	rt_wldlights_sph_count = 0;
+#if !RT_USE_SPHERE_INSTEAD_OF_POLY
 	rt_wldlights_tri_count = 0;
+#endif
 
 	if (!r_drawworld_cheatsafe)
 		return;
@@ -1344,10 +1671,6 @@ void R_DrawWorld (cb_context_t *cbx, int index)
 		R_UploadLightmaps ();
 	R_DrawTextureChains_Multitexture (cbx, cl.worldmodel, NULL, chain_world, 1, world_texstart[index], world_texend[index], ENT_UNIQUEID_WORLD);
 
-#if RT_USE_SPHERE_INSTEAD_OF_POLY
-	PolyToSphericalLights (rt_wldlights_tri, rt_wldlights_tri_count, false);
-#endif
-
     R_EndDebugUtilsLabel (cbx);
 }
 
@@ -1625,14 +1948,373 @@ void RT_CustomLights_RemoveCmd (void)
 
 
 
+#if RT_USE_SPHERE_INSTEAD_OF_POLY
+typedef struct rt_emissivetri_s
+{
+	int          parent; // union-find over shared edges
+	int          surf;
+	int          tri;
+	gltexture_t *tex;
+	vec3_t       center;
+	vec3_t       normal; // length is the area
+} rt_emissivetri_t;
+
+typedef struct rt_emissiveedge_s
+{
+	int key[6]; // both vertices quantized, lower one first
+	int tri;    // -1 if the slot is free
+} rt_emissiveedge_t;
+
+static int RT_FindEmissiveTri (rt_emissivetri_t *tris, int i)
+{
+	while (tris[i].parent != i)
+	{
+		tris[i].parent = tris[tris[i].parent].parent;
+		i = tris[i].parent;
+	}
+	return i;
+}
+
+/*
+================
+RT_LinkEmissiveEdge
+
+finds the triangle that already went through the edge a-b, or records tri for it
+================
+*/
+static int RT_LinkEmissiveEdge (rt_emissiveedge_t *edges, int mask, const float *a, const float *b, int tri)
+{
+	int va[3], vb[3], key[6];
+	for (int k = 0; k < 3; k++)
+	{
+		// close enough to count as the same vertex, like HaveSharedEdge
+		va[k] = (int)floorf (a[k] * 8.0f + 0.5f);
+		vb[k] = (int)floorf (b[k] * 8.0f + 0.5f);
+	}
+
+	const qboolean swap = memcmp (va, vb, sizeof (va)) > 0;
+	memcpy (&key[0], swap ? vb : va, sizeof (va));
+	memcpy (&key[3], swap ? va : vb, sizeof (vb));
+
+	uint32_t hash = 2166136261u;
+	for (int k = 0; k < 6; k++)
+		hash = (hash ^ (uint32_t)key[k]) * 16777619u;
+
+	for (int i = hash & mask;; i = (i + 1) & mask)
+	{
+		if (edges[i].tri < 0)
+		{
+			memcpy (edges[i].key, key, sizeof (key));
+			edges[i].tri = tri;
+			return -1;
+		}
+		if (memcmp (edges[i].key, key, sizeof (key)) == 0)
+			return edges[i].tri;
+	}
+}
+
+static int RT_WorldLightBudget (void)
+{
+	return CLAMP (1, CVAR_TO_INT32 (rt_plight_budget), MAX_WORLDLIGHTS_COUNT);
+}
+
+typedef struct rt_lightcell_s
+{
+	uint64_t key;
+	int      light;
+} rt_lightcell_t;
+
+static int RT_CompareLightCells (const void *a, const void *b)
+{
+	const rt_lightcell_t *ca = a, *cb = b;
+
+	if (ca->key != cb->key)
+		return ca->key < cb->key ? -1 : 1;
+	return ca->light - cb->light;
+}
+
+/*
+================
+RT_MergeWorldLights
+
+Merges the areas of RT_BuildWorldLights that lie in the same grid cell and face
+the same way, doubling the cell size until they fit into rt_plight_budget.
+Merged lights keep the summed color, so the total amount of light stays the same.
+================
+*/
+static void RT_MergeWorldLights (void)
+{
+	int              count = rt_wldlights_areas_count;
+	rt_worldlight_t *lights = Mem_Alloc (sizeof (rt_worldlight_t) * q_max (count, 1));
+	rt_lightcell_t  *cells = Mem_Alloc (sizeof (rt_lightcell_t) * q_max (count, 1));
+
+	memcpy (lights, rt_wldlights_areas, sizeof (rt_worldlight_t) * count);
+
+	rt_wldlights_budget = RT_WorldLightBudget ();
+	rt_wldlights_cell = 0;
+
+	for (float cell = 64.0f; count > rt_wldlights_budget; cell *= 2.0f)
+	{
+		// past the size of any map, only the facing keeps lights apart, and then not even that
+		const qboolean by_facing = cell < 65536.0f;
+
+		for (int i = 0; i < count; i++)
+		{
+			const rt_worldlight_t *l = &lights[i];
+			uint64_t               key = 0;
+
+			for (int k = 0; k < 3; k++)
+				key = (key << 16) | (uint16_t)((int)floorf (l->center[k] / cell) + 32768);
+
+			if (by_facing)
+			{
+				int axis = 0;
+				for (int k = 1; k < 3; k++)
+					if (fabsf (l->normal[k]) > fabsf (l->normal[axis]))
+						axis = k;
+				key = (key << 3) | (axis * 2 + (l->normal[axis] < 0));
+			}
+
+			cells[i].key = key;
+			cells[i].light = i;
+		}
+
+		qsort (cells, count, sizeof (rt_lightcell_t), RT_CompareLightCells);
+
+		rt_worldlight_t *merged = Mem_Alloc (sizeof (rt_worldlight_t) * count);
+		int              merged_count = 0;
+
+		for (int i = 0; i < count; i++)
+		{
+			rt_worldlight_t *src = &lights[cells[i].light];
+
+			if (i == 0 || cells[i].key != cells[i - 1].key)
+			{
+				merged[merged_count] = *src;
+				VectorScale (merged[merged_count].center, src->area, merged[merged_count].center);
+				merged_count++;
+				continue;
+			}
+
+			rt_worldlight_t *dst = &merged[merged_count - 1];
+
+			// the lowest id names the light, so it doesn't change when more areas join
+			dst->uniqueid = q_min (dst->uniqueid, src->uniqueid);
+
+			VectorMA (dst->center, src->area, src->center, dst->center);
+			VectorAdd (dst->normal, src->normal, dst->normal);
+			VectorAdd (dst->color, src->color, dst->color);
+			dst->area += src->area;
+		}
+
+		for (int i = 0; i < merged_count; i++)
+			VectorScale (merged[i].center, 1.0f / merged[i].area, merged[i].center);
+
+		Mem_Free (lights);
+		lights = merged;
+		count = merged_count;
+		rt_wldlights_cell = cell;
+	}
+
+	rt_wldlights_count = q_min (count, MAX_WORLDLIGHTS_COUNT);
+	memcpy (rt_wldlights, lights, sizeof (rt_worldlight_t) * rt_wldlights_count);
+
+	for (int i = 0; i < rt_wldlights_count; i++)
+		VectorNormalize (rt_wldlights[i].normal);
+
+	Mem_Free (cells);
+	Mem_Free (lights);
+}
+/*
+================
+RT_BuildWorldLights
+
+Joins the world's emissive triangles into connected areas, over shared edges
+and only between triangles of the same texture. This replaces the per batch
+HaveSharedEdge pass, which only caught consecutive triangles and had to redo
+it whenever the static world was submitted. Called on map load, after
+GL_BuildBModelVertexBuffer.
+================
+*/
+void RT_BuildWorldLights (void)
+{
+	qmodel_t *m = cl.worldmodel;
+	int       numtris = 0;
+
+	Mem_Free (rt_wldlights_areas);
+	rt_wldlights_areas = NULL;
+	rt_wldlights_areas_count = 0;
+	rt_wldlights_tris_count = 0;
+	rt_wldlights_count = 0;
+	rt_wldlights_budget = -1;
+
+	for (int i = 0; i < m->nummodelsurfaces; i++)
+	{
+		const msurface_t  *surf = &m->surfaces[m->firstmodelsurface + i];
+		const gltexture_t *tex = surf->texinfo->texture ? R_TextureAnimation (surf->texinfo->texture, 0)->gltexture : NULL;
+
+		if (tex && tex->rtcustomtextype == RT_CUSTOMTEXTUREINFO_TYPE_POLY_LIGHT)
+			numtris += q_max (0, surf->numedges - 2);
+	}
+
+	if (numtris == 0)
+		return;
+
+	int edgecount = 1;
+	while (edgecount < numtris * 3 * 2)
+		edgecount <<= 1;
+
+	rt_emissivetri_t  *tris = Mem_Alloc (sizeof (rt_emissivetri_t) * numtris);
+	rt_emissiveedge_t *edges = Mem_Alloc (sizeof (rt_emissiveedge_t) * edgecount);
+	for (int i = 0; i < edgecount; i++)
+		edges[i].tri = -1;
+
+	numtris = 0;
+	for (int i = 0; i < m->nummodelsurfaces; i++)
+	{
+		msurface_t  *surf = &m->surfaces[m->firstmodelsurface + i];
+		gltexture_t *tex = surf->texinfo->texture ? R_TextureAnimation (surf->texinfo->texture, 0)->gltexture : NULL;
+
+		if (!tex || tex->rtcustomtextype != RT_CUSTOMTEXTUREINFO_TYPE_POLY_LIGHT)
+			continue;
+
+		const RgVertex *verts = &rtallbrushvertices[surf->vbo_firstvert];
+
+		// same fan as R_TriangleIndicesForSurf
+		for (int v = 2; v < surf->numedges; v++)
+		{
+			rt_emissivetri_t *t = &tris[numtris];
+			const float      *corners[3] = {verts[v].position, verts[v - 1].position, verts[0].position};
+			vec3_t            e1, e2;
+
+			t->parent = numtris;
+			t->surf = m->firstmodelsurface + i;
+			t->tri = v - 2;
+			t->tex = tex;
+
+			VectorAdd (corners[0], corners[1], t->center);
+			VectorAdd (t->center, corners[2], t->center);
+			VectorScale (t->center, 1.0f / 3.0f, t->center);
+
+			VectorSubtract (corners[1], corners[0], e1);
+			VectorSubtract (corners[2], corners[0], e2);
+			CrossProduct (e1, e2, t->normal);
+			VectorScale (t->normal, 0.5f, t->normal);
+
+			for (int k = 0; k < 3; k++)
+			{
+				int other = RT_LinkEmissiveEdge (edges, edgecount - 1, corners[k], corners[(k + 1) % 3], numtris);
+				if (other >= 0 && tris[other].tex == tex)
+				{
+					int a = RT_FindEmissiveTri (tris, other);
+					int b = RT_FindEmissiveTri (tris, numtris);
+					tris[q_max (a, b)].parent = q_min (a, b);
+				}
+			}
+
+			numtris++;
+		}
+	}
+
+	//
+	// one area per connected set of triangles, its id is the one of its first triangle
+	//
+	int *areaindex = Mem_Alloc (sizeof (int) * numtris);
+	for (int i = 0; i < numtris; i++)
+	{
+		const int root = RT_FindEmissiveTri (tris, i);
+		if (root == i)
+			areaindex[i] = rt_wldlights_areas_count++;
+		else
+			areaindex[i] = areaindex[root]; // roots always have the lowest index of their set
+	}
+
+	rt_wldlights_areas = Mem_AllocTagged (sizeof (rt_worldlight_t) * rt_wldlights_areas_count, MEMTAG_RT);
+	for (int i = 0; i < numtris; i++)
+	{
+		rt_emissivetri_t *t = &tris[i];
+		rt_worldlight_t  *area = &rt_wldlights_areas[areaindex[i]];
+		const float       weight = q_max (VectorLength (t->normal), 0.001f);
+
+		if (area->area == 0)
+		{
+			area->uniqueid = RT_GetBrushSurfUniqueId (ENT_UNIQUEID_WORLD, m, &m->surfaces[t->surf], t->tri);
+			VectorCopy (t->tex->rtlightcolor, area->color);
+		}
+
+		VectorMA (area->center, weight, t->center, area->center);
+		VectorAdd (area->normal, t->normal, area->normal);
+		area->area += weight;
+	}
+
+	for (int i = 0; i < rt_wldlights_areas_count; i++)
+	{
+		rt_worldlight_t *area = &rt_wldlights_areas[i];
+		VectorScale (area->center, 1.0f / area->area, area->center);
+	}
+
+	rt_wldlights_tris_count = numtris;
+
+	Mem_Free (areaindex);
+	Mem_Free (edges);
+	Mem_Free (tris);
+
+	RT_MergeWorldLights ();
+	Con_DPrintf (
+		"%d emissive triangles -> %d areas -> %d lights (budget %d)\n", rt_wldlights_tris_count, rt_wldlights_areas_count, rt_wldlights_count,
+		rt_wldlights_budget);
+}
+
+#endif
+
+/*
+================
+RT_PrintWorldLights_f
+================
+*/
+void RT_PrintWorldLights_f (void)
+{
+#if RT_USE_SPHERE_INSTEAD_OF_POLY
+	Con_Printf ("%d emissive triangles\n", rt_wldlights_tris_count);
+	Con_Printf ("%d connected areas\n", rt_wldlights_areas_count);
+	if (rt_wldlights_cell > 0)
+		Con_Printf ("%d lights, budget %d, merged on a %.0f unit grid\n", rt_wldlights_count, rt_wldlights_budget, rt_wldlights_cell);
+	else
+		Con_Printf ("%d lights, budget %d\n", rt_wldlights_count, rt_wldlights_budget);
+#else
+	Con_Printf ("%d emissive triangles, uploaded as polygonal lights\n", rt_wldlights_tri_count);
+#endif
+}
+
 void RT_UploadAllWorldModelLights (void)
 {
 #if RT_USE_SPHERE_INSTEAD_OF_POLY
-	for (int i = 0; i < rt_wldlights_sph_count; i++)
+	if (rt_wldlights_budget != RT_WorldLightBudget ())
 	{
-		RgResult r = rgUploadSphericalLight(vulkan_globals.instance, &rt_wldlights_sph[i]);
+		RT_MergeWorldLights ();
+	}
+
+	const float radius = METRIC_TO_QUAKEUNIT (CVAR_TO_FLOAT (rt_plight_radius));
+
+	for (int i = 0; i < rt_wldlights_count; i++)
+	{
+		rt_worldlight_t *src = &rt_wldlights[i];
+
+		vec3_t color, position;
+		VectorScale (src->color, CVAR_TO_FLOAT (rt_plight_intensity), color);
+		RT_FIXUP_LIGHT_INTENSITY (color, true);
+		VectorMA (src->center, radius, src->normal, position);
+
+		RgSphericalLightUploadInfo light_info = {
+			.uniqueID = src->uniqueid,
+			.color = RT_VEC3 (color),
+			.position = RT_VEC3 (position),
+			.radius = radius,
+		};
+
+		RgResult r = rgUploadSphericalLight (vulkan_globals.instance, &light_info);
 		RG_CHECK (r);
-    }
+	}
 #else
 	for (int i = 0; i < rt_wldlights_tri_count; i++)
 	{
@@ -1668,6 +2350,8 @@ void RT_UploadAllWorldModelLights (void)
 
 
 
+#define RG_MAX_PORTALS 62
+
 typedef struct rt_teleport_s
 {
 	vec3_t   a;
@@ -1679,6 +2363,9 @@ typedef struct rt_teleport_s
 rt_teleport_t *rt_teleports = NULL;
 int            rt_teleports_count = 0;
 
+// portal indices sorted by a[0], for RT_NearestPortal
+static int rt_teleports_order[RG_MAX_PORTALS];
+
 
 struct rt_triggerteleport_t
 {
@@ -1901,10 +2588,7 @@ static void LoadCustomTeleportInfoAndPatch ()
 	fclose (f);
 }
 
-
-#define RG_MAX_PORTALS 62
-
-void RT_ParseTeleports (void)
+static void RT_ParseTeleportEntities (void)
 {
 	rt_teleports_count = 0;
 	
@@ -1968,6 +2652,111 @@ void RT_ParseTeleports (void)
 	LoadCustomTeleportInfoAndPatch ();
 }
 
+static int RT_CompareTeleports (const void *a, const void *b)
+{
+	const float xa = rt_teleports[*(const int *)a].a[0];
+	const float xb = rt_teleports[*(const int *)b].a[0];
+
+	return (xa > xb) - (xa < xb);
+}
+
+/*
+================
+RT_NearestPortal
+
+Walks outwards from p[0] over the portals sorted along x, and stops as soon as
+the distance along x alone is further than the best match.
+================
+*/
+static int RT_NearestPortal (const vec3_t p)
+{
+	int   lo = 0, hi = rt_teleports_count;
+	int   nearest = -1;
+	float nearest_dist = FLT_MAX;
+
+	// first portal with a[0] >= p[0]
+	while (lo < hi)
+	{
+		const int mid = (lo + hi) / 2;
+		if (rt_teleports[rt_teleports_order[mid]].a[0] < p[0])
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (int up = lo, down = lo - 1; up < rt_teleports_count || down >= 0;)
+	{
+		const float dup = (up < rt_teleports_count) ? rt_teleports[rt_teleports_order[up]].a[0] - p[0] : FLT_MAX;
+		const float ddown = (down >= 0) ? p[0] - rt_teleports[rt_teleports_order[down]].a[0] : FLT_MAX;
+		const int   i = (dup < ddown) ? rt_teleports_order[up++] : rt_teleports_order[down--];
+		const float dx = q_min (dup, ddown);
+
+		if (dx * dx >= nearest_dist)
+			break;
+
+		const float d = DistanceSqr (rt_teleports[i].a, p);
+		if (d < nearest_dist || (d == nearest_dist && i < nearest))
+		{
+			nearest = i;
+			nearest_dist = d;
+		}
+	}
+
+	return nearest;
+}
+
+/*
+================
+RT_ParseTeleports
+
+Also associates every teleport surface of the precached brush models with its
+nearest portal, in model space, so RT_FindNearestTeleport doesn't have to
+look at the vertices each time the surface is drawn.
+================
+*/
+void RT_ParseTeleports (void)
+{
+	RT_ParseTeleportEntities ();
+
+	for (int i = 0; i < rt_teleports_count; i++)
+		rt_teleports_order[i] = i;
+	qsort (rt_teleports_order, rt_teleports_count, sizeof (rt_teleports_order[0]), RT_CompareTeleports);
+
+	for (int j = 1; j < MAX_MODELS; j++)
+	{
+		qmodel_t *m = cl.model_precache[j];
+
+		if (!m || m->type != mod_brush)
+			continue;
+
+		for (int i = 0; i < m->nummodelsurfaces; i++)
+		{
+			msurface_t *surf = &m->surfaces[m->firstmodelsurface + i];
+
+			if (!(surf->flags & SURF_DRAWTELE))
+				continue;
+
+			vec3_t emin = {FLT_MAX, FLT_MAX, FLT_MAX};
+			vec3_t emax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+			for (int v = 0; v < surf->numedges; v++)
+			{
+				const float *pos = rtallbrushvertices[surf->vbo_firstvert + v].position;
+
+				for (int k = 0; k < 3; k++)
+				{
+					emin[k] = q_min (pos[k], emin[k]);
+					emax[k] = q_max (pos[k], emax[k]);
+				}
+			}
+
+			VectorAdd (emin, emax, surf->rtcenter);
+			VectorScale (surf->rtcenter, 0.5f, surf->rtcenter);
+			surf->rtportal = 1 + RT_NearestPortal (surf->rtcenter);
+		}
+	}
+}
+
 
 static RgFloat3D ApplyTransform (const RgTransform *transform, const vec3_t v)
 {
@@ -1993,38 +2782,59 @@ static float DistanceSqr (const vec3_t a, const vec3_t b)
 }
 
 
-static qboolean RT_FindNearestTeleport (const RgGeometryUploadInfo *info, uint8_t *result, qboolean *potentially_mirror)
+/*
+================
+RT_FindNearestTeleport
+
+Teleport surfaces are never batched together, as R_DrawTextureChains_Water
+flushes for each one, so surf stands for the whole upload.
+================
+*/
+static qboolean RT_FindNearestTeleport (const RgGeometryUploadInfo *info, const msurface_t *surf, uint8_t *result, qboolean *potentially_mirror)
 {
-	vec3_t emin = {FLT_MAX, FLT_MAX, FLT_MAX};
-	vec3_t emax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	const static RgTransform identity = RT_TRANSFORM_IDENTITY;
 
-	for (uint32_t i = 0; i < info->vertexCount; i++)
+	int nearest;
+
+	if (rt_teleports_count == 0)
 	{
-		RgFloat3D v = ApplyTransform (&info->transform, info->pVertices[i].position);
+		return false;
+	}
 
-		for (int k = 0; k < 3; k++)
+	if (surf->rtportal != 0)
+	{
+		if (memcmp (&info->transform, &identity, sizeof (identity)) == 0)
 		{
-			emin[k] = q_min (v.data[k], emin[k]);
-			emax[k] = q_max (v.data[k], emax[k]);
+			nearest = surf->rtportal - 1;
+		}
+		else
+		{
+			RgFloat3D center = ApplyTransform (&info->transform, surf->rtcenter);
+			nearest = RT_NearestPortal (center.data);
 		}
 	}
-
-	vec3_t center;
-	VectorAdd (emin, emax, center);
-	VectorScale (center, 0.5f, center);
-
-	int nearest = -1;
-	float nearest_dist = FLT_MAX;
-
-	for (int i = 0; i < rt_teleports_count; i++)
+	else
 	{
-		float d = DistanceSqr (rt_teleports[i].a, center);
+		// precached after RT_ParseTeleports
+		vec3_t emin = {FLT_MAX, FLT_MAX, FLT_MAX};
+		vec3_t emax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
 
-		if (d < nearest_dist)
+		for (uint32_t i = 0; i < info->vertexCount; i++)
 		{
-			nearest = i;
-			nearest_dist = d;
+			RgFloat3D v = ApplyTransform (&info->transform, info->pVertices[i].position);
+
+			for (int k = 0; k < 3; k++)
+			{
+				emin[k] = q_min (v.data[k], emin[k]);
+				emax[k] = q_max (v.data[k], emax[k]);
+			}
 		}
+
+		vec3_t center;
+		VectorAdd (emin, emax, center);
+		VectorScale (center, 0.5f, center);
+
+		nearest = RT_NearestPortal (center);
 	}
 
 	if (nearest < 0)
@@ -2112,6 +2922,27 @@ void RT_PrintNearestPortal ()
 	{
 		Con_Printf ("[NRST] Portal %d: %.1f %.1f %.1f\n", nearest, rt_teleports[nearest].a[0], rt_teleports[nearest].a[1], rt_teleports[nearest].a[2]);
 	}
+
+	// the surface to portal association made by RT_ParseTeleports
+	for (int j = 1; j < MAX_MODELS; j++)
+	{
+		qmodel_t *m = cl.model_precache[j];
+
+		if (!m || m->type != mod_brush)
+			continue;
+
+		for (int i = 0; i < m->nummodelsurfaces; i++)
+		{
+			const msurface_t *surf = &m->surfaces[m->firstmodelsurface + i];
+
+			if (surf->rtportal > 0)
+			{
+				Con_Printf (
+					"       %s surface %d: %.1f %.1f %.1f -> Portal %d\n", m->name, i, surf->rtcenter[0], surf->rtcenter[1], surf->rtcenter[2],
+					surf->rtportal - 1);
+			}
+		}
+	}
 	
 	{
 		Con_Printf ("%s\n", cl.worldmodel->name);
@@ -66,6 +66,9 @@ typedef struct entity_s
 
 	int update_type;
 
+	int      activeslot; // 1-based position in cl.activeentities, 0 when not listed
+	qboolean atrest;     // both msg_origins and msg_angles are equal, lerping them is a copy
+
 	entity_state_t baseline; // to fill in defaults in updates
 	entity_state_t netstate; // the latest network state
 
@@ -83,6 +86,8 @@ typedef struct entity_s
 	int              skinnum;  // for Alias models
 	int              visframe; // last frame this entity was
 	                           //  found in an active leaf
+	int              cullframe; // R_CullVisEdicts pass that set culled
+	qboolean         culled;    // outside the frustum in that pass
 
 	int dlightframe; // dynamic lighting
 	int dlightbits;
@@ -77,6 +77,7 @@ qboolean Sbar_CSQCCommand (void)
 	qboolean ret = false;
 	if (cl.qcvm.extfuncs.CSQC_ConsoleCommand)
 	{
+		Host_WaitForCSQCPhysics ();
 		PR_SwitchQCVM (&cl.qcvm);
 		G_INT (OFS_PARM0) = PR_MakeTempString (Cmd_Argv (0));
 		PR_ExecuteProgram (cl.qcvm.extfuncs.CSQC_ConsoleCommand);
@@ -944,6 +945,7 @@ void Sbar_Draw (cb_context_t *cbx)
 		qboolean deathmatchoverlay = false;
 		float    s = CLAMP (1.0, scr_sbarscale.value, (float)glwidth / 320.0);
 		GL_SetCanvas (cbx, CANVAS_CSQC); // johnfitz
+		Host_WaitForCSQCPhysics (); // SCR_UpdateScreen can be called from inside CL_ReadFromServer
 		PR_SwitchQCVM (&cl.qcvm);
 		pr_global_struct->frametime = host_frametime;
 		if (qcvm->extglobals.cltime)
@@ -1378,6 +1380,7 @@ void Sbar_IntermissionOverlay (cb_context_t *cbx)
 	{
 		float s = CLAMP (1.0, scr_sbarscale.value, (float)glwidth / 320.0);
 		GL_SetCanvas (cbx, CANVAS_CSQC);
+		Host_WaitForCSQCPhysics ();
 		PR_SwitchQCVM (&cl.qcvm);
 		if (qcvm->extglobals.cltime)
 			*qcvm->extglobals.cltime = realtime;
@@ -286,12 +286,16 @@ extern cvar_t coop;
 extern cvar_t fraglimit;
 extern cvar_t timelimit;
 
-extern server_static_t svs; // persistant server info
-extern server_t        sv;  // local server
+// a process can host several independent servers, sv and svs always refer to the one that is running (see sv_instance.c)
+// per thread, the server instances run their physics on tasks
+extern THREAD_LOCAL server_static_t *svs_current;
+extern THREAD_LOCAL server_t        *sv_current;
+#define svs (*svs_current) // persistant server info
+#define sv  (*sv_current)  // local server
 
 extern client_t *host_client;
 
-extern edict_t *sv_player;
+extern THREAD_LOCAL edict_t *sv_player;
 
 //===========================================================
 
@@ -336,4 +340,15 @@ void SV_RunClients (void);
 void SV_SaveSpawnparms ();
 void SV_SpawnServer (const char *server);
 
+struct qmodel_s *SV_ModelForName (const char *name, qboolean crash);
+void             SV_ModelsForNames (const char **names, struct qmodel_s **models, int count, qboolean crash);
+
+// sv_instance.c
+void SV_Instance_Init (void);
+int  SV_NumInstances (void);
+void SV_ResetInstance (void);
+void SV_RunInstances (void);
+void SV_ShutdownInstances (void);
+void SV_InstanceCommand (const char *text);
+
 #endif /* _QUAKE_SERVER_H */
@@ -94,6 +94,11 @@ static cvar_t ambient_fade = {"ambient_fade", "100", CVAR_NONE};
 static cvar_t snd_noextraupdate = {"snd_noextraupdate", "0", CVAR_NONE};
 static cvar_t snd_show = {"snd_show", "0", CVAR_NONE};
 static cvar_t _snd_mixahead = {"_snd_mixahead", "0.1", CVAR_ARCHIVE};
+static cvar_t snd_cachesize = {"snd_cachesize", "64", CVAR_ARCHIVE}; // MB of decoded sounds kept across map changes
+
+// decoded sounds survive S_ClearAll, least recently precached first out once over snd_cachesize
+static int snd_cacheseq = 1;
+static int snd_cachehits, snd_cachemisses, snd_cachestale, snd_cacheevicted;
 
 static void S_SoundInfo_f (void)
 {
@@ -109,6 +114,10 @@ static void S_SoundInfo_f (void)
 	Con_Printf ("%5d submission_chunk\n", shm->submission_chunk);
 	Con_Printf ("%5d total_channels\n", total_channels);
 	Con_Printf ("%p dma buffer\n", shm->buffer);
+	Con_Printf ("%5u sounds decoded\n", Atomic_LoadUInt32 (&snd_decoded));
+	Con_Printf ("%5u unprecached sounds\n", Atomic_LoadUInt32 (&snd_unprecached));
+	Con_Printf ("%5u started late\n", Atomic_LoadUInt32 (&snd_late));
+	Con_Printf ("%5u missed\n", Atomic_LoadUInt32 (&snd_missed));
 }
 
 static void SND_Callback_sfxvolume (cvar_t *var)
@@ -177,6 +186,7 @@ void S_Init (void)
 	Cvar_RegisterVariable (&sndspeed);
 	Cvar_RegisterVariable (&snd_mixspeed);
 	Cvar_RegisterVariable (&snd_filterquality);
+	Cvar_RegisterVariable (&snd_cachesize);
 
 	if (safemode || COM_CheckParm ("-nosound"))
 		return;
@@ -227,6 +237,22 @@ void S_Init (void)
 	S_StopAllSounds (true);
 }
 
+/*
+================
+S_JoinDecodeTasks
+
+Waits for the sounds still being decoded, they write to their sfx and read shm
+================
+*/
+static void S_JoinDecodeTasks (void)
+{
+	for (int i = 0; i < num_sfx; ++i)
+	{
+		if (Atomic_LoadUInt32 (&known_sfx[i].state) == SFX_LOADING)
+			Task_Join (known_sfx[i].decode_task, SDL_MUTEX_MAXWAIT);
+	}
+}
+
 // =======================================================================
 // Shutdown sound engine
 // =======================================================================
@@ -235,6 +261,8 @@ void S_Shutdown (void)
 	if (!sound_started)
 		return;
 
+	S_JoinDecodeTasks ();
+
 	sound_started = 0;
 	snd_blocked = 0;
 
@@ -298,6 +326,53 @@ void S_TouchSound (const char *name)
 	S_FindName (name);
 }
 
+/*
+==================
+S_FreeCache
+
+Caller holds snd_mutex
+==================
+*/
+static void S_FreeCache (sfx_t *sfx)
+{
+	SAFE_FREE (sfx->cache);
+	sfx->cachebytes = 0;
+	Atomic_StoreUInt32 (&sfx->state, SFX_UNLOADED);
+}
+
+/*
+==================
+S_CheckCache
+
+The first precache of a sound on a map reuses a cache kept from an earlier map
+as long as its file hasn't changed
+==================
+*/
+static void S_CheckCache (sfx_t *sfx)
+{
+	char        namebuffer[256];
+	filestamp_t stamp;
+
+	if (sfx->cacheseq == snd_cacheseq)
+		return;
+	sfx->cacheseq = snd_cacheseq;
+
+	if (Atomic_LoadUInt32 (&sfx->state) == SFX_LOADED)
+	{
+		q_snprintf (namebuffer, sizeof (namebuffer), "sound/%s", sfx->name);
+		if (COM_FileStamp (namebuffer, &stamp) && !memcmp (&stamp, &sfx->filestamp, sizeof (stamp)))
+		{
+			snd_cachehits++;
+			return;
+		}
+		SDL_LockMutex (snd_mutex);
+		S_FreeCache (sfx);
+		SDL_UnlockMutex (snd_mutex);
+		snd_cachestale++;
+	}
+	snd_cachemisses++;
+}
+
 /*
 ==================
 S_PrecacheSound
@@ -312,10 +387,11 @@ sfx_t *S_PrecacheSound (const char *name)
 		return NULL;
 
 	sfx = S_FindName (name);
+	S_CheckCache (sfx);
 
-	// cache it in
+	// start decoding it in the background
 	if (precache.value)
-		S_LoadSound (sfx);
+		S_QueueLoadSound (sfx);
 
 	return sfx;
 }
@@ -453,8 +529,16 @@ void S_StartSound (int entnum, int entchannel, sfx_t *sfx, vec3_t origin, float
 	sc = S_LoadSound (sfx);
 	if (!sc)
 	{
-		target_chan->sfx = NULL;
-		goto unlock_mutex; // couldn't load the sound's data
+		// still decoding, the mixer starts the channel once it's ready
+		if (Atomic_LoadUInt32 (&sfx->state) != SFX_FAILED)
+		{
+			target_chan->sfx = sfx;
+			target_chan->pending = 1;
+			target_chan->end = paintedtime;
+		}
+		else
+			target_chan->sfx = NULL; // couldn't load the sound's data
+		goto unlock_mutex;
 	}
 
 	target_chan->sfx = sfx;
@@ -585,6 +669,9 @@ void S_StaticSound (sfx_t *sfx, vec3_t origin, float vol, float attenuation)
 	if (!sfx)
 		return;
 
+	// static sounds loop from signon on, so they can't start late
+	sc = S_WaitSound (sfx);
+
 	SDL_LockMutex (snd_mutex);
 
 	if (total_channels == MAX_CHANNELS)
@@ -596,7 +683,6 @@ void S_StaticSound (sfx_t *sfx, vec3_t origin, float vol, float attenuation)
 	ss = &snd_channels[total_channels];
 	total_channels++;
 
-	sc = S_LoadSound (sfx);
 	if (!sc)
 		goto unlock_mutex;
 
@@ -983,22 +1069,74 @@ unlock_mutex:
 S_ClearAll
 ===============================================================================
 */
+static int S_CompareCacheSeq (const void *a, const void *b)
+{
+	return (*(sfx_t *const *)b)->cacheseq - (*(sfx_t *const *)a)->cacheseq;
+}
+
 void S_ClearAll (void)
 {
+	sfx_t **cached;
+	int     numcached = 0;
+	int64_t budget = (int64_t)(q_max (snd_cachesize.value, 0.f) * 1024.f * 1024.f);
+
+	S_JoinDecodeTasks ();
+
 	SDL_LockMutex (snd_mutex);
 
+	// keep the most recently precached sounds that fit into snd_cachesize
+	cached = (sfx_t **)Mem_Alloc (q_max (num_sfx, 1) * sizeof (sfx_t *));
 	for (int i = 0; i < num_sfx; ++i)
 	{
-		if (known_sfx[i].cache)
+		if (Atomic_LoadUInt32 (&known_sfx[i].state) == SFX_LOADED)
+			cached[numcached++] = &known_sfx[i];
+		else
+			S_FreeCache (&known_sfx[i]);
+	}
+
+	qsort (cached, numcached, sizeof (sfx_t *), S_CompareCacheSeq);
+
+	snd_cachehits = snd_cachemisses = snd_cachestale = snd_cacheevicted = 0;
+	for (int i = 0; i < numcached; ++i)
+	{
+		budget -= cached[i]->cachebytes;
+		if (budget < 0)
 		{
-			Mem_Free (known_sfx[i].cache);
-			known_sfx[i].cache = NULL;
+			S_FreeCache (cached[i]);
+			snd_cacheevicted++;
 		}
 	}
+	snd_cacheseq++;
+
+	Mem_Free (cached);
 
 	SDL_UnlockMutex (snd_mutex);
 }
 
+/*
+===============================================================================
+S_PrintCacheStats
+===============================================================================
+*/
+void S_PrintCacheStats (void)
+{
+	int     numcached = 0;
+	int64_t bytes = 0;
+
+	for (int i = 0; i < num_sfx; ++i)
+	{
+		if (Atomic_LoadUInt32 (&known_sfx[i].state) == SFX_LOADED)
+		{
+			numcached++;
+			bytes += known_sfx[i].cachebytes;
+		}
+	}
+
+	Con_Printf (
+		"sounds: %d hits, %d misses (%d stale), %d evicted, %d cached in %.1f / %.0f MB\n", snd_cachehits, snd_cachemisses, snd_cachestale,
+		snd_cacheevicted, numcached, bytes / (1024.0 * 1024.0), snd_cachesize.value);
+}
+
 /*
 ===============================================================================
 
@@ -1061,9 +1199,9 @@ static void S_SoundList (void)
 	total = 0;
 	for (sfx = known_sfx, i = 0; i < num_sfx; i++, sfx++)
 	{
-		sc = (sfxcache_t *)sfx->cache;
-		if (!sc)
+		if (Atomic_LoadUInt32 (&sfx->state) != SFX_LOADED)
 			continue;
+		sc = (sfxcache_t *)sfx->cache;
 		size = sc->length * sc->width * (sc->stereo + 1);
 		total += size;
 		if (sc->loopstart >= 0)
@@ -83,56 +83,52 @@ static void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
 
 //=============================================================================
 
+atomic_uint32_t snd_decoded;
+atomic_uint32_t snd_late;
+atomic_uint32_t snd_missed;
+atomic_uint32_t snd_unprecached;
+
 /*
 ==============
-S_LoadSound
+S_DecodeSound
+
+Reads and resamples a sound, safe to run on a worker task
 ==============
 */
-sfxcache_t *S_LoadSound (sfx_t *s)
+static sfxcache_t *S_DecodeSound (sfx_t *s)
 {
 	char        namebuffer[256];
+	fileview_t  view;
 	byte       *data = NULL;
 	wavinfo_t   info;
 	int         len;
 	float       stepscale;
 	sfxcache_t *sc = NULL;
 
-	SDL_LockMutex (snd_mutex);
-
-	// see if still in memory
-	if (s->cache)
-	{
-		sc = s->cache;
-		goto unlock_mutex;
-	}
-
-	//	Con_Printf ("S_LoadSound: %x\n", (int)stackbuf);
-
 	// load it in
 	q_strlcpy (namebuffer, "sound/", sizeof (namebuffer));
 	q_strlcat (namebuffer, s->name, sizeof (namebuffer));
 
-	//	Con_Printf ("loading %s\n",namebuffer);
-
-	data = COM_LoadFile (namebuffer, NULL);
-
-	if (!data)
+	// the samples are only read while resampling, so they can stay in the pak mapping
+	if (!COM_MapFile (namebuffer, NULL, &view))
 	{
 		Con_Printf ("Couldn't load %s\n", namebuffer);
-		goto unlock_mutex;
+		return NULL;
 	}
+	data = (byte *)view.data;
+	COM_FileStamp (namebuffer, &s->filestamp);
 
-	info = GetWavinfo (s->name, data, com_filesize);
+	info = GetWavinfo (s->name, data, view.size);
 	if (info.channels != 1)
 	{
 		Con_Printf ("%s is a stereo sample\n", s->name);
-		goto unlock_mutex;
+		goto unmap;
 	}
 
 	if (info.width != 1 && info.width != 2)
 	{
 		Con_Printf ("%s is not 8 or 16 bit\n", s->name);
-		goto unlock_mutex;
+		goto unmap;
 	}
 
 	stepscale = (float)info.rate / shm->speed;
@@ -143,12 +139,12 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 	if (info.samples == 0 || len == 0)
 	{
 		Con_Printf ("%s has zero samples\n", s->name);
-		goto unlock_mutex;
+		goto unmap;
 	}
 
 	sc = (sfxcache_t *)Mem_Alloc (len + sizeof (sfxcache_t));
 	if (!sc)
-		goto unlock_mutex;
+		goto unmap;
 	sc->length = info.samples;
 	sc->loopstart = info.loopstart;
 	sc->speed = info.rate;
@@ -156,14 +152,93 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 	sc->stereo = info.channels;
 
 	s->cache = sc;
+	s->cachebytes = len + sizeof (sfxcache_t);
 	ResampleSfx (s, sc->speed, sc->width, data + info.dataofs);
 
-unlock_mutex:
-	Mem_Free (data);
-	SDL_UnlockMutex (snd_mutex);
+unmap:
+	COM_UnmapFile (&view);
 	return sc;
 }
 
+/*
+==============
+S_DecodeSoundTask
+==============
+*/
+static void S_DecodeSoundTask (void *payload)
+{
+	sfx_t         *s = *(sfx_t **)payload;
+	const memtag_t prev_tag = Mem_SetTag (MEMTAG_SOUND);
+	sfxcache_t    *sc = S_DecodeSound (s);
+
+	Mem_SetTag (prev_tag);
+
+	// the cache is published by the state store, readers check the state first
+	if (sc)
+	{
+		Atomic_IncrementUInt32 (&snd_decoded);
+		Atomic_StoreUInt32 (&s->state, SFX_LOADED);
+	}
+	else
+		Atomic_StoreUInt32 (&s->state, SFX_FAILED);
+}
+
+/*
+==============
+S_QueueLoadSound
+
+Starts decoding a sound on a worker task if that hasn't happened yet
+==============
+*/
+void S_QueueLoadSound (sfx_t *s)
+{
+	SDL_LockMutex (snd_mutex);
+	if (Atomic_LoadUInt32 (&s->state) == SFX_UNLOADED)
+	{
+		s->decode_task = Task_AllocateAndAssignFunc ("S_DecodeSound", S_DecodeSoundTask, &s, sizeof (sfx_t *));
+		Atomic_StoreUInt32 (&s->state, SFX_LOADING);
+		Task_Submit (s->decode_task);
+	}
+	SDL_UnlockMutex (snd_mutex);
+}
+
+/*
+==============
+S_LoadSound
+
+Never blocks: returns NULL and queues the decode if the sound isn't ready yet
+==============
+*/
+sfxcache_t *S_LoadSound (sfx_t *s)
+{
+	switch (Atomic_LoadUInt32 (&s->state))
+	{
+	case SFX_LOADED:
+		return s->cache;
+	case SFX_UNLOADED:
+		Atomic_IncrementUInt32 (&snd_unprecached);
+		S_QueueLoadSound (s);
+		break;
+	}
+	return NULL;
+}
+
+/*
+==============
+S_WaitSound
+
+Blocks until the sound has been decoded, for callers that can't play it late
+==============
+*/
+sfxcache_t *S_WaitSound (sfx_t *s)
+{
+	if (Atomic_LoadUInt32 (&s->state) == SFX_UNLOADED)
+		S_QueueLoadSound (s);
+	if (Atomic_LoadUInt32 (&s->state) == SFX_LOADING)
+		Task_Join (s->decode_task, SDL_MUTEX_MAXWAIT);
+	return (Atomic_LoadUInt32 (&s->state) == SFX_LOADED) ? s->cache : NULL;
+}
+
 /*
 ===============================================================================
 
@@ -172,11 +247,12 @@ WAV loading
 ===============================================================================
 */
 
-static byte *data_p;
-static byte *iff_end;
-static byte *last_chunk;
-static byte *iff_data;
-static int   iff_chunk_len;
+// sounds are parsed on worker tasks
+static THREAD_LOCAL byte *data_p;
+static THREAD_LOCAL byte *iff_end;
+static THREAD_LOCAL byte *last_chunk;
+static THREAD_LOCAL byte *iff_data;
+static THREAD_LOCAL int   iff_chunk_len;
 
 static short GetLittleShort (void)
 {
@@ -347,10 +347,12 @@ void S_PaintChannels (int endtime)
 {
 	int         i;
 	int         end, ltime, count;
+	int         late, max_late;
 	channel_t  *ch;
 	sfxcache_t *sc;
 
 	snd_vol = sfxvolume.value * 256;
+	max_late = SND_MAX_LATE_MSEC * shm->speed / 1000;
 
 	while (paintedtime < endtime)
 	{
@@ -368,6 +370,29 @@ void S_PaintChannels (int endtime)
 		{
 			if (!ch->sfx)
 				continue;
+			if (ch->pending)
+			{
+				// started while its sfx was still decoding, end holds the start time
+				late = paintedtime - ch->end;
+				sc = S_LoadSound (ch->sfx);
+				if (sc && late <= max_late)
+				{
+					Atomic_IncrementUInt32 (&snd_late);
+					ch->pending = 0;
+					ch->end = paintedtime + sc->length;
+				}
+				else
+				{
+					if (sc || late > max_late)
+					{
+						Atomic_IncrementUInt32 (&snd_missed);
+						ch->sfx = NULL;
+					}
+					else if (Atomic_LoadUInt32 (&ch->sfx->state) == SFX_FAILED)
+						ch->sfx = NULL;
+					continue;
+				}
+			}
 			if (!ch->leftvol && !ch->rightvol)
 				continue;
 			sc = S_LoadSound (ch->sfx);
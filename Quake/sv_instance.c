@@ -0,0 +1,636 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sv_instance.c -- several independent servers in one dedicated process
+
+/*
+Every instance has its own server_t, server_static_t (and so its own qcvm,
+progs and clients), listening port and match rules. The model cache, the
+filesystem search paths and the task workers are shared, so a map that is
+already loaded by one instance costs nothing to the next one. A model is freed
+once every instance that used it has changed map (see Mod_ClearAll).
+
+sv and svs always point at the instance that is running, they are per thread.
+Every host frame the main thread reads the packets and runs the clients of each
+instance in turn, then SV_Physics runs for all of them at once on tasks and the
+main thread finally sends their messages (SV_RunInstances). Only the main instance
+reads the command buffer; commands for the others go through sv_instance_exec, or
+are queued by their QC (changelevel, localcmd).
+*/
+
+#include "quakedef.h"
+
+#define MAX_SV_INSTANCES 64
+
+extern cvar_t samelevel;
+extern cvar_t noexit;
+
+// cvars that every instance keeps a value of its own for
+static cvar_t *sv_instancerules[] = {&hostname, &deathmatch, &coop, &skill, &teamplay, &fraglimit, &timelimit, &noexit, &samelevel};
+#define NUM_INSTANCE_RULES countof (sv_instancerules)
+
+typedef struct
+{
+	char             name[32];
+	server_t         server;
+	server_static_t  stat;
+	net_listenset_t *listen; // NULL for the main instance, which uses the regular listening sockets
+	int              port;
+	int              slot; // owner bit of the models it uses, see Mod_ClearAll
+	int              activeconnections;
+	char            *rules[NUM_INSTANCE_RULES]; // rule values while the instance is not running
+	char            *cmdtext;                   // queued by SV_InstanceCommand, run before the next frame
+	edict_t         *player;                    // sv_player once its clients ran, for the physics task
+	qboolean         failed;                    // the physics task hit a Host_Error
+	char             error[1024];
+} sv_instance_t;
+
+static sv_instance_t  sv_maininstance;
+static sv_instance_t *sv_instances[MAX_SV_INSTANCES] = {&sv_maininstance};
+static int            sv_numinstances = 1;
+static sv_instance_t *sv_rulesinstance = &sv_maininstance; // whose values the rule cvars hold
+static sv_instance_t *sv_physicsinstances[MAX_SV_INSTANCES];
+
+static THREAD_LOCAL sv_instance_t *sv_instance = &sv_maininstance;
+THREAD_LOCAL server_t             *sv_current = &sv_maininstance.server;
+THREAD_LOCAL server_static_t      *svs_current = &sv_maininstance.stat;
+
+/*
+================
+SV_SaveRules
+================
+*/
+static void SV_SaveRules (sv_instance_t *inst)
+{
+	size_t i;
+
+	for (i = 0; i < NUM_INSTANCE_RULES; i++)
+	{
+		if (inst->rules[i] && !strcmp (inst->rules[i], sv_instancerules[i]->string))
+			continue;
+		Mem_Free (inst->rules[i]);
+		inst->rules[i] = q_strdup (sv_instancerules[i]->string);
+	}
+}
+
+/*
+================
+SV_RestoreRules
+
+Callbacks are skipped, clients must not be told about rules changing when we switch instances
+================
+*/
+static void SV_RestoreRules (sv_instance_t *inst)
+{
+	cvarcallback_t callback;
+	size_t         i;
+
+	for (i = 0; i < NUM_INSTANCE_RULES; i++)
+	{
+		if (!inst->rules[i])
+			continue;
+		callback = sv_instancerules[i]->callback;
+		sv_instancerules[i]->callback = NULL;
+		Cvar_SetQuick (sv_instancerules[i], inst->rules[i]);
+		sv_instancerules[i]->callback = callback;
+	}
+}
+
+/*
+================
+SV_SwapRules
+================
+*/
+static void SV_SwapRules (sv_instance_t *inst)
+{
+	if (inst == sv_rulesinstance)
+		return;
+	SV_SaveRules (sv_rulesinstance);
+	SV_RestoreRules (inst);
+	sv_rulesinstance = inst;
+}
+
+/*
+================
+SV_SwitchTo
+
+Makes sv, svs, the listening sockets and the rule cvars those of inst
+================
+*/
+static void SV_SwitchTo (sv_instance_t *inst)
+{
+	sv_instance_t *old = sv_instance;
+
+	if (inst == old)
+		return;
+	if (qcvm)
+		Sys_Error ("SV_SwitchTo: a qcvm is active");
+
+	old->activeconnections = net_activeconnections;
+	old->port = net_hostport;
+	if (old->listen)
+		NET_SwapListenSet (old->listen);
+
+	sv_instance = inst;
+	sv_current = &inst->server;
+	svs_current = &inst->stat;
+
+	if (inst->listen)
+		NET_SwapListenSet (inst->listen);
+	net_activeconnections = inst->activeconnections;
+	net_hostport = inst->port;
+	SV_SwapRules (inst);
+	Mod_SetOwner (inst->slot);
+}
+
+/*
+================
+SV_FindInstance
+================
+*/
+static sv_instance_t *SV_FindInstance (const char *name)
+{
+	int i;
+
+	for (i = 0; i < sv_numinstances; i++)
+	{
+		if (!q_strcasecmp (sv_instances[i]->name, name))
+			return sv_instances[i];
+	}
+	return NULL;
+}
+
+/*
+================
+SV_ExecuteInstanceText
+
+Runs ; and newline separated commands, like the command buffer does
+================
+*/
+static void SV_ExecuteInstanceText (const char *text)
+{
+	char   line[1024];
+	int    i, quotes;
+	size_t len;
+
+	while (*text)
+	{
+		quotes = 0;
+		for (i = 0; text[i]; i++)
+		{
+			if (text[i] == '"')
+				quotes++;
+			if (!(quotes & 1) && text[i] == ';')
+				break;
+			if (text[i] == '\n')
+				break;
+		}
+
+		len = q_min ((size_t)i, sizeof (line) - 1);
+		memcpy (line, text, len);
+		line[len] = 0;
+
+		text += i;
+		if (*text)
+			text++;
+
+		Cmd_ExecuteString (line, src_command);
+	}
+}
+
+/*
+================
+SV_CloseInstance
+================
+*/
+static void SV_CloseInstance (sv_instance_t *inst)
+{
+	size_t i;
+	int    j;
+
+	SV_SwitchTo (inst);
+	Host_ShutdownServer (false);
+	Host_ClearMemory ();
+	SV_SwitchTo (&sv_maininstance);
+
+	NET_CloseListenSet (inst->listen);
+	Mem_Free (inst->stat.clients);
+	for (i = 0; i < NUM_INSTANCE_RULES; i++)
+		Mem_Free (inst->rules[i]);
+	Mem_Free (inst->cmdtext);
+
+	for (j = 0; j < sv_numinstances; j++)
+	{
+		if (sv_instances[j] == inst)
+		{
+			memmove (&sv_instances[j], &sv_instances[j + 1], (sv_numinstances - j - 1) * sizeof (sv_instances[0]));
+			sv_numinstances--;
+			break;
+		}
+	}
+	Mem_Free (inst);
+}
+
+/*
+================
+SV_Instance_Create_f
+================
+*/
+static void SV_Instance_Create_f (void)
+{
+	sv_instance_t   *inst;
+	net_listenset_t *listen;
+	const char      *name;
+	int              port, maxclients, slot, i;
+
+	if (Cmd_Argc () < 3)
+	{
+		Con_Printf ("usage: sv_instance_create <name> <port> [maxplayers]\n");
+		return;
+	}
+	if (!isDedicated)
+	{
+		Con_Printf ("server instances are only available on dedicated servers\n");
+		return;
+	}
+	if (sv_instance != &sv_maininstance)
+	{
+		Con_Printf ("sv_instance_create: only the main instance can create instances\n");
+		return;
+	}
+
+	name = Cmd_Argv (1);
+	if (strlen (name) >= sizeof (inst->name) || SV_FindInstance (name))
+	{
+		Con_Printf ("sv_instance_create: bad or duplicate name \"%s\"\n", name);
+		return;
+	}
+	if (sv_numinstances == MAX_SV_INSTANCES)
+	{
+		Con_Printf ("sv_instance_create: too many instances (max = %d)\n", MAX_SV_INSTANCES);
+		return;
+	}
+
+	port = atoi (Cmd_Argv (2));
+	if (port <= 0 || port >= 65536 || port == net_hostport)
+	{
+		Con_Printf ("sv_instance_create: bad port %s\n", Cmd_Argv (2));
+		return;
+	}
+	for (i = 1; i < sv_numinstances; i++)
+	{
+		if (sv_instances[i]->port == port)
+		{
+			Con_Printf ("sv_instance_create: port %d is used by \"%s\"\n", port, sv_instances[i]->name);
+			return;
+		}
+	}
+
+	// the main instance has slot 0, a closed instance leaves its slot to the next one
+	for (slot = 1; slot < MAX_SV_INSTANCES; slot++)
+	{
+		for (i = 1; i < sv_numinstances; i++)
+			if (sv_instances[i]->slot == slot)
+				break;
+		if (i == sv_numinstances)
+			break;
+	}
+
+	maxclients = (Cmd_Argc () > 3) ? atoi (Cmd_Argv (3)) : svs.maxclients;
+	maxclients = CLAMP (1, maxclients, MAX_SCOREBOARD);
+
+	listen = NET_OpenListenSet (port);
+	if (!listen)
+	{
+		Con_Printf ("sv_instance_create: couldn't listen on port %d\n", port);
+		return;
+	}
+
+	inst = (sv_instance_t *)Mem_Alloc (sizeof (sv_instance_t));
+	q_strlcpy (inst->name, name, sizeof (inst->name));
+	inst->listen = listen;
+	inst->port = port;
+	inst->slot = slot;
+	inst->stat.maxclients = inst->stat.maxclientslimit = maxclients;
+	inst->stat.clients = (struct client_s *)Mem_Alloc (maxclients * sizeof (client_t));
+	SV_SaveRules (inst); // start out with the rules of the main instance
+	NET_AllocQSockets (maxclients);
+
+	sv_instances[sv_numinstances++] = inst;
+	Con_Printf ("server instance \"%s\" listening on port %d, %d players\n", inst->name, port, maxclients);
+}
+
+/*
+================
+SV_Instance_Exec_f
+================
+*/
+static void SV_Instance_Exec_f (void)
+{
+	sv_instance_t *inst, *prev = sv_instance;
+	const char    *args;
+
+	if (Cmd_Argc () < 3)
+	{
+		Con_Printf ("usage: sv_instance_exec <name> <commands>\n");
+		return;
+	}
+
+	inst = SV_FindInstance (Cmd_Argv (1));
+	if (!inst)
+	{
+		Con_Printf ("sv_instance_exec: no instance \"%s\"\n", Cmd_Argv (1));
+		return;
+	}
+
+	args = COM_Parse (Cmd_Args ()); // skip the name
+	if (!args)
+		return;
+
+	SV_SwitchTo (inst);
+	SV_ExecuteInstanceText (args);
+	SV_SwitchTo (prev);
+}
+
+/*
+================
+SV_Instance_Close_f
+================
+*/
+static void SV_Instance_Close_f (void)
+{
+	sv_instance_t *inst;
+
+	if (Cmd_Argc () != 2)
+	{
+		Con_Printf ("usage: sv_instance_close <name>\n");
+		return;
+	}
+	if (sv_instance != &sv_maininstance)
+	{
+		Con_Printf ("sv_instance_close: only the main instance can close instances\n");
+		return;
+	}
+
+	inst = SV_FindInstance (Cmd_Argv (1));
+	if (!inst || inst == &sv_maininstance)
+	{
+		Con_Printf ("sv_instance_close: no instance \"%s\"\n", Cmd_Argv (1));
+		return;
+	}
+	SV_CloseInstance (inst);
+}
+
+/*
+================
+SV_Instances_f
+================
+*/
+static void SV_Instances_f (void)
+{
+	sv_instance_t *inst;
+	int            i, j, players;
+
+	Con_Printf ("name             port  map              players\n");
+	for (i = 0; i < sv_numinstances; i++)
+	{
+		inst = sv_instances[i];
+		for (j = 0, players = 0; j < inst->stat.maxclients; j++)
+		{
+			if (inst->stat.clients[j].active)
+				players++;
+		}
+		Con_Printf (
+			"%-16s %5d %-16s %d/%d\n", inst->name, (inst == sv_instance) ? net_hostport : inst->port, inst->server.active ? inst->server.name : "-", players,
+			inst->stat.maxclients);
+	}
+}
+
+/*
+================
+SV_Instance_Init
+================
+*/
+void SV_Instance_Init (void)
+{
+	q_strlcpy (sv_maininstance.name, "main", sizeof (sv_maininstance.name));
+
+	Cmd_AddCommand ("sv_instance_create", SV_Instance_Create_f);
+	Cmd_AddCommand ("sv_instance_exec", SV_Instance_Exec_f);
+	Cmd_AddCommand ("sv_instance_close", SV_Instance_Close_f);
+	Cmd_AddCommand ("sv_instances", SV_Instances_f);
+}
+
+/*
+================
+SV_NumInstances
+================
+*/
+int SV_NumInstances (void)
+{
+	return sv_numinstances;
+}
+
+/*
+================
+SV_ResetInstance
+
+Goes back to the main instance, after a Host_Error
+================
+*/
+void SV_ResetInstance (void)
+{
+	PR_SwitchQCVM (NULL);
+	SV_SwitchTo (&sv_maininstance);
+}
+
+/*
+================
+SV_InstanceTaskLocked
+
+Gives the rule cvars to the instance of this thread, for a builtin that is run with
+the builtin lock held (cvar, cvar_set, aim...)
+================
+*/
+static void SV_InstanceTaskLocked (void)
+{
+	SV_SwapRules (sv_instance);
+}
+
+/*
+================
+SV_InstancePhysics
+================
+*/
+static void SV_InstancePhysics (void *arg)
+{
+	sv_instance_t *inst = (sv_instance_t *)arg;
+
+	sv_instance = inst;
+	sv_current = &inst->server;
+	svs_current = &inst->stat;
+	sv_player = inst->player;
+	Mod_SetOwner (inst->slot);
+
+	PR_SwitchQCVM (&sv.qcvm);
+	qcvm->ontask = true;
+	qcvm->tasklocked = SV_InstanceTaskLocked;
+	SV_Physics ();
+	qcvm->ontask = false;
+	PR_SwitchQCVM (NULL);
+}
+
+/*
+================
+SV_InstancePhysicsTask
+
+A Task_Join that helps can run this on a thread that is switched to another instance
+================
+*/
+static void SV_InstancePhysicsTask (int index, void *unused)
+{
+	sv_instance_t   *inst = sv_physicsinstances[index];
+	sv_instance_t   *prev = sv_instance;
+	server_t        *prevsv = sv_current;
+	server_static_t *prevsvs = svs_current;
+	edict_t         *prevplayer = sv_player;
+
+	inst->failed = !Host_RunTask (SV_InstancePhysics, inst, inst->error, sizeof (inst->error));
+	inst->server.qcvm.ontask = false;
+
+	sv_instance = prev;
+	sv_current = prevsv;
+	svs_current = prevsvs;
+	sv_player = prevplayer;
+	Mod_SetOwner (prev->slot);
+}
+
+/*
+================
+SV_RunInstances
+
+Runs a server frame for every instance, Host_ServerFrame split in three: the clients
+of each instance are run on the main thread, then the physics of all of them on tasks,
+then the main thread sends their messages. The instances share nothing the physics
+touches but the builtins that take the builtin lock.
+================
+*/
+void SV_RunInstances (void)
+{
+	sv_instance_t *inst;
+	char          *text;
+	int            i, numphysics = 0;
+
+	for (i = 0; i < sv_numinstances; i++)
+	{
+		inst = sv_instances[i];
+		SV_SwitchTo (inst);
+
+		if (inst->cmdtext)
+		{
+			text = inst->cmdtext;
+			inst->cmdtext = NULL;
+			SV_ExecuteInstanceText (text);
+			Mem_Free (text);
+		}
+
+		if (!sv.active)
+			continue;
+
+		PR_SwitchQCVM (&sv.qcvm);
+		pr_global_struct->frametime = host_frametime;
+		SV_ClearDatagram ();
+		SV_CheckForNewClients ();
+		SV_RunClients ();
+		PR_SwitchQCVM (NULL);
+
+		inst->player = sv_player;
+		// always pause in single player if in console or menus
+		if (!sv.paused && (svs.maxclients > 1 || key_dest == key_game))
+			sv_physicsinstances[numphysics++] = inst;
+	}
+
+	if (numphysics > 0)
+	{
+		task_handle_t task =
+			Task_AllocateAssignIndexedFuncAndSubmit ("SV_Physics", (task_indexed_func_t)SV_InstancePhysicsTask, numphysics, NULL, 0);
+		Task_Join (task, SDL_MUTEX_MAXWAIT);
+		SV_SwapRules (sv_instance); // the locked builtins may have left them to another instance
+	}
+
+	for (i = 0; i < sv_numinstances; i++)
+	{
+		inst = sv_instances[i];
+		SV_SwitchTo (inst);
+
+		if (inst->failed)
+		{ // what Host_Error does, but for this instance only
+			inst->failed = false;
+			Con_Printf ("Host_Error: %s\n", inst->error);
+			Host_ShutdownServer (false);
+			continue;
+		}
+
+		if (sv.active)
+		{
+			PR_SwitchQCVM (&sv.qcvm);
+			SV_SendClientMessages ();
+			PR_SwitchQCVM (NULL);
+		}
+	}
+	SV_SwitchTo (&sv_maininstance);
+}
+
+/*
+================
+SV_ShutdownInstances
+================
+*/
+void SV_ShutdownInstances (void)
+{
+	SV_ResetInstance ();
+	while (sv_numinstances > 1)
+		SV_CloseInstance (sv_instances[sv_numinstances - 1]);
+}
+
+/*
+================
+SV_InstanceCommand
+
+Cbuf_AddText for the running instance. The command buffer belongs to the
+main instance, the others get their commands at the start of their next frame.
+================
+*/
+void SV_InstanceCommand (const char *text)
+{
+	size_t len, textlen;
+
+	if (sv_instance == &sv_maininstance)
+	{
+		Cbuf_AddText (text);
+		return;
+	}
+
+	len = sv_instance->cmdtext ? strlen (sv_instance->cmdtext) : 0;
+	textlen = strlen (text);
+	sv_instance->cmdtext = (char *)Mem_Realloc (sv_instance->cmdtext, len + textlen + 1);
+	memcpy (sv_instance->cmdtext + len, text, textlen + 1);
+}
@@ -24,9 +24,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 
-server_t        sv;
-server_static_t svs;
-
 static char localmodels[MAX_MODELS][8]; // inline model names for precache
 
 int sv_protocol = PROTOCOL_RMQ; // spike -- enough maps need this now that we can probably afford incompatibility with engines that still don't support 999
@@ -1115,6 +1112,7 @@ void SV_Init (void)
 
 	Cmd_AddCommand ("pext", SV_Pext_f);
 	Cmd_AddCommand ("sv_protocol", &SV_Protocol_f); // johnfitz
+	SV_Instance_Init ();
 
 	for (i = 0; i < MAX_MODELS; i++)
 		sprintf (localmodels[i], "*%i", i);
@@ -2626,6 +2624,7 @@ void SV_SendClientMessages (void)
 	}
 
 	// build individual updates
+	NET_BeginSendBatch ();
 	for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
 	{
 		if (!host_client->active)
@@ -2741,6 +2740,7 @@ void SV_SendClientMessages (void)
 			}
 		}
 	}
+	NET_FlushSendBatch ();
 
 	// clear muzzle flashes
 	SV_CleanupEnts ();
@@ -2891,6 +2891,48 @@ qmodel_t *SV_ModelForIndex (int index)
 	return sv.models[index];
 }
 
+/*
+================
+SV_ModelForName
+
+Like Mod_ForName, but inline models (*1, *2, ...) come from the world of this
+server. The shared *n entries of the model cache belong to whichever map was
+loaded last, which need not be ours when several server instances are running.
+================
+*/
+qmodel_t *SV_ModelForName (const char *name, qboolean crash)
+{
+	int i;
+
+	if (name[0] == '*' && qcvm->worldmodel)
+	{
+		i = atoi (name + 1);
+		if (i > 0 && i < qcvm->worldmodel->numsubmodels)
+			return &qcvm->worldmodel->inlinemodels[i - 1];
+	}
+	return Mod_ForName (name, crash);
+}
+
+/*
+================
+SV_ModelsForNames
+
+Mod_ForNames for a server precache list, the inline models are then taken
+from the world of this server like SV_ModelForName does
+================
+*/
+void SV_ModelsForNames (const char **names, qmodel_t **models, int count, qboolean crash)
+{
+	int i;
+
+	Mod_ForNames (names, models, count, crash);
+	for (i = 0; i < count; i++)
+	{
+		if (names[i][0] == '*')
+			models[i] = SV_ModelForName (names[i], crash);
+	}
+}
+
 /*
 ================
 SV_SpawnServer
@@ -2965,7 +3007,7 @@ void         SV_SpawnServer (const char *server)
 	// allocate server memory
 	/* Host_ClearMemory() called above already cleared the whole sv structure */
 	qcvm->max_edicts = CLAMP (MIN_EDICTS, (int)max_edicts.value, MAX_EDICTS);  // johnfitz -- max_edicts cvar
-	qcvm->edicts = (edict_t *)Mem_Alloc (qcvm->max_edicts * qcvm->edict_size); // ericw -- sv.edicts switched to use malloc()
+	qcvm->edicts = (edict_t *)Mem_AllocTagged (qcvm->max_edicts * qcvm->edict_size, MEMTAG_EDICT); // ericw -- sv.edicts switched to use malloc()
 
 	sv.datagram.maxsize = sizeof (sv.datagram_buf);
 	sv.datagram.cursize = 0;
@@ -3026,7 +3068,7 @@ void         SV_SpawnServer (const char *server)
 	for (i = 1; i < qcvm->worldmodel->numsubmodels; i++)
 	{
 		sv.model_precache[1 + i] = localmodels[i];
-		sv.models[i + 1] = Mod_ForName (localmodels[i], false);
+		sv.models[i + 1] = &qcvm->worldmodel->inlinemodels[i - 1];
 	}
 
 	//
@@ -23,7 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 
-edict_t *sv_player;
+THREAD_LOCAL edict_t *sv_player;
 
 extern cvar_t sv_friction;
 cvar_t        sv_edgefriction = {"edgefriction", "2", CVAR_NONE};
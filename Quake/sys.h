@@ -40,6 +40,10 @@ void Sys_FileSeek (int handle, int position);
 int  Sys_FileRead (int handle, void *dest, int count);
 int  Sys_FileWrite (int handle, const void *data, int count);
 int  Sys_FileTime (const char *path);
+
+// maps a file opened with Sys_FileOpenRead read-only, returns NULL if it can't be mapped
+const void *Sys_FileMap (int handle, size_t *size);
+void        Sys_FileUnmap (const void *base, size_t size);
 void Sys_mkdir (const char *path);
 
 //
@@ -31,6 +31,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <libgen.h> /* dirname() and basename() */
 #endif
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <fcntl.h>
 #include <time.h>
@@ -135,6 +136,27 @@ int Sys_FileWrite (int handle, const void *data, int count)
 	return fwrite (data, 1, count, sys_handles[handle]);
 }
 
+const void *Sys_FileMap (int handle, size_t *size)
+{
+	struct stat st;
+	const int   fd = fileno (sys_handles[handle]);
+
+	if (fstat (fd, &st) != 0 || st.st_size <= 0)
+		return NULL;
+
+	void *base = mmap (NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (base == MAP_FAILED)
+		return NULL;
+
+	*size = (size_t)st.st_size;
+	return base;
+}
+
+void Sys_FileUnmap (const void *base, size_t size)
+{
+	munmap ((void *)base, size);
+}
+
 int Sys_FileTime (const char *path)
 {
 	FILE *f;
@@ -380,6 +402,9 @@ void Sys_Error (const char *error, ...)
 	q_vsnprintf (text, sizeof (text), error, argptr);
 	va_end (argptr);
 
+	// get the queued console text out before the error
+	LOG_Flush ();
+
 	fputs (errortxt1, stderr);
 	Host_Shutdown ();
 	fputs (errortxt2, stderr);
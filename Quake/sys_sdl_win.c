@@ -127,6 +127,33 @@ int Sys_FileWrite (int handle, const void *data, int count)
 	return fwrite (data, 1, count, sys_handles[handle]);
 }
 
+const void *Sys_FileMap (int handle, size_t *size)
+{
+	HANDLE        file = (HANDLE)_get_osfhandle (_fileno (sys_handles[handle]));
+	LARGE_INTEGER file_size;
+
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx (file, &file_size) || file_size.QuadPart <= 0)
+		return NULL;
+
+	HANDLE mapping = CreateFileMapping (file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping)
+		return NULL;
+
+	// the view keeps the mapping object alive
+	const void *base = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle (mapping);
+	if (!base)
+		return NULL;
+
+	*size = (size_t)file_size.QuadPart;
+	return base;
+}
+
+void Sys_FileUnmap (const void *base, size_t size)
+{
+	UnmapViewOfFile (base);
+}
+
 int Sys_FileTime (const char *path)
 {
 	FILE *f;
@@ -270,6 +297,9 @@ void Sys_Error (const char *error, ...)
 	q_vsnprintf (text, sizeof (text), error, argptr);
 	va_end (argptr);
 
+	// get the queued console text out before the error
+	LOG_Flush ();
+
 	PR_SwitchQCVM (NULL);
 
 	if (isDedicated)
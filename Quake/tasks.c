@@ -40,71 +40,155 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 	} while (false)
 #endif
 
-#define NUM_INDEX_BITS       8
-#define MAX_PENDING_TASKS    (1u << NUM_INDEX_BITS)
-#define MAX_EXECUTABLE_TASKS 256
-#define MAX_DEPENDENT_TASKS  16
-#define MAX_PAYLOAD_SIZE     32
-#define MAX_WORKERS          32
-#define WORKER_HUNK_SIZE     (1 * 1024 * 1024)
-#define WAIT_SPIN_COUNT      100
+#define NUM_INDEX_BITS      20
+#define MAX_PENDING_TASKS   (1u << NUM_INDEX_BITS)
+#define TASK_BLOCK_BITS     8
+#define TASK_BLOCK_SIZE     (1u << TASK_BLOCK_BITS)
+#define MAX_TASK_BLOCKS     (MAX_PENDING_TASKS / TASK_BLOCK_SIZE)
+#define INLINE_PAYLOAD_SIZE 32
+#define MAX_WORKERS         32
+#define DEQUE_CAPACITY      1024
+#define WORKER_HUNK_SIZE    (1 * 1024 * 1024)
+#define WAIT_SPIN_COUNT     100
+#define HELP_WAIT_MS        1
+#define RANGES_PER_WORKER   4
+#define TRACE_MAX_EVENTS    16384
+#define TRACE_MAX_ZONES     16
 
-COMPILE_TIME_ASSERT (tasks, MAX_PENDING_TASKS >= MAX_EXECUTABLE_TASKS);
+COMPILE_TIME_ASSERT (tasks, (DEQUE_CAPACITY & (DEQUE_CAPACITY - 1)) == 0);
 
 typedef enum
 {
 	TASK_TYPE_NONE,
 	TASK_TYPE_SCALAR,
 	TASK_TYPE_INDEXED,
+	TASK_TYPE_RANGED,
 } task_type_t;
 
+typedef enum
+{
+	SCHEDULER_WORK_STEALING,
+	SCHEDULER_SHARED_QUEUE, // single queue and blocking joins, only used by tasks_benchmark's own tasks for comparison
+} scheduler_mode_t;
+
+typedef enum
+{
+	TRACE_FLAG_ZONE = 1 << 0,
+	TRACE_FLAG_STOLEN = 1 << 1,
+	TRACE_FLAG_HELPED = 1 << 2,
+} trace_flags_t;
+
+typedef struct
+{
+	atomic_uint32_t index;
+	uint32_t        limit;
+} task_counter_t;
+
 typedef struct
 {
-	task_type_t     task_type;
-	int             num_dependents;
-	int             indexed_limit;
-	atomic_uint32_t remaining_workers;
-	atomic_uint32_t remaining_dependencies;
-	uint64_t        epoch;
-	void           *func;
-	SDL_mutex      *epoch_mutex;
-	SDL_cond       *epoch_condition;
-	uint8_t         payload[MAX_PAYLOAD_SIZE];
-	task_handle_t   dependent_task_handles[MAX_DEPENDENT_TASKS];
+	task_type_t      task_type;
+	scheduler_mode_t scheduler_mode;
+	qboolean         worker_only;
+	int              num_dependents;
+	int              max_dependents;
+	uint32_t         indexed_limit;
+	uint32_t         grain_size;
+	atomic_uint32_t  remaining_workers;
+	atomic_uint32_t  remaining_dependencies;
+	atomic_uint32_t  next_free;
+	atomic_uint64_t  epoch;
+	void            *func;
+	const char      *name;
+	uint64_t         ready_ticks;
+	void            *payload;
+	size_t           heap_payload_size;
+	void            *heap_payload;
+	task_counter_t  *indexed_counters;
+	task_handle_t   *dependent_task_handles;
+	SDL_mutex       *epoch_mutex;
+	SDL_cond        *epoch_condition;
+	uint64_t         inline_payload[INLINE_PAYLOAD_SIZE / sizeof (uint64_t)];
 } task_t;
 
+// Chase-Lev work-stealing deque, the owning worker pushes and pops at the bottom, everybody else steals from the top
+typedef struct
+{
+	atomic_uint64_t top;
+	uint8_t         pad[64 - sizeof (atomic_uint64_t)];
+	atomic_uint64_t bottom;
+	atomic_uint32_t task_indices[DEQUE_CAPACITY];
+} task_deque_t;
+
+// Tasks submitted from threads that don't own a deque
 typedef struct
 {
-	uint32_t        capacity_mask;
-	atomic_uint64_t state;
-	SDL_sem        *push_semaphore;
-	SDL_sem        *pop_semaphore;
-	atomic_uint32_t task_indices[1];
+	SDL_mutex      *mutex;
+	uint32_t        capacity;
+	uint32_t        head;
+	atomic_uint32_t count;
+	uint32_t       *task_indices;
 } task_queue_t;
 
 typedef struct
 {
-	atomic_uint32_t index;
-	uint32_t        limit;
-} task_counter_t;
+	const char *name;
+	uint64_t    begin_ticks;
+	uint64_t    end_ticks;
+	uint64_t    ready_ticks;
+	uint32_t    flags;
+} trace_event_t;
+
+typedef struct
+{
+	const char *name;
+	uint64_t    begin_ticks;
+} trace_zone_t;
+
+// Only ever appended to by its own thread, a new capture generation makes the owner start over
+typedef struct
+{
+	atomic_uint32_t generation;
+	atomic_uint32_t num_events;
+	atomic_uint32_t num_dropped;
+	trace_event_t   events[TRACE_MAX_EVENTS];
+} trace_buffer_t;
 
 static int                   num_workers = 0;
 static SDL_Thread          **worker_threads;
-static task_t                tasks[MAX_PENDING_TASKS];
-static task_queue_t         *free_task_queue;
-static task_queue_t         *executable_task_queue;
-static task_counter_t       *indexed_task_counters;
+static task_t               *task_blocks[MAX_TASK_BLOCKS];
+static uint32_t              num_task_blocks;
+static SDL_mutex            *task_blocks_mutex;
+static atomic_uint64_t       free_task_head; // ABA tag in the upper 32 bits, index + 1 in the lower 32 bits
+static task_deque_t         *worker_deques;
+static task_queue_t          injection_queue;
+static task_queue_t          worker_only_queue; // see Task_SetWorkerOnly
+static SDL_sem              *wake_semaphore;
+static atomic_uint32_t       num_sleeping_workers;
 static uint8_t               steal_worker_indices[MAX_WORKERS * 2];
 static THREAD_LOCAL qboolean is_worker = false;
+static THREAD_LOCAL int      worker_index = -1;
+
+static THREAD_LOCAL scheduler_mode_t allocation_mode = SCHEDULER_WORK_STEALING; // given to the tasks this thread allocates
+
+static trace_buffer_t           *trace_buffers[MAX_WORKERS + 1]; // workers, then the main thread
+static atomic_uint32_t           trace_active;
+static atomic_uint32_t           trace_generation;
+static int                       trace_frames_pending;
+static int                       trace_frames_remaining;
+static uint64_t                  trace_start_ticks;
+static char                      trace_filename[MAX_OSPATH];
+static THREAD_LOCAL int          trace_thread_index = -1;
+static THREAD_LOCAL int          trace_zone_depth;
+static THREAD_LOCAL trace_zone_t trace_zones[TRACE_MAX_ZONES];
 
 /*
 ====================
-IndexedTaskCounterIndex
+GetTask
 ====================
 */
-static inline int IndexedTaskCounterIndex (int task_index, int worker_index)
+static inline task_t *GetTask (uint32_t task_index)
 {
-	return (MAX_PENDING_TASKS * worker_index) + task_index;
+	return &task_blocks[task_index >> TASK_BLOCK_BITS][task_index & (TASK_BLOCK_SIZE - 1)];
 }
 
 /*
@@ -132,82 +216,230 @@ static inline uint64_t EpochFromTaskHandle (task_handle_t handle)
 CreateTaskHandle
 ====================
 */
-static inline task_handle_t CreateTaskHandle (uint32_t index, int epoch)
+static inline task_handle_t CreateTaskHandle (uint32_t index, uint64_t epoch)
 {
 	return (task_handle_t)index | ((task_handle_t)epoch << NUM_INDEX_BITS);
 }
 
 /*
 ====================
-SpinWaitSemaphore
+SpinPause
 ====================
 */
-static inline void SpinWaitSemaphore (SDL_sem *semaphore)
+static inline void SpinPause (void)
 {
-	int remaining_spins = WAIT_SPIN_COUNT;
-	int result = 0;
-	while ((result = SDL_SemTryWait (semaphore)) != 0)
-	{
 #ifdef USE_SSE2
-		// Don't have to actually check for SSE2 support, the
-		// instruction is backwards compatible and executes as a NOP
-		_mm_pause ();
+	// Don't have to actually check for SSE2 support, the
+	// instruction is backwards compatible and executes as a NOP
+	_mm_pause ();
 #endif
-		if (--remaining_spins == 0)
+}
+
+/*
+====================
+Trace_AddEvent
+====================
+*/
+static void Trace_AddEvent (const char *name, uint64_t begin_ticks, uint64_t end_ticks, uint64_t ready_ticks, uint32_t flags)
+{
+	if (trace_thread_index < 0)
+		return;
+	trace_buffer_t *buffer = trace_buffers[trace_thread_index];
+	const uint32_t  generation = Atomic_LoadUInt32 (&trace_generation);
+	if (Atomic_LoadUInt32 (&buffer->generation) != generation)
+	{
+		Atomic_StoreUInt32 (&buffer->num_events, 0);
+		Atomic_StoreUInt32 (&buffer->num_dropped, 0);
+		Atomic_StoreUInt32 (&buffer->generation, generation);
+	}
+	const uint32_t num_events = Atomic_LoadUInt32 (&buffer->num_events);
+	if (num_events == TRACE_MAX_EVENTS)
+	{
+		Atomic_IncrementUInt32 (&buffer->num_dropped);
+		return;
+	}
+	trace_event_t *event = &buffer->events[num_events];
+	event->name = name ? name : "unnamed";
+	event->begin_ticks = begin_ticks;
+	event->end_ticks = end_ticks;
+	event->ready_ticks = ready_ticks;
+	event->flags = flags;
+	Atomic_StoreUInt32 (&buffer->num_events, num_events + 1);
+}
+
+/*
+====================
+FreeTaskPush
+====================
+*/
+static void FreeTaskPush (uint32_t task_index)
+{
+	task_t  *task = GetTask (task_index);
+	uint64_t head = Atomic_LoadUInt64 (&free_task_head);
+	do
+	{
+		Atomic_StoreUInt32 (&task->next_free, (uint32_t)head);
+	} while (!Atomic_CompareExchangeUInt64 (&free_task_head, &head, (((head >> 32) + 1) << 32) | (task_index + 1)));
+}
+
+/*
+====================
+FreeTaskPop
+====================
+*/
+static qboolean FreeTaskPop (uint32_t *task_index)
+{
+	uint64_t head = Atomic_LoadUInt64 (&free_task_head);
+	while ((uint32_t)head != 0)
+	{
+		const uint32_t index = (uint32_t)head - 1;
+		const uint32_t next = Atomic_LoadUInt32 (&GetTask (index)->next_free);
+		if (Atomic_CompareExchangeUInt64 (&free_task_head, &head, (((head >> 32) + 1) << 32) | next))
 		{
-			break;
+			*task_index = index;
+			return true;
 		}
 	}
-	if (result != 0)
-		SDL_SemWait (semaphore);
+	return false;
 }
 
 /*
 ====================
-CreateTaskQueue
+AllocateTaskBlock
+
+Grows the task arena by one block and returns one of the new records, the rest go to the free list
 ====================
 */
-static task_queue_t *CreateTaskQueue (int capacity)
+static uint32_t AllocateTaskBlock (void)
 {
-	assert (capacity > 0);
-	assert ((capacity & (capacity - 1)) == 0); // Needs to be power of 2
-	task_queue_t *queue = Mem_Alloc (sizeof (task_queue_t) + (sizeof (atomic_uint32_t) * (capacity - 1)));
-	queue->capacity_mask = capacity - 1;
-	queue->push_semaphore = SDL_CreateSemaphore (capacity - 1);
-	queue->pop_semaphore = SDL_CreateSemaphore (0);
-	return queue;
+	uint32_t task_index;
+	SDL_LockMutex (task_blocks_mutex);
+	if (FreeTaskPop (&task_index))
+	{
+		SDL_UnlockMutex (task_blocks_mutex);
+		return task_index;
+	}
+	if (num_task_blocks == MAX_TASK_BLOCKS)
+		Sys_Error ("Too many pending tasks (max = %u)", MAX_PENDING_TASKS);
+
+	task_t *block = (task_t *)Mem_Alloc (sizeof (task_t) * TASK_BLOCK_SIZE);
+	for (uint32_t i = 0; i < TASK_BLOCK_SIZE; ++i)
+	{
+		block[i].epoch_mutex = SDL_CreateMutex ();
+		block[i].epoch_condition = SDL_CreateCond ();
+		block[i].indexed_counters = (task_counter_t *)Mem_Alloc (sizeof (task_counter_t) * num_workers);
+	}
+
+	const uint32_t first_task_index = num_task_blocks << TASK_BLOCK_BITS;
+	task_blocks[num_task_blocks] = block;
+	num_task_blocks += 1;
+	for (uint32_t i = 1; i < TASK_BLOCK_SIZE; ++i)
+		FreeTaskPush (first_task_index + i);
+	SDL_UnlockMutex (task_blocks_mutex);
+
+	return first_task_index;
 }
 
 /*
 ====================
-TaskQueuePush
+DequePush
 ====================
 */
-static inline void TaskQueuePush (task_queue_t *queue, uint32_t task_index)
+static qboolean DequePush (task_deque_t *deque, uint32_t task_index)
 {
-	SpinWaitSemaphore (queue->push_semaphore);
-	uint64_t state = Atomic_LoadUInt64 (&queue->state);
-	uint64_t new_state;
-	uint32_t head;
-	qboolean cas_successful = false;
-	do
+	const uint64_t bottom = Atomic_LoadUInt64 (&deque->bottom);
+	const uint64_t top = Atomic_LoadUInt64 (&deque->top);
+	if ((bottom - top) >= DEQUE_CAPACITY)
+		return false;
+	Atomic_StoreUInt32 (&deque->task_indices[bottom & (DEQUE_CAPACITY - 1)], task_index);
+	Atomic_StoreUInt64 (&deque->bottom, bottom + 1);
+	return true;
+}
+
+/*
+====================
+DequePop
+====================
+*/
+static qboolean DequePop (task_deque_t *deque, uint32_t *task_index)
+{
+	uint64_t bottom = Atomic_LoadUInt64 (&deque->bottom);
+	uint64_t top = Atomic_LoadUInt64 (&deque->top);
+	if ((int64_t)(bottom - top) <= 0)
+		return false;
+
+	bottom -= 1;
+	Atomic_StoreUInt64 (&deque->bottom, bottom);
+	Atomic_ThreadFence ();
+	top = Atomic_LoadUInt64 (&deque->top);
+	if ((int64_t)(bottom - top) < 0)
 	{
-		head = (uint32_t)(state & queue->capacity_mask);
-		const uint32_t tail = (uint32_t)(state >> 32) & queue->capacity_mask;
-		const uint32_t next = (head + 1u) & queue->capacity_mask;
-		if ((next == tail) || (Atomic_LoadUInt32 (&queue->task_indices[head]) != 0u))
+		Atomic_StoreUInt64 (&deque->bottom, bottom + 1);
+		return false;
+	}
+
+	*task_index = Atomic_LoadUInt32 (&deque->task_indices[bottom & (DEQUE_CAPACITY - 1)]);
+	if (bottom != top)
+		return true;
+
+	// Last entry, race against thieves. Only give up if somebody else actually moved top.
+	uint64_t expected = top;
+	qboolean won = false;
+	while (!(won = Atomic_CompareExchangeUInt64 (&deque->top, &expected, top + 1)) && (expected == top))
+		;
+	Atomic_StoreUInt64 (&deque->bottom, bottom + 1);
+	return won;
+}
+
+/*
+====================
+DequeSteal
+====================
+*/
+static qboolean DequeSteal (task_deque_t *deque, uint32_t *task_index)
+{
+	uint64_t top = Atomic_LoadUInt64 (&deque->top);
+	while (true)
+	{
+		Atomic_ThreadFence ();
+		const uint64_t bottom = Atomic_LoadUInt64 (&deque->bottom);
+		if ((int64_t)(bottom - top) <= 0)
+			return false;
+		const uint32_t index = Atomic_LoadUInt32 (&deque->task_indices[top & (DEQUE_CAPACITY - 1)]);
+		if (Atomic_CompareExchangeUInt64 (&deque->top, &top, top + 1))
 		{
-			state = Atomic_LoadUInt64 (&queue->state);
-			continue;
+			*task_index = index;
+			return true;
 		}
-		// avoid overflow
-		new_state = (state & (~0x80000000ull)) + 1;
-		cas_successful = Atomic_CompareExchangeUInt64 (&queue->state, &state, new_state);
-	} while (!cas_successful);
+	}
+}
 
-	ANNOTATE_HAPPENS_BEFORE (&queue->task_indices[head]);
-	Atomic_StoreUInt32 (&queue->task_indices[head], task_index + 1u);
-	SDL_SemPost (queue->pop_semaphore);
+/*
+====================
+TaskQueuePush
+====================
+*/
+static void TaskQueuePush (task_queue_t *queue, uint32_t task_index, uint32_t count)
+{
+	SDL_LockMutex (queue->mutex);
+	const uint32_t queue_count = Atomic_LoadUInt32 (&queue->count);
+	if ((queue_count + count) > queue->capacity)
+	{
+		uint32_t new_capacity = q_max (queue->capacity * 2, 256u);
+		while (new_capacity < (queue_count + count))
+			new_capacity *= 2;
+		uint32_t *new_indices = (uint32_t *)Mem_Alloc (sizeof (uint32_t) * new_capacity);
+		for (uint32_t i = 0; i < queue_count; ++i)
+			new_indices[i] = queue->task_indices[(queue->head + i) & (queue->capacity - 1)];
+		Mem_Free (queue->task_indices);
+		queue->task_indices = new_indices;
+		queue->capacity = new_capacity;
+		queue->head = 0;
+	}
+	for (uint32_t i = 0; i < count; ++i)
+		queue->task_indices[(queue->head + queue_count + i) & (queue->capacity - 1)] = task_index;
+	Atomic_AddUInt32 (&queue->count, count);
+	SDL_UnlockMutex (queue->mutex);
 }
 
 /*
@@ -215,33 +447,93 @@ static inline void TaskQueuePush (task_queue_t *queue, uint32_t task_index)
 TaskQueuePop
 ====================
 */
-static inline uint32_t TaskQueuePop (task_queue_t *queue)
+static qboolean TaskQueuePop (task_queue_t *queue, uint32_t *task_index)
 {
-	SpinWaitSemaphore (queue->pop_semaphore);
-	uint64_t state = Atomic_LoadUInt64 (&queue->state);
-	uint64_t new_state;
-	uint32_t tail;
-	qboolean cas_successful = false;
-	do
+	if (Atomic_LoadUInt32 (&queue->count) == 0)
+		return false;
+	SDL_LockMutex (queue->mutex);
+	if (Atomic_LoadUInt32 (&queue->count) == 0)
 	{
-		const uint32_t head = (uint32_t)(state & queue->capacity_mask);
-		tail = (uint32_t)(state >> 32) & queue->capacity_mask;
-		if ((head == tail) || (Atomic_LoadUInt32 (&queue->task_indices[tail]) == 0u))
-		{
-			state = Atomic_LoadUInt64 (&queue->state);
-			continue;
-		}
-		// avoid overflow
-		new_state = state + 0x100000000ull;
-		cas_successful = Atomic_CompareExchangeUInt64 (&queue->state, &state, new_state);
-	} while (!cas_successful);
+		SDL_UnlockMutex (queue->mutex);
+		return false;
+	}
+	*task_index = queue->task_indices[queue->head];
+	queue->head = (queue->head + 1) & (queue->capacity - 1);
+	Atomic_DecrementUInt32 (&queue->count);
+	SDL_UnlockMutex (queue->mutex);
+	return true;
+}
 
-	const uint32_t val = Atomic_LoadUInt32 (&queue->task_indices[tail]);
-	Atomic_StoreUInt32 (&queue->task_indices[tail], 0u);
-	SDL_SemPost (queue->push_semaphore);
-	ANNOTATE_HAPPENS_AFTER (&queue->task_indices[tail]);
+/*
+====================
+WakeWorkers
+====================
+*/
+static inline void WakeWorkers (uint32_t count)
+{
+	// Pairs with the increment of num_sleeping_workers in Task_Worker: either we see the
+	// sleeper or the sleeper sees the task we just pushed
+	Atomic_ThreadFence ();
+	const uint32_t num_sleeping = Atomic_LoadUInt32 (&num_sleeping_workers);
+	for (uint32_t i = 0; i < q_min (num_sleeping, count); ++i)
+		SDL_SemPost (wake_semaphore);
+}
+
+/*
+====================
+PushExecutableTask
+====================
+*/
+static void PushExecutableTask (uint32_t task_index, uint32_t count)
+{
+	task_t  *task = GetTask (task_index);
+	uint32_t remaining = count;
+	if (task->worker_only)
+	{
+		TaskQueuePush (&worker_only_queue, task_index, remaining);
+		remaining = 0;
+	}
+	else if ((worker_index >= 0) && (task->scheduler_mode == SCHEDULER_WORK_STEALING))
+	{
+		task_deque_t *deque = &worker_deques[worker_index];
+		while ((remaining > 0) && DequePush (deque, task_index))
+			--remaining;
+	}
+	if (remaining > 0)
+		TaskQueuePush (&injection_queue, task_index, remaining);
+	WakeWorkers (count);
+}
+
+/*
+====================
+FindTask
 
-	return val - 1;
+Own deque first, then tasks submitted from outside the pool, then steal from the other workers.
+Shared queue tasks never go to a deque, stealing doesn't change how they are scheduled. Worker
+only tasks are left to the workers' own loop, a thread helping in Task_Join never runs them.
+====================
+*/
+static qboolean FindTask (uint32_t *task_index, uint32_t *trace_flags, qboolean helping)
+{
+	*trace_flags = 0;
+	if ((worker_index >= 0) && DequePop (&worker_deques[worker_index], task_index))
+		return true;
+	if (TaskQueuePop (&injection_queue, task_index))
+		return true;
+	if (!helping && TaskQueuePop (&worker_only_queue, task_index))
+		return true;
+
+	const int first_victim = worker_index + 1;
+	const int num_victims = (worker_index >= 0) ? (num_workers - 1) : num_workers;
+	for (int i = 0; i < num_victims; ++i)
+	{
+		if (DequeSteal (&worker_deques[steal_worker_indices[first_victim + i]], task_index))
+		{
+			*trace_flags = TRACE_FLAG_STOLEN;
+			return true;
+		}
+	}
+	return false;
 }
 
 /*
@@ -249,13 +541,12 @@ static inline uint32_t TaskQueuePop (task_queue_t *queue)
 Task_ExecuteIndexed
 ====================
 */
-static inline void Task_ExecuteIndexed (int worker_index, task_t *task, uint32_t task_index)
+static inline void Task_ExecuteIndexed (task_t *task)
 {
+	const int first_counter = q_max (worker_index, 0);
 	for (int i = 0; i < num_workers; ++i)
 	{
-		const int       steal_worker_index = steal_worker_indices[worker_index + i];
-		int             counter_index = IndexedTaskCounterIndex (task_index, steal_worker_index);
-		task_counter_t *counter = &indexed_task_counters[counter_index];
+		task_counter_t *counter = &task->indexed_counters[steal_worker_indices[first_counter + i]];
 		uint32_t        index = 0;
 		while ((index = Atomic_IncrementUInt32 (&counter->index)) < counter->limit)
 		{
@@ -266,96 +557,149 @@ static inline void Task_ExecuteIndexed (int worker_index, task_t *task, uint32_t
 
 /*
 ====================
-Task_Worker
+Task_ExecuteRanged
+
+Same distribution as indexed tasks, but every atomic increment claims grain_size indices
 ====================
 */
-static int Task_Worker (void *data)
+static inline void Task_ExecuteRanged (task_t *task)
 {
-	is_worker = true;
-
-	const int worker_index = (intptr_t)data;
-	while (true)
+	const int      first_counter = q_max (worker_index, 0);
+	const uint32_t grain_size = task->grain_size;
+	for (int i = 0; i < num_workers; ++i)
 	{
-		uint32_t task_index = TaskQueuePop (executable_task_queue);
-		task_t  *task = &tasks[task_index];
-		ANNOTATE_HAPPENS_AFTER (task);
-
-		if (task->task_type == TASK_TYPE_SCALAR)
+		task_counter_t *counter = &task->indexed_counters[steal_worker_indices[first_counter + i]];
+		uint32_t        begin = 0;
+		while ((begin = Atomic_AddUInt32 (&counter->index, grain_size)) < counter->limit)
 		{
-			((task_func_t)task->func) (task->payload);
-		}
-		else if (task->task_type == TASK_TYPE_INDEXED)
-		{
-			Task_ExecuteIndexed (worker_index, task, task_index);
+			((task_ranged_func_t)task->func) (begin, q_min (begin + grain_size, counter->limit), task->payload);
 		}
+	}
+}
+
+/*
+====================
+Task_Execute
+====================
+*/
+static void Task_Execute (uint32_t task_index, uint32_t trace_flags)
+{
+	task_t *task = GetTask (task_index);
+	ANNOTATE_HAPPENS_AFTER (task);
+
+	const qboolean traced = Atomic_LoadUInt32 (&trace_active) != 0;
+	const uint64_t begin_ticks = traced ? SDL_GetPerformanceCounter () : 0;
+	if (task->task_type == TASK_TYPE_SCALAR)
+	{
+		((task_func_t)task->func) (task->payload);
+	}
+	else if (task->task_type == TASK_TYPE_INDEXED)
+	{
+		Task_ExecuteIndexed (task);
+	}
+	else if (task->task_type == TASK_TYPE_RANGED)
+	{
+		Task_ExecuteRanged (task);
+	}
+	if (traced)
+		Trace_AddEvent (task->name, begin_ticks, SDL_GetPerformanceCounter (), task->ready_ticks, trace_flags);
 
 #if defined(USE_HELGRIND)
-		ANNOTATE_HAPPENS_BEFORE (task);
-		qboolean indexed_task = task->task_type == TASK_TYPE_INDEXED;
-		if (indexed_task)
+	ANNOTATE_HAPPENS_BEFORE (task);
+	qboolean indexed_task = (task->task_type == TASK_TYPE_INDEXED) || (task->task_type == TASK_TYPE_RANGED);
+	if (indexed_task)
+	{
+		// Helgrind needs to know about all threads
+		// that participated in an indexed execution
+		SDL_LockMutex (task->epoch_mutex);
+		for (int i = 0; i < task->num_dependents; ++i)
 		{
-			// Helgrind needs to know about all threads
-			// that participated in an indexed execution
-			SDL_LockMutex (task->epoch_mutex);
-			for (int i = 0; i < task->num_dependents; ++i)
-			{
-				const int task_index = IndexFromTaskHandle (task->dependent_task_handles[i]);
-				task_t   *dep_task = &tasks[task_index];
-				ANNOTATE_HAPPENS_BEFORE (dep_task);
-			}
+			task_t *dep_task = GetTask (IndexFromTaskHandle (task->dependent_task_handles[i]));
+			ANNOTATE_HAPPENS_BEFORE (dep_task);
 		}
+	}
 #endif
 
-		if (Atomic_DecrementUInt32 (&task->remaining_workers) == 1)
-		{
-			SDL_LockMutex (task->epoch_mutex);
-			for (int i = 0; i < task->num_dependents; ++i)
-				Task_Submit (task->dependent_task_handles[i]);
-			task->epoch += 1;
-			SDL_CondBroadcast (task->epoch_condition);
-			SDL_UnlockMutex (task->epoch_mutex);
-			TaskQueuePush (free_task_queue, task_index);
-		}
+	if (Atomic_DecrementUInt32 (&task->remaining_workers) == 1)
+	{
+		SDL_LockMutex (task->epoch_mutex);
+		for (int i = 0; i < task->num_dependents; ++i)
+			Task_Submit (task->dependent_task_handles[i]);
+		Atomic_StoreUInt64 (&task->epoch, Atomic_LoadUInt64 (&task->epoch) + 1);
+		SDL_CondBroadcast (task->epoch_condition);
+		SDL_UnlockMutex (task->epoch_mutex);
+		FreeTaskPush (task_index);
+	}
 
 #if defined(USE_HELGRIND)
-		if (indexed_task)
-			SDL_UnlockMutex (task->epoch_mutex);
+	if (indexed_task)
+		SDL_UnlockMutex (task->epoch_mutex);
 #endif
-	}
-	return 0;
 }
 
 /*
 ====================
-Tasks_Init
+Task_Worker
 ====================
 */
-void Tasks_Init (void)
+static int Task_Worker (void *data)
 {
-	free_task_queue = CreateTaskQueue (MAX_PENDING_TASKS);
-	executable_task_queue = CreateTaskQueue (MAX_EXECUTABLE_TASKS);
+	is_worker = true;
+	worker_index = (intptr_t)data;
+	trace_thread_index = worker_index;
 
-	for (uint32_t task_index = 0; task_index < (MAX_PENDING_TASKS - 1); ++task_index)
+	while (true)
 	{
-		TaskQueuePush (free_task_queue, task_index);
-	}
+		uint32_t task_index;
+		uint32_t trace_flags;
+		qboolean found = false;
+		for (int i = 0; !found && (i < WAIT_SPIN_COUNT); ++i)
+		{
+			found = FindTask (&task_index, &trace_flags, false);
+			if (!found)
+				SpinPause ();
+		}
 
-	for (uint32_t task_index = 0; task_index < MAX_PENDING_TASKS; ++task_index)
-	{
-		tasks[task_index].epoch_mutex = SDL_CreateMutex ();
-		tasks[task_index].epoch_condition = SDL_CreateCond ();
+		if (!found)
+		{
+			// Announce ourselves before the last look so that WakeWorkers can't miss us
+			Atomic_IncrementUInt32 (&num_sleeping_workers);
+			found = FindTask (&task_index, &trace_flags, false);
+			if (!found)
+				SDL_SemWait (wake_semaphore);
+			Atomic_DecrementUInt32 (&num_sleeping_workers);
+		}
+
+		if (found)
+			Task_Execute (task_index, trace_flags);
 	}
+	return 0;
+}
 
+/*
+====================
+Tasks_Init
+====================
+*/
+void Tasks_Init (void)
+{
 	num_workers = CLAMP (1, SDL_GetCPUCount (), MAX_WORKERS);
+	trace_thread_index = num_workers;
 
-	// Fill lookup table to avoid modulo in Task_ExecuteIndexed
+	// Fill lookup table to avoid modulo in Task_ExecuteIndexed and FindTask
 	for (int i = 0; i < num_workers; ++i)
 	{
 		steal_worker_indices[i] = i;
 		steal_worker_indices[i + num_workers] = i;
 	}
 
-	indexed_task_counters = Mem_Alloc (sizeof (task_counter_t) * num_workers * MAX_PENDING_TASKS);
+	task_blocks_mutex = SDL_CreateMutex ();
+	FreeTaskPush (AllocateTaskBlock ());
+
+	injection_queue.mutex = SDL_CreateMutex ();
+	worker_only_queue.mutex = SDL_CreateMutex ();
+	wake_semaphore = SDL_CreateSemaphore (0);
+	worker_deques = (task_deque_t *)Mem_Alloc (sizeof (task_deque_t) * num_workers);
 	worker_threads = (SDL_Thread **)Mem_Alloc (sizeof (SDL_Thread *) * num_workers);
 	for (int i = 0; i < num_workers; ++i)
 	{
@@ -388,16 +732,61 @@ qboolean Tasks_IsWorker (void)
 Task_Allocate
 ====================
 */
-task_handle_t Task_Allocate (void)
+task_handle_t Task_Allocate (const char *name)
 {
-	uint32_t task_index = TaskQueuePop (free_task_queue);
-	task_t  *task = &tasks[task_index];
+	uint32_t task_index;
+	if (!FreeTaskPop (&task_index))
+		task_index = AllocateTaskBlock ();
+	task_t *task = GetTask (task_index);
 	Atomic_StoreUInt32 (&task->remaining_dependencies, 1);
 	task->task_type = TASK_TYPE_NONE;
+	task->scheduler_mode = allocation_mode;
+	task->worker_only = false;
 	task->num_dependents = 0;
 	task->indexed_limit = 0;
+	task->grain_size = 1;
 	task->func = NULL;
-	return CreateTaskHandle (task_index, task->epoch);
+	task->name = name;
+	task->payload = task->inline_payload;
+	return CreateTaskHandle (task_index, Atomic_LoadUInt64 (&task->epoch));
+}
+
+/*
+====================
+Task_SetWorkerOnly
+
+Only a worker picking it up from its own loop runs the task, never a thread that helps while it
+joins another one. For tasks that must not run nested inside whatever the joining thread was
+doing. Has to be called before the task is submitted.
+====================
+*/
+void Task_SetWorkerOnly (task_handle_t handle)
+{
+	GetTask (IndexFromTaskHandle (handle))->worker_only = true;
+}
+
+/*
+====================
+Task_AssignPayload
+====================
+*/
+static void Task_AssignPayload (task_t *task, void *payload, size_t payload_size)
+{
+	if (payload_size <= sizeof (task->inline_payload))
+		task->payload = task->inline_payload;
+	else
+	{
+		// Large payloads live in a buffer that stays with the task record and is reused
+		if (task->heap_payload_size < payload_size)
+		{
+			Mem_Free (task->heap_payload);
+			task->heap_payload = Mem_Alloc (payload_size);
+			task->heap_payload_size = payload_size;
+		}
+		task->payload = task->heap_payload;
+	}
+	if (payload)
+		memcpy (task->payload, payload, payload_size);
 }
 
 /*
@@ -407,39 +796,63 @@ Task_AssignFunc
 */
 void Task_AssignFunc (task_handle_t handle, task_func_t func, void *payload, size_t payload_size)
 {
-	assert (payload_size <= MAX_PAYLOAD_SIZE);
-	task_t *task = &tasks[IndexFromTaskHandle (handle)];
+	task_t *task = GetTask (IndexFromTaskHandle (handle));
 	task->task_type = TASK_TYPE_SCALAR;
 	task->func = (void *)func;
-	if (payload)
-		memcpy (&task->payload, payload, payload_size);
+	Task_AssignPayload (task, payload, payload_size);
 }
 
 /*
 ====================
-Task_AssignIndexedFunc
+Task_AssignCounters
 ====================
 */
-void Task_AssignIndexedFunc (task_handle_t handle, task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size)
+static void Task_AssignCounters (task_t *task, uint32_t limit)
 {
-	assert (payload_size <= MAX_PAYLOAD_SIZE);
-	uint32_t task_index = IndexFromTaskHandle (handle);
-	task_t  *task = &tasks[task_index];
-	task->task_type = TASK_TYPE_INDEXED;
-	task->func = (void *)func;
-	task->indexed_limit = limit;
 	uint32_t index = 0;
 	uint32_t count_per_worker = (limit + num_workers - 1) / num_workers;
 	for (int worker_index = 0; worker_index < num_workers; ++worker_index)
 	{
-		const int       task_counter_index = IndexedTaskCounterIndex (task_index, worker_index);
-		task_counter_t *counter = &indexed_task_counters[task_counter_index];
+		task_counter_t *counter = &task->indexed_counters[worker_index];
 		Atomic_StoreUInt32 (&counter->index, index);
 		counter->limit = q_min (index + count_per_worker, limit);
 		index += count_per_worker;
 	}
-	if (payload)
-		memcpy (&task->payload, payload, payload_size);
+}
+
+/*
+====================
+Task_AssignIndexedFunc
+====================
+*/
+void Task_AssignIndexedFunc (task_handle_t handle, task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size)
+{
+	task_t *task = GetTask (IndexFromTaskHandle (handle));
+	task->task_type = TASK_TYPE_INDEXED;
+	task->func = (void *)func;
+	task->indexed_limit = limit;
+	Task_AssignCounters (task, limit);
+	Task_AssignPayload (task, payload, payload_size);
+}
+
+/*
+====================
+Task_AssignRangedFunc
+
+A grain size of 0 picks one that gives every worker a few ranges to balance with
+====================
+*/
+void Task_AssignRangedFunc (task_handle_t handle, task_ranged_func_t func, uint32_t limit, uint32_t grain_size, void *payload, size_t payload_size)
+{
+	task_t *task = GetTask (IndexFromTaskHandle (handle));
+	task->task_type = TASK_TYPE_RANGED;
+	task->func = (void *)func;
+	task->indexed_limit = limit;
+	if (grain_size == 0)
+		grain_size = (limit + (num_workers * RANGES_PER_WORKER) - 1) / (num_workers * RANGES_PER_WORKER);
+	task->grain_size = q_max (grain_size, 1u);
+	Task_AssignCounters (task, limit);
+	Task_AssignPayload (task, payload, payload_size);
 }
 
 /*
@@ -450,25 +863,27 @@ Task_Submit
 void Task_Submit (task_handle_t handle)
 {
 	uint32_t task_index = IndexFromTaskHandle (handle);
-	task_t  *task = &tasks[task_index];
-	assert (task->epoch == EpochFromTaskHandle (handle));
+	task_t  *task = GetTask (task_index);
+	assert (Atomic_LoadUInt64 (&task->epoch) == EpochFromTaskHandle (handle));
 	ANNOTATE_HAPPENS_BEFORE (task);
 	if (Atomic_DecrementUInt32 (&task->remaining_dependencies) == 1)
 	{
-		const int num_task_workers = (task->task_type == TASK_TYPE_INDEXED) ? q_min (task->indexed_limit, num_workers) : 1;
+		uint32_t num_task_workers = 1;
+		if (task->task_type == TASK_TYPE_INDEXED)
+			num_task_workers = q_min (task->indexed_limit, (uint32_t)num_workers);
+		else if (task->task_type == TASK_TYPE_RANGED)
+			num_task_workers = q_min ((task->indexed_limit + task->grain_size - 1) / task->grain_size, (uint32_t)num_workers);
 		Atomic_StoreUInt32 (&task->remaining_workers, num_task_workers);
-		for (int i = 0; i < num_task_workers; ++i)
-		{
-			TaskQueuePush (executable_task_queue, task_index);
-		}
+		task->ready_ticks = Atomic_LoadUInt32 (&trace_active) ? SDL_GetPerformanceCounter () : 0;
+		PushExecutableTask (task_index, num_task_workers);
 	}
 }
+
 /*
 ====================
 Tasks_Submit
 ====================
 */
-
 void Tasks_Submit (int num_handles, task_handle_t *handles)
 {
 	for (int i = 0; i < num_handles; ++i)
@@ -484,19 +899,22 @@ Task_AddDependency
 */
 void Task_AddDependency (task_handle_t before, task_handle_t after)
 {
-	uint32_t  before_task_index = IndexFromTaskHandle (before);
-	task_t   *before_task = &tasks[before_task_index];
-	const int before_handle_task_epoch = EpochFromTaskHandle (before);
+	task_t        *before_task = GetTask (IndexFromTaskHandle (before));
+	const uint64_t before_handle_task_epoch = EpochFromTaskHandle (before);
 	SDL_LockMutex (before_task->epoch_mutex);
-	if (before_task->epoch != before_handle_task_epoch)
+	if (Atomic_LoadUInt64 (&before_task->epoch) != before_handle_task_epoch)
 	{
 		ANNOTATE_HAPPENS_AFTER (before_task);
 		SDL_UnlockMutex (before_task->epoch_mutex);
 		return;
 	}
-	uint32_t after_task_index = IndexFromTaskHandle (after);
-	task_t  *after_task = &tasks[after_task_index];
-	assert (before_task->num_dependents < MAX_DEPENDENT_TASKS);
+	task_t *after_task = GetTask (IndexFromTaskHandle (after));
+	if (before_task->num_dependents == before_task->max_dependents)
+	{
+		before_task->max_dependents = q_max (before_task->max_dependents * 2, 16);
+		before_task->dependent_task_handles =
+			(task_handle_t *)Mem_Realloc (before_task->dependent_task_handles, sizeof (task_handle_t) * before_task->max_dependents);
+	}
 	before_task->dependent_task_handles[before_task->num_dependents] = after;
 	before_task->num_dependents += 1;
 	Atomic_IncrementUInt32 (&after_task->remaining_dependencies);
@@ -506,22 +924,451 @@ void Task_AddDependency (task_handle_t before, task_handle_t after)
 /*
 ====================
 Task_Join
+
+Instead of sleeping, the joining thread runs pending tasks until the task completes. A timeout of
+0 only polls, SDL_MUTEX_MAXWAIT waits forever.
 ====================
 */
 qboolean Task_Join (task_handle_t handle, uint32_t timeout)
 {
-	task_t   *task = &tasks[IndexFromTaskHandle (handle)];
-	const int handle_task_epoch = EpochFromTaskHandle (handle);
-	SDL_LockMutex (task->epoch_mutex);
-	while (task->epoch == handle_task_epoch)
+	task_t        *task = GetTask (IndexFromTaskHandle (handle));
+	const uint64_t handle_task_epoch = EpochFromTaskHandle (handle);
+	const qboolean helping = (timeout > 0) && (task->scheduler_mode == SCHEDULER_WORK_STEALING);
+	const Uint32   start_ticks = SDL_GetTicks ();
+	while (Atomic_LoadUInt64 (&task->epoch) == handle_task_epoch)
 	{
-		if (SDL_CondWaitTimeout (task->epoch_condition, task->epoch_mutex, timeout) == SDL_MUTEX_TIMEDOUT)
+		uint32_t task_index;
+		uint32_t trace_flags;
+		if (helping && FindTask (&task_index, &trace_flags, true))
 		{
-			SDL_UnlockMutex (task->epoch_mutex);
-			return false;
+			// Code that must not run inside tasks checks Tasks_IsWorker
+			const qboolean was_worker = is_worker;
+			is_worker = true;
+			Task_Execute (task_index, trace_flags | TRACE_FLAG_HELPED);
+			is_worker = was_worker;
+			continue;
+		}
+
+		uint32_t wait = helping ? HELP_WAIT_MS : timeout;
+		if (timeout != SDL_MUTEX_MAXWAIT)
+		{
+			const Uint32 elapsed = SDL_GetTicks () - start_ticks;
+			if (elapsed >= timeout)
+				return false;
+			wait = q_min (wait, timeout - elapsed);
 		}
+		SDL_LockMutex (task->epoch_mutex);
+		if (Atomic_LoadUInt64 (&task->epoch) == handle_task_epoch)
+			SDL_CondWaitTimeout (task->epoch_condition, task->epoch_mutex, wait);
+		SDL_UnlockMutex (task->epoch_mutex);
 	}
-	SDL_UnlockMutex (task->epoch_mutex);
 	ANNOTATE_HAPPENS_AFTER (task);
 	return true;
 }
+
+/*
+==============================================================================
+
+TRACE
+
+==============================================================================
+*/
+
+/*
+====================
+Tasks_TraceZoneBegin
+====================
+*/
+void Tasks_TraceZoneBegin (const char *name)
+{
+	if (trace_zone_depth < TRACE_MAX_ZONES)
+	{
+		trace_zones[trace_zone_depth].name = name;
+		trace_zones[trace_zone_depth].begin_ticks = Atomic_LoadUInt32 (&trace_active) ? SDL_GetPerformanceCounter () : 0;
+	}
+	++trace_zone_depth;
+}
+
+/*
+====================
+Tasks_TraceZoneEnd
+====================
+*/
+void Tasks_TraceZoneEnd (void)
+{
+	if (trace_zone_depth == 0)
+		return;
+	--trace_zone_depth;
+	if ((trace_zone_depth < TRACE_MAX_ZONES) && (trace_zones[trace_zone_depth].begin_ticks != 0) && Atomic_LoadUInt32 (&trace_active))
+		Trace_AddEvent (trace_zones[trace_zone_depth].name, trace_zones[trace_zone_depth].begin_ticks, SDL_GetPerformanceCounter (), 0, TRACE_FLAG_ZONE);
+}
+
+/*
+====================
+Trace_Write
+
+Chrome trace event format, loads in chrome://tracing and ui.perfetto.dev
+====================
+*/
+static void Trace_Write (void)
+{
+	FILE *f = fopen (trace_filename, "w");
+	if (!f)
+	{
+		Con_Printf ("tasks_trace: couldn't write %s\n", trace_filename);
+		return;
+	}
+
+	const double   ticks_to_us = 1e6 / (double)SDL_GetPerformanceFrequency ();
+	const uint32_t generation = Atomic_LoadUInt32 (&trace_generation);
+	uint32_t       total_events = 0;
+	uint32_t       total_steals = 0;
+	uint32_t       total_dropped = 0;
+	qboolean       first = true;
+	fprintf (f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (int thread_index = 0; thread_index <= num_workers; ++thread_index)
+	{
+		const qboolean main_thread = thread_index == num_workers;
+		fprintf (
+			f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}", first ? "" : ",\n", thread_index,
+			main_thread ? "Main" : "Task_Worker", main_thread ? 0 : thread_index);
+		fprintf (
+			f, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}", thread_index,
+			main_thread ? -1 : thread_index);
+		first = false;
+
+		trace_buffer_t *buffer = trace_buffers[thread_index];
+		if (Atomic_LoadUInt32 (&buffer->generation) != generation)
+			continue;
+		const uint32_t num_events = Atomic_LoadUInt32 (&buffer->num_events);
+		total_events += num_events;
+		total_dropped += Atomic_LoadUInt32 (&buffer->num_dropped);
+		for (uint32_t i = 0; i < num_events; ++i)
+		{
+			const trace_event_t *event = &buffer->events[i];
+			fprintf (
+				f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", event->name,
+				(event->flags & TRACE_FLAG_ZONE) ? "zone" : "task", thread_index, (double)(int64_t)(event->begin_ticks - trace_start_ticks) * ticks_to_us,
+				(double)(event->end_ticks - event->begin_ticks) * ticks_to_us);
+			if (!(event->flags & TRACE_FLAG_ZONE))
+			{
+				const double wait = event->ready_ticks ? (double)(int64_t)(event->begin_ticks - event->ready_ticks) * ticks_to_us : 0.0;
+				fprintf (
+					f, ",\"args\":{\"queue_wait_us\":%.3f,\"stolen\":%d,\"helped\":%d}", wait, (event->flags & TRACE_FLAG_STOLEN) ? 1 : 0,
+					(event->flags & TRACE_FLAG_HELPED) ? 1 : 0);
+				if (event->flags & TRACE_FLAG_STOLEN)
+					++total_steals;
+			}
+			fprintf (f, "}");
+		}
+	}
+	fprintf (f, "\n]}\n");
+	fclose (f);
+
+	Con_Printf ("tasks_trace: wrote %s (%u events, %u steals", trace_filename, total_events, total_steals);
+	if (total_dropped > 0)
+		Con_Printf (", %u dropped", total_dropped);
+	Con_Printf (")\n");
+}
+
+/*
+====================
+Tasks_TraceNewFrame
+
+Called by the main thread at the start of every frame, starts and stops captures on frame boundaries
+====================
+*/
+void Tasks_TraceNewFrame (void)
+{
+	// a longjmp out of the previous frame can leave zones open
+	trace_zone_depth = 0;
+
+	if (trace_frames_pending > 0)
+	{
+		trace_frames_remaining = trace_frames_pending;
+		trace_frames_pending = 0;
+		trace_start_ticks = SDL_GetPerformanceCounter ();
+		Atomic_IncrementUInt32 (&trace_generation);
+		Atomic_StoreUInt32 (&trace_active, 1);
+	}
+	else if (Atomic_LoadUInt32 (&trace_active) && (--trace_frames_remaining == 0))
+	{
+		Atomic_StoreUInt32 (&trace_active, 0);
+		Trace_Write ();
+	}
+}
+
+/*
+====================
+Tasks_Trace_f
+
+tasks_trace [frames] [filename]: records task execution and main thread zones for the next frames
+====================
+*/
+void Tasks_Trace_f (void)
+{
+	if (Atomic_LoadUInt32 (&trace_active) || (trace_frames_pending > 0))
+	{
+		Con_Printf ("tasks_trace: capture already in progress\n");
+		return;
+	}
+
+	const int frames = (Cmd_Argc () > 1) ? atoi (Cmd_Argv (1)) : 10;
+	if (frames <= 0)
+	{
+		Con_Printf ("usage: tasks_trace [frames] [filename]\n");
+		return;
+	}
+	q_snprintf (trace_filename, sizeof (trace_filename), "%s/%s", com_gamedir, (Cmd_Argc () > 2) ? Cmd_Argv (2) : "tasks_trace");
+	COM_AddExtension (trace_filename, ".json", sizeof (trace_filename));
+
+	// never freed, late events from tasks of the previous capture may still be written
+	for (int i = 0; i <= num_workers; ++i)
+	{
+		if (!trace_buffers[i])
+			trace_buffers[i] = (trace_buffer_t *)Mem_Alloc (sizeof (trace_buffer_t));
+	}
+	trace_frames_pending = frames;
+	Con_Printf ("tasks_trace: capturing %d frames\n", frames);
+}
+
+/*
+==============================================================================
+
+BENCHMARK
+
+==============================================================================
+*/
+
+#define BENCHMARK_TREE_DEPTH     12
+#define BENCHMARK_INDEXED_COUNT  (1u << 20)
+#define BENCHMARK_INDEXED_PASSES 16
+#define BENCHMARK_CHAIN_LENGTH   4096
+#define BENCHMARK_WAKEUP_SAMPLES 64
+
+static atomic_uint32_t benchmark_counter;
+static atomic_uint64_t benchmark_start_ticks;
+static uint32_t       *benchmark_data;
+
+/*
+====================
+Benchmark_CountTask
+====================
+*/
+static void Benchmark_CountTask (void *unused)
+{
+	Atomic_IncrementUInt32 (&benchmark_counter);
+}
+
+/*
+====================
+Benchmark_ForkJoinTask
+====================
+*/
+static void Benchmark_ForkJoinTask (void *data)
+{
+	const int depth = *(int *)data;
+	if (depth == 0)
+	{
+		Atomic_IncrementUInt32 (&benchmark_counter);
+		return;
+	}
+	int           child_depth = depth - 1;
+	task_handle_t children[2];
+	for (int i = 0; i < 2; ++i)
+		children[i] = Task_AllocateAssignFuncAndSubmit ("Benchmark_ForkJoinTask", Benchmark_ForkJoinTask, &child_depth, sizeof (child_depth));
+	for (int i = 0; i < 2; ++i)
+		Task_Join (children[i], SDL_MUTEX_MAXWAIT);
+}
+
+/*
+====================
+Benchmark_IndexedTask
+====================
+*/
+static void Benchmark_IndexedTask (int index, void *unused)
+{
+	benchmark_data[index] = (uint32_t)index * 2654435761u;
+}
+
+/*
+====================
+Benchmark_RangedTask
+====================
+*/
+static void Benchmark_RangedTask (int begin, int end, void *unused)
+{
+	for (int index = begin; index < end; ++index)
+		benchmark_data[index] = (uint32_t)index * 2654435761u;
+}
+
+/*
+====================
+Benchmark_WakeupTask
+====================
+*/
+static void Benchmark_WakeupTask (void *unused)
+{
+	Atomic_StoreUInt64 (&benchmark_start_ticks, SDL_GetPerformanceCounter ());
+}
+
+/*
+====================
+Benchmark_DependencyTree
+
+Binary tree in heap layout, every node waits for its two children
+====================
+*/
+static double Benchmark_DependencyTree (void)
+{
+	const int      num_tasks = (1 << BENCHMARK_TREE_DEPTH) - 1;
+	task_handle_t *handles = (task_handle_t *)Mem_Alloc (sizeof (task_handle_t) * num_tasks);
+	const double   start = Sys_DoubleTime ();
+	for (int i = 0; i < num_tasks; ++i)
+		handles[i] = Task_AllocateAndAssignFunc ("Benchmark_CountTask", Benchmark_CountTask, NULL, 0);
+	for (int i = 1; i < num_tasks; ++i)
+		Task_AddDependency (handles[i], handles[(i - 1) / 2]);
+	Tasks_Submit (num_tasks, handles);
+	Task_Join (handles[0], SDL_MUTEX_MAXWAIT);
+	const double elapsed = Sys_DoubleTime () - start;
+	Mem_Free (handles);
+	return elapsed;
+}
+
+/*
+====================
+Benchmark_ForkJoin
+
+Recursive fork/join with nested joins, needs helping joins to not deadlock the pool
+====================
+*/
+static double Benchmark_ForkJoin (void)
+{
+	int          depth = BENCHMARK_TREE_DEPTH - 1;
+	const double start = Sys_DoubleTime ();
+	Task_Join (Task_AllocateAssignFuncAndSubmit ("Benchmark_ForkJoinTask", Benchmark_ForkJoinTask, &depth, sizeof (depth)), SDL_MUTEX_MAXWAIT);
+	return Sys_DoubleTime () - start;
+}
+
+/*
+====================
+Benchmark_Indexed
+====================
+*/
+static double Benchmark_Indexed (void)
+{
+	const double start = Sys_DoubleTime ();
+	for (int i = 0; i < BENCHMARK_INDEXED_PASSES; ++i)
+	{
+		task_handle_t task = Task_AllocateAssignIndexedFuncAndSubmit ("Benchmark_IndexedTask", Benchmark_IndexedTask, BENCHMARK_INDEXED_COUNT, NULL, 0);
+		Task_Join (task, SDL_MUTEX_MAXWAIT);
+	}
+	return Sys_DoubleTime () - start;
+}
+
+/*
+====================
+Benchmark_Ranged
+====================
+*/
+static double Benchmark_Ranged (void)
+{
+	const double start = Sys_DoubleTime ();
+	for (int i = 0; i < BENCHMARK_INDEXED_PASSES; ++i)
+	{
+		task_handle_t task = Task_AllocateAssignRangedFuncAndSubmit ("Benchmark_RangedTask", Benchmark_RangedTask, BENCHMARK_INDEXED_COUNT, 0, NULL, 0);
+		Task_Join (task, SDL_MUTEX_MAXWAIT);
+	}
+	return Sys_DoubleTime () - start;
+}
+
+/*
+====================
+Benchmark_Chain
+====================
+*/
+static double Benchmark_Chain (void)
+{
+	task_handle_t *handles = (task_handle_t *)Mem_Alloc (sizeof (task_handle_t) * BENCHMARK_CHAIN_LENGTH);
+	const double   start = Sys_DoubleTime ();
+	for (int i = 0; i < BENCHMARK_CHAIN_LENGTH; ++i)
+	{
+		handles[i] = Task_AllocateAndAssignFunc ("Benchmark_CountTask", Benchmark_CountTask, NULL, 0);
+		if (i > 0)
+			Task_AddDependency (handles[i - 1], handles[i]);
+	}
+	Tasks_Submit (BENCHMARK_CHAIN_LENGTH, handles);
+	Task_Join (handles[BENCHMARK_CHAIN_LENGTH - 1], SDL_MUTEX_MAXWAIT);
+	const double elapsed = Sys_DoubleTime () - start;
+	Mem_Free (handles);
+	return elapsed;
+}
+
+/*
+====================
+Benchmark_Wakeup
+
+Time from submitting a task to an idle pool until a worker starts running it. The main
+thread spins instead of joining so that it doesn't pick up the task itself.
+====================
+*/
+static void Benchmark_Wakeup (double *average, double *maximum)
+{
+	const double frequency = (double)SDL_GetPerformanceFrequency ();
+	*average = 0.0;
+	*maximum = 0.0;
+	for (int i = 0; i < BENCHMARK_WAKEUP_SAMPLES; ++i)
+	{
+		SDL_Delay (2);
+		Atomic_StoreUInt64 (&benchmark_start_ticks, 0);
+		const uint64_t      submit_ticks = SDL_GetPerformanceCounter ();
+		const task_handle_t handle = Task_AllocateAssignFuncAndSubmit ("Benchmark_WakeupTask", Benchmark_WakeupTask, NULL, 0);
+		uint64_t            start_ticks;
+		while ((start_ticks = Atomic_LoadUInt64 (&benchmark_start_ticks)) == 0)
+			SpinPause ();
+		Task_Join (handle, SDL_MUTEX_MAXWAIT);
+		const double latency = (double)(start_ticks - submit_ticks) / frequency;
+		*average += latency / BENCHMARK_WAKEUP_SAMPLES;
+		*maximum = q_max (*maximum, latency);
+	}
+}
+
+/*
+====================
+Tasks_Benchmark_f
+
+tasks_benchmark: compares the work-stealing scheduler against a single shared queue with blocking joins.
+Only the benchmark's own tasks are scheduled the shared queue way, anything else in flight is unaffected.
+====================
+*/
+void Tasks_Benchmark_f (void)
+{
+	static const char *mode_names[] = {"work stealing", "shared queue"};
+
+	benchmark_data = (uint32_t *)Mem_Alloc (sizeof (uint32_t) * BENCHMARK_INDEXED_COUNT);
+	Con_Printf ("%i workers\n", num_workers);
+	for (int mode = SCHEDULER_WORK_STEALING; mode <= SCHEDULER_SHARED_QUEUE; ++mode)
+	{
+		double wakeup_average, wakeup_maximum;
+		allocation_mode = mode;
+		Atomic_StoreUInt32 (&benchmark_counter, 0);
+		const double tree_time = Benchmark_DependencyTree ();
+		const double indexed_time = Benchmark_Indexed ();
+		const double ranged_time = Benchmark_Ranged ();
+		const double chain_time = Benchmark_Chain ();
+		Benchmark_Wakeup (&wakeup_average, &wakeup_maximum);
+
+		Con_Printf ("%s:\n", mode_names[mode]);
+		Con_Printf ("  dependency tree : %8.3f ms (%i tasks)\n", tree_time * 1000.0, (1 << BENCHMARK_TREE_DEPTH) - 1);
+		if (mode == SCHEDULER_WORK_STEALING)
+			Con_Printf ("  fork/join       : %8.3f ms (%i tasks)\n", Benchmark_ForkJoin () * 1000.0, (1 << BENCHMARK_TREE_DEPTH) - 1);
+		else
+			Con_Printf ("  fork/join       :      n/a (nested blocking joins can deadlock)\n");
+		Con_Printf ("  indexed loop    : %8.1f Mitems/s\n", (double)BENCHMARK_INDEXED_COUNT * BENCHMARK_INDEXED_PASSES / q_max (indexed_time, 1e-6) / 1e6);
+		Con_Printf ("  ranged loop     : %8.1f Mitems/s\n", (double)BENCHMARK_INDEXED_COUNT * BENCHMARK_INDEXED_PASSES / q_max (ranged_time, 1e-6) / 1e6);
+		Con_Printf ("  dependency chain: %8.3f us per task\n", chain_time * 1e6 / BENCHMARK_CHAIN_LENGTH);
+		Con_Printf ("  wake-up latency : %8.1f us average, %.1f us max\n", wakeup_average * 1e6, wakeup_maximum * 1e6);
+	}
+	allocation_mode = SCHEDULER_WORK_STEALING;
+	SAFE_FREE (benchmark_data);
+}
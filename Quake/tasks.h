@@ -31,46 +31,74 @@
 typedef uint64_t task_handle_t;
 typedef void (*task_func_t) (void *);
 typedef void (*task_indexed_func_t) (int, void *);
+typedef void (*task_ranged_func_t) (int, int, void *); // [begin, end)
 
 void          Tasks_Init (void);
 int           Tasks_NumWorkers (void);
 qboolean      Tasks_IsWorker (void);
-task_handle_t Task_Allocate (void);
+task_handle_t Task_Allocate (const char *name);
 void          Task_AssignFunc (task_handle_t handle, task_func_t func, void *payload, size_t payload_size);
 void          Task_AssignIndexedFunc (task_handle_t handle, task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size);
+void          Task_AssignRangedFunc (task_handle_t handle, task_ranged_func_t func, uint32_t limit, uint32_t grain_size, void *payload, size_t payload_size);
+void          Task_SetWorkerOnly (task_handle_t handle);
 void          Task_Submit (task_handle_t handle);
 void          Tasks_Submit (int num_handles, task_handle_t *handles);
 void          Task_AddDependency (task_handle_t before, task_handle_t after);
 qboolean      Task_Join (task_handle_t handle, uint32_t timeout);
+void          Tasks_Benchmark_f (void);
 
-static inline task_handle_t Task_AllocateAndAssignFunc (task_func_t func, void *payload, size_t payload_size)
+// Instrumentation, names have to be string literals or otherwise outlive the capture
+void Tasks_TraceZoneBegin (const char *name);
+void Tasks_TraceZoneEnd (void);
+void Tasks_TraceNewFrame (void);
+void Tasks_Trace_f (void);
+
+static inline task_handle_t Task_AllocateAndAssignFunc (const char *name, task_func_t func, void *payload, size_t payload_size)
 {
-	task_handle_t handle = Task_Allocate ();
+	task_handle_t handle = Task_Allocate (name);
 	Task_AssignFunc (handle, func, payload, payload_size);
 	return handle;
 }
 
-static inline task_handle_t Task_AllocateAndAssignIndexedFunc (task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size)
+static inline task_handle_t Task_AllocateAndAssignIndexedFunc (const char *name, task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size)
 {
-	task_handle_t handle = Task_Allocate ();
+	task_handle_t handle = Task_Allocate (name);
 	Task_AssignIndexedFunc (handle, func, limit, payload, payload_size);
 	return handle;
 }
 
-static inline task_handle_t Task_AllocateAssignFuncAndSubmit (task_func_t func, void *payload, size_t payload_size)
+static inline task_handle_t Task_AllocateAssignFuncAndSubmit (const char *name, task_func_t func, void *payload, size_t payload_size)
 {
-	task_handle_t handle = Task_Allocate ();
+	task_handle_t handle = Task_Allocate (name);
 	Task_AssignFunc (handle, func, payload, payload_size);
 	Task_Submit (handle);
 	return handle;
 }
 
-static inline task_handle_t Task_AllocateAssignIndexedFuncAndSubmit (task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size)
+static inline task_handle_t Task_AllocateAssignIndexedFuncAndSubmit (
+	const char *name, task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size)
 {
-	task_handle_t handle = Task_Allocate ();
+	task_handle_t handle = Task_Allocate (name);
 	Task_AssignIndexedFunc (handle, func, limit, payload, payload_size);
 	Task_Submit (handle);
 	return handle;
 }
 
+static inline task_handle_t Task_AllocateAndAssignRangedFunc (
+	const char *name, task_ranged_func_t func, uint32_t limit, uint32_t grain_size, void *payload, size_t payload_size)
+{
+	task_handle_t handle = Task_Allocate (name);
+	Task_AssignRangedFunc (handle, func, limit, grain_size, payload, payload_size);
+	return handle;
+}
+
+static inline task_handle_t Task_AllocateAssignRangedFuncAndSubmit (
+	const char *name, task_ranged_func_t func, uint32_t limit, uint32_t grain_size, void *payload, size_t payload_size)
+{
+	task_handle_t handle = Task_Allocate (name);
+	Task_AssignRangedFunc (handle, func, limit, grain_size, payload, payload_size);
+	Task_Submit (handle);
+	return handle;
+}
+
 #endif
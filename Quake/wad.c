@@ -25,7 +25,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 int         wad_numlumps;
 lumpinfo_t *wad_lumps;
-byte       *wad_base = NULL;
+const byte *wad_base = NULL;
+
+static fileview_t wad_view;
 
 void SwapPic (qpic_t *pic);
 
@@ -67,28 +69,34 @@ W_LoadWadFile
 */
 void W_LoadWadFile (void) // johnfitz -- filename is now hard-coded for honesty
 {
-	lumpinfo_t *lump_p;
-	wadinfo_t  *header;
-	int         i;
-	int         infotableofs;
-	const char *filename = WADFILENAME;
+	lumpinfo_t      *lump_p;
+	const wadinfo_t *header;
+	int              i;
+	int              infotableofs;
+	const char      *filename = WADFILENAME;
 
-	// johnfitz -- modified to use malloc
-	// TODO: use cache_alloc
+	// the wad stays mapped, only the lump directory is copied for the fixups below
 	if (wad_base)
-		Mem_Free (wad_base);
-	wad_base = COM_LoadFile (filename, NULL);
-	if (!wad_base)
+	{
+		COM_UnmapFile (&wad_view);
+		Mem_Free (wad_lumps);
+		wad_lumps = NULL;
+		wad_base = NULL;
+	}
+	if (!COM_MapFile (filename, NULL, &wad_view))
 		Sys_Error (
 			"W_LoadWadFile: couldn't load %s\n\n"
 			"Basedir is: %s\n\n"
 			"Check that this has an " GAMENAME " subdirectory containing pak0.pak and pak1.pak, "
 			"or use the -basedir command-line option to specify another directory.",
 			filename, com_basedir);
+	wad_base = wad_view.data;
+	const int wad_size = wad_view.size;
 
-	header = (wadinfo_t *)wad_base;
+	header = (const wadinfo_t *)wad_base;
 
-	if (header->identification[0] != 'W' || header->identification[1] != 'A' || header->identification[2] != 'D' || header->identification[3] != '2')
+	if (wad_size < (int)sizeof (wadinfo_t) || header->identification[0] != 'W' || header->identification[1] != 'A' || header->identification[2] != 'D' ||
+	    header->identification[3] != '2')
 	{
 		Con_Printf ("Wad file %s doesn't have WAD2 id\n", filename);
 		wad_numlumps = 0;
@@ -99,24 +107,25 @@ void W_LoadWadFile (void) // johnfitz -- filename is now hard-coded for honesty
 		wad_numlumps = LittleLong (header->numlumps);
 		infotableofs = LittleLong (header->infotableofs);
 	}
-	wad_lumps = (lumpinfo_t *)(wad_base + infotableofs);
-	if (infotableofs < 0 || infotableofs + wad_numlumps * sizeof (lumpinfo_t) > (size_t)com_filesize)
+	if (infotableofs < 0 || wad_numlumps < 0 || infotableofs + wad_numlumps * sizeof (lumpinfo_t) > (size_t)wad_size)
 	{
 		Con_Printf ("Wad file %s header extends beyond end of file\n", filename);
 		wad_numlumps = 0;
 	}
+	wad_lumps = (lumpinfo_t *)Mem_Alloc (q_max (wad_numlumps, 1) * sizeof (lumpinfo_t));
+	memcpy (wad_lumps, wad_base + infotableofs, wad_numlumps * sizeof (lumpinfo_t));
 
 	for (i = 0, lump_p = wad_lumps; i < wad_numlumps; i++, lump_p++)
 	{
 		lump_p->filepos = LittleLong (lump_p->filepos);
 		lump_p->size = LittleLong (lump_p->size);
-		if (lump_p->filepos + lump_p->size > com_filesize && !(lump_p->filepos + LittleLong (lump_p->disksize) > com_filesize))
+		if (lump_p->filepos + lump_p->size > wad_size && !(lump_p->filepos + LittleLong (lump_p->disksize) > wad_size))
 			lump_p->size = LittleLong (lump_p->disksize);
-		if (lump_p->filepos < 0 || lump_p->size < 0 || lump_p->filepos + lump_p->size > com_filesize)
+		if (lump_p->filepos < 0 || lump_p->size < 0 || lump_p->filepos + lump_p->size > wad_size)
 		{
-			if (lump_p->filepos > com_filesize || lump_p->size < 0)
+			if (lump_p->filepos > wad_size || lump_p->size < 0)
 			{
-				Con_Printf ("Wad file %s lump \"%.16s\" begins %u bytes beyond end of wad\n", filename, lump_p->name, lump_p->filepos - com_filesize);
+				Con_Printf ("Wad file %s lump \"%.16s\" begins %u bytes beyond end of wad\n", filename, lump_p->name, lump_p->filepos - wad_size);
 				lump_p->filepos = 0;
 				lump_p->size = q_max (0, lump_p->size - lump_p->filepos);
 			}
@@ -124,13 +133,11 @@ void W_LoadWadFile (void) // johnfitz -- filename is now hard-coded for honesty
 			{
 				Con_Printf (
 					"Wad file %s lump \"%.16s\" extends %u bytes beyond end of wad (lump size: %u)\n", filename, lump_p->name,
-					(lump_p->filepos + lump_p->size) - com_filesize, lump_p->size);
+					(lump_p->filepos + lump_p->size) - wad_size, lump_p->size);
 				lump_p->size = q_max (0, lump_p->size - lump_p->filepos);
 			}
 		}
 		W_CleanupName (lump_p->name, lump_p->name); // CAUTION: in-place editing!!! The endian fixups too.
-		if (lump_p->type == TYP_QPIC)
-			SwapPic ((qpic_t *)(wad_base + lump_p->filepos));
 	}
 }
 
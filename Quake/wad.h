@@ -68,7 +68,7 @@ typedef struct
 
 extern int         wad_numlumps;
 extern lumpinfo_t *wad_lumps;
-extern byte       *wad_base;
+extern const byte *wad_base;
 
 void  W_LoadWadFile (void); // johnfitz -- filename is now hard-coded for honesty
 void  W_CleanupName (const char *in, char *out);
@@ -54,9 +54,10 @@ HULL BOXES
 ===============================================================================
 */
 
-static hull_t      box_hull;
-static mclipnode_t box_clipnodes[6]; // johnfitz -- was dclipnode_t
-static mplane_t    box_planes[6];
+// per thread, server instances and csqc run their physics on tasks
+static THREAD_LOCAL hull_t      box_hull;
+static THREAD_LOCAL mclipnode_t box_clipnodes[6]; // johnfitz -- was dclipnode_t
+static THREAD_LOCAL mplane_t    box_planes[6];
 
 /*
 ===================
@@ -103,6 +104,9 @@ BSP trees instead of being compared directly.
 */
 hull_t *SV_HullForBox (vec3_t mins, vec3_t maxs)
 {
+	if (!box_hull.clipnodes)
+		SV_InitBoxHull (); // first use on this thread
+
 	box_planes[0].dist = maxs[0];
 	box_planes[1].dist = mins[0];
 	box_planes[2].dist = maxs[1];
@@ -1064,13 +1068,66 @@ static void SV_ClipToLinks (areanode_t *node, moveclip_t *clip)
 		SV_ClipToLinks (node->children[1], clip);
 }
 
+// copies of the solid network entities for csqc running on a task while CL_ReadFromServer updates cl.entities
+static entity_t *world_netsnapshot;
+static int       world_numnetsnapshot;
+static int       world_maxnetsnapshot;
+static qboolean  world_usenetsnapshot;
+
+/*
+==================
+World_SnapshotNetwork
+
+Until World_ReleaseNetworkSnapshot, csqc traces clip against the network entities as they are now
+==================
+*/
+void World_SnapshotNetwork (void)
+{
+	int i;
+
+	world_numnetsnapshot = 0;
+	for (i = 0; i < cl.numactiveentities; i++)
+	{
+		entity_t *ent = &cl.entities[cl.activeentities[i]];
+
+		if (!ent->model || ent->netstate.solidsize == ES_SOLID_NOT)
+			continue;
+
+		if (world_numnetsnapshot == world_maxnetsnapshot)
+		{
+			world_maxnetsnapshot = q_max (64, world_maxnetsnapshot * 2);
+			world_netsnapshot = Mem_Realloc (world_netsnapshot, world_maxnetsnapshot * sizeof (entity_t));
+		}
+		memcpy (&world_netsnapshot[world_numnetsnapshot++], ent, sizeof (entity_t));
+	}
+	world_usenetsnapshot = true;
+}
+
+/*
+==================
+World_ReleaseNetworkSnapshot
+==================
+*/
+void World_ReleaseNetworkSnapshot (void)
+{
+	world_usenetsnapshot = false;
+}
+
 static void World_ClipToNetwork (moveclip_t *clip)
 {
 	entity_t *touch;
 	trace_t   trace;
 	int       i;
+	entity_t *ents = cl.entities + 1;
+	int       numents = cl.num_entities - 1;
+
+	if (world_usenetsnapshot)
+	{
+		ents = world_netsnapshot;
+		numents = world_numnetsnapshot;
+	}
 
-	for (i = 1, touch = cl.entities + 1; i < cl.num_entities; i++, touch++)
+	for (i = 0, touch = ents; i < numents; i++, touch++)
 	{
 		if (!touch->model)
 			continue;
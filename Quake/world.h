@@ -89,4 +89,7 @@ trace_t SV_Move (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int type, e
 
 qboolean SV_RecursiveHullCheck (hull_t *hull, vec3_t p1, vec3_t p2, trace_t *trace, unsigned int hitcontents);
 
+void World_SnapshotNetwork (void);
+void World_ReleaseNetworkSnapshot (void);
+
 #endif /* _QUAKE_WORLD_H */